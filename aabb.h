@@ -0,0 +1,63 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <algorithm>
+#include "vec2.h"
+
+/**
+ * @brief Axis-aligned bounding box.
+ *
+ * Used for regions of the world (kill volumes, world bounds) and as the
+ * bounding volume of the acceleration structures.
+ */
+struct AABB {
+    Vec2 min = Vec2(0, 0);  ///< Lower corner of the box.
+    Vec2 max = Vec2(0, 0);  ///< Upper corner of the box.
+
+    /**
+     * @brief Tells whether a point lies inside the box (boundary included).
+     *
+     * @param p The point to test.
+     * @return True if `p` is inside the box.
+     */
+    bool contains(const Vec2& p) const {
+        return p.getx() >= min.getx() && p.getx() <= max.getx()
+            && p.gety() >= min.gety() && p.gety() <= max.gety();
+    }
+
+    /**
+     * @brief Tells whether two boxes overlap.
+     *
+     * @param other The other box.
+     * @return True if the boxes share at least one point.
+     */
+    bool overlaps(const AABB& other) const {
+        return min.getx() <= other.max.getx() && max.getx() >= other.min.getx()
+            && min.gety() <= other.max.gety() && max.gety() >= other.min.gety();
+    }
+
+    /**
+     * @brief Computes the smallest box containing this box and another one.
+     *
+     * @param other The other box.
+     * @return The union of both boxes.
+     */
+    AABB merged(const AABB& other) const {
+        return AABB{Vec2(std::min(min.getx(), other.min.getx()), std::min(min.gety(), other.min.gety())),
+                    Vec2(std::max(max.getx(), other.max.getx()), std::max(max.gety(), other.max.gety()))};
+    }
+
+    /**
+     * @brief Builds the bounding box of a disc.
+     *
+     * @param center Center of the disc.
+     * @param radius Radius of the disc.
+     * @return The bounding box of the disc.
+     */
+    static AABB around(const Vec2& center, float radius) {
+        return AABB{Vec2(center.getx() - radius, center.gety() - radius),
+                    Vec2(center.getx() + radius, center.gety() + radius)};
+    }
+};
+
+#endif // AABB_H
@@ -0,0 +1,26 @@
+#include "allocationcounter.h"
+#include <atomic>
+
+namespace {
+//Initialisés statiquement : les allocations faites avant main sont comptées aussi
+std::atomic<size_t> allocationTotal{0};
+std::atomic<size_t> byteTotal{0};
+std::atomic<bool> hooked{false};
+}
+
+void AllocationCounter::record(size_t bytes) noexcept{
+    allocationTotal.fetch_add(1, std::memory_order_relaxed);
+    byteTotal.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+AllocationCount AllocationCounter::get() noexcept{
+    return AllocationCount{allocationTotal.load(std::memory_order_relaxed), byteTotal.load(std::memory_order_relaxed)};
+}
+
+void AllocationCounter::markHooked() noexcept{
+    hooked.store(true);
+}
+
+bool AllocationCounter::isHooked() noexcept{
+    return hooked.load();
+}
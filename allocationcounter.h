@@ -0,0 +1,61 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+/**
+ * @brief Number and total size of heap allocations.
+ */
+struct AllocationCount {
+    size_t allocations = 0;  ///< Number of allocations.
+    size_t bytes = 0;        ///< Bytes requested by these allocations.
+
+    /**
+     * @brief Gets the allocations made between two counts.
+     *
+     * @param earlier The count taken first.
+     * @return The difference of the two counts.
+     */
+    AllocationCount since(const AllocationCount& earlier) const {
+        return AllocationCount{allocations - earlier.allocations, bytes - earlier.bytes};
+    }
+};
+
+/**
+ * @brief Process-wide counter of the heap allocations.
+ *
+ * The counter is fed by the replacements of the global `operator new` in
+ * `allocationhooks.cpp`, which are only linked into the executables that
+ * check their allocations (the benchmarks). Elsewhere `isHooked` is false
+ * and the counts stay at zero.
+ */
+class AllocationCounter {
+public:
+    /**
+     * @brief Counts one allocation. Called by the allocation hooks, from any thread.
+     *
+     * @param bytes Size of the allocation.
+     */
+    static void record(size_t bytes) noexcept;
+
+    /**
+     * @brief Gets the allocations counted since the start of the process.
+     *
+     * @return The count.
+     */
+    static AllocationCount get() noexcept;
+
+    /**
+     * @brief Declares that the allocation hooks are linked. Called once by the hooks, before `main`.
+     */
+    static void markHooked() noexcept;
+
+    /**
+     * @brief Tells whether the allocation hooks are linked into the executable.
+     *
+     * @return True if the counts are meaningful.
+     */
+    static bool isHooked() noexcept;
+};
+
+#endif // ALLOCATIONCOUNTER_H
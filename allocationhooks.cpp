@@ -0,0 +1,103 @@
+/**
+ * @file allocationhooks.cpp
+ * @brief Replacements of the global allocation functions feeding `AllocationCounter`.
+ *
+ * Only linked into the executables that check their allocations: replacing
+ * the global `operator new` affects the whole program.
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include "allocationcounter.h"
+
+namespace {
+
+//Initialisation dynamique : le compteur sait avant main que les allocations sont comptées
+const bool hooked = (AllocationCounter::markHooked(), true);
+
+void* allocate(std::size_t size){
+    AllocationCounter::record(size);
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment){
+    AllocationCounter::record(size);
+    //aligned_alloc exige une taille multiple de l'alignement
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+    void* p = std::aligned_alloc(align, rounded);
+    if (p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+}
+
+void* operator new(std::size_t size){
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size){
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept{
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept{
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment){
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment){
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept{
+    std::free(p);
+}
@@ -0,0 +1,1057 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "allocationcounter.h"
+#include "context.h"
+#include "emitter.h"
+#include "ensemble.h"
+#include "forcefields.h"
+#include "frameexporter.h"
+#include "plancollider.h"
+#include "polygoncollider.h"
+#include "segmentcollider.h"
+#include "slabdomain.h"
+#include "spatialgrid.h"
+#include "spherecollider.h"
+#include "tiledworld.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+/**
+ * @file benchmark.cpp
+ * @brief Headless benchmarks of the simulation.
+ *
+ * Usage: `Position-based-dynamic-bench <scenario> [particles] [steps]`.
+ * For the `emitters` scenario, `particles` is the emission rate (particles/s).
+ * The `export` scenario writes its frames under `export/` in the working directory.
+ * The `ensemble` scenario accepts a sweep description file as fourth argument
+ * (see `ParameterSweep`) and writes `ensemble.csv` in the working directory.
+ * The `distributed` scenario accepts the number of processes as fourth argument.
+ * The `memory` scenario reports the memory used per particle and the peak
+ * resident set size, and is best run alone in its process.
+ * The `tiles` scenario pages its world to `tiles.page` in the working directory.
+ * The `materials` scenario compares how fast a layer of particles settles on a slope with and without friction.
+ * The `kinematic` scenario pushes a pile with a wall, teleported then moved as a kinematic collider.
+ * The `broadphase` scenario times the rebuilt and the incremental broadphase grids for several fractions of moving particles.
+ * The `substeps` scenario compares how well substeps and solver iterations keep stacks at rest, and their cost.
+ * The `allocations` scenario counts the allocations of each stage of a step and exits with 1 if the steady state allocates.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Fills a context with a granular scene: a box of small particles falling on the example colliders.
+ *
+ * @param context The context to fill (it is cleared first).
+ * @param count Number of particles.
+ * @param debrisFilter Collision filter given to every other particle.
+ */
+void buildGranularScene(Context& context, size_t count, const CollisionFilter& debrisFilter = CollisionFilter()){
+    context.clear();
+    context.addCollider(std::make_unique<PlanCollider>(Vec2(300, 400), Vec2(0, -1)));
+    context.addCollider(std::make_unique<PlanCollider>(Vec2(0, 300), Vec2(1, -1)));
+    context.addCollider(std::make_unique<SphereCollider>(Vec2(600, 400), 100));
+    context.addCollider(std::make_unique<SphereCollider>(Vec2(500, 200), 30));
+
+    const float radius = 2;
+    const float spacing = 2 * radius + 1;
+    const size_t columns = 120;
+    for (size_t i = 0; i < count; ++i){
+        float x = 100 + (i % columns) * spacing;
+        float y = -static_cast<float>(i / columns) * spacing;
+        Particle particle(Vec2(x, y), Vec2(0, 0), radius, 1);
+        if (i % 2 == 1){
+            particle.changeFilter(debrisFilter);
+        }
+        context.addParticle(std::move(particle));
+    }
+}
+
+/**
+ * @brief Runs `steps` steps of a context.
+ *
+ * @return The mean duration of a step, in milliseconds.
+ */
+double timeSteps(Context& context, int steps){
+    auto start = Clock::now();
+    for (int s = 0; s < steps; ++s){
+        context.updatePhysicalSystem(context.getConfig().stepDuration);
+    }
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    return elapsed.count() / steps;
+}
+
+/**
+ * @brief Measures the step duration of the granular scene from 1 to N threads.
+ */
+void runScaling(size_t count, int steps){
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "scaling: " << count << " particles, " << steps << " steps\n";
+    std::cout << "threads   ms/step   speedup\n";
+    double reference = 0;
+    for (unsigned threads = 1; threads <= maxThreads; ++threads){
+        Context context;
+        context.setThreadCount(threads);
+        buildGranularScene(context, count);
+        timeSteps(context, 5); // échauffement
+        double ms = timeSteps(context, steps);
+        if (threads == 1){
+            reference = ms;
+        }
+        std::cout << std::setw(7) << threads << std::setw(10) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(2) << reference / ms << "\n";
+    }
+}
+
+/**
+ * @brief Measures the worst step of a scene fed by emitters injecting `rate` particles per second.
+ */
+void runEmitters(size_t rate, int steps){
+    Context context;
+    context.clear();
+    context.addCollider(std::make_unique<PlanCollider>(Vec2(300, 400), Vec2(0, -1)));
+    EmissionSettings settings;
+    settings.rate = static_cast<float>(rate);
+    settings.velocity = Vec2(20, 0);
+    settings.spread = 0.5f;
+    settings.speedVariation = 0.2f;
+    settings.lifetime = 2;
+    settings.radius = 2;
+    context.addEmitter(std::make_unique<AreaEmitter>(Vec2(0, -200), Vec2(600, 0), settings, 1));
+
+    std::cout << "emitters: " << rate << " particles/s, " << steps << " steps\n";
+    double worst = 0;
+    double total = 0;
+    for (int s = 0; s < steps; ++s){
+        auto start = Clock::now();
+        context.updatePhysicalSystem(context.getConfig().stepDuration);
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        worst = std::max(worst, elapsed.count());
+        total += elapsed.count();
+    }
+    std::cout << "particles " << context.getAliveParticleCount() << ", mean " << std::fixed << std::setprecision(3)
+              << total / steps << " ms/step, worst " << worst << " ms/step\n";
+}
+
+/**
+ * @brief Compares the exact collider tests with the baked signed-distance grid on a scene with many obstacles.
+ */
+void runColliders(size_t count, int steps){
+    std::cout << "colliders: " << count << " particles, 400 spheres, " << steps << " steps\n";
+    for (bool baked: {false, true}){
+        Context context;
+        buildGranularScene(context, count);
+        for (int k = 0; k < 400; ++k){
+            context.addCollider(std::make_unique<SphereCollider>(Vec2(50 + (k % 40) * 20.0f, 150 + (k / 40) * 20.0f), 4));
+        }
+        if (baked){
+            context.bakeStaticColliders(AABB{Vec2(-200, -1500), Vec2(1000, 600)}, 2, 16);
+        }
+        timeSteps(context, 5);
+        std::cout << (baked ? "baked   " : "exact   ") << std::fixed << std::setprecision(3)
+                  << timeSteps(context, steps) << " ms/step\n";
+    }
+}
+
+
+/**
+ * @brief Times a pinball-like table whose walls are made of thousands of edges,
+ *        either as one polygon chain or as individual segment colliders.
+ */
+void runPolygons(size_t count, int steps){
+    const int edgeCount = 4000;
+    std::cout << "polygons: " << count << " particles, " << edgeCount << " edges, " << steps << " steps\n";
+    //Paroi en dents de scie sous la boîte de particules, plus un obstacle concave plein
+    std::vector<Vec2> wall;
+    for (int k = 0; k <= edgeCount; ++k){
+        wall.emplace_back(-100 + k * 0.3f, 500 + (k % 2) * 2.0f);
+    }
+    std::vector<Vec2> star;
+    for (int k = 0; k < 40; ++k){
+        float angle = k * 6.2831853f / 40;
+        float r = k % 2 == 0 ? 60.0f : 25.0f;
+        star.emplace_back(400 + r * std::cos(angle), 300 + r * std::sin(angle));
+    }
+    for (bool chain: {true, false}){
+        Context context;
+        buildGranularScene(context, count);
+        if (chain){
+            context.addCollider(std::make_unique<PolygonCollider>(wall, false));
+        } else {
+            for (int k = 0; k < edgeCount; ++k){
+                context.addCollider(std::make_unique<SegmentCollider>(wall[k], wall[k + 1]));
+            }
+        }
+        context.addCollider(std::make_unique<PolygonCollider>(star));
+        timeSteps(context, 5);
+        std::cout << (chain ? "chain    " : "segments ") << std::fixed << std::setprecision(3)
+                  << timeSteps(context, steps) << " ms/step\n";
+    }
+}
+
+
+/**
+ * @brief Compares the granular scene with and without a debris layer whose particles ignore each other.
+ */
+void runLayers(size_t count, int steps){
+    std::cout << "layers: " << count << " particles, " << steps << " steps\n";
+    //Les débris (couche 2) touchent les colliders et les autres particules, mais pas les autres débris
+    CollisionFilter debris{2, ~2u};
+    for (bool filtered: {false, true}){
+        Context context;
+        buildGranularScene(context, count, filtered ? debris : CollisionFilter());
+        timeSteps(context, 5);
+        double duration = timeSteps(context, steps);
+        std::cout << (filtered ? "debris   " : "all      ") << std::fixed << std::setprecision(3)
+                  << duration << " ms/step, " << context.getStepStats().skippedPairTests
+                  << " tests skipped in the last step\n";
+    }
+}
+
+
+/**
+ * @brief Times the stepping kernels compiled for different configurations of the granular scene.
+ */
+void runConfig(size_t count, int steps){
+    std::cout << "config: " << count << " particles, " << steps << " steps\n";
+    struct Variant { const char* name; bool clampSpeed; bool particleCollisions; bool drag; };
+    const Variant variants[] = {
+        {"default      ", true, true, false},
+        {"no clamp     ", false, true, false},
+        {"no collisions", true, false, false},
+        {"drag field   ", true, true, true},
+    };
+    for (const Variant& variant: variants){
+        Context context;
+        buildGranularScene(context, count);
+        SimulationConfig config = context.getConfig();
+        config.clampSpeed = variant.clampSpeed;
+        config.particleCollisions = variant.particleCollisions;
+        context.setConfig(config);
+        if (variant.drag){
+            context.addForceField(std::make_unique<DragField>(0.1f));
+        }
+        timeSteps(context, 5);
+        std::cout << variant.name << " " << std::fixed << std::setprecision(3) << timeSteps(context, steps) << " ms/step\n";
+    }
+}
+
+
+/**
+ * @brief Folds the bits of a scalar into a hash, to compare runs bit for bit.
+ */
+template <typename T>
+uint64_t hashScalar(uint64_t hash, T value){
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (unsigned char byte: bytes){
+        hash = (hash ^ byte) * 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Integrates free particles bouncing in a box and pulled towards its center, with `Vec2T<T>`.
+ *
+ * @param hash Receives a hash of the final positions.
+ * @return The mean duration of a step, in milliseconds.
+ */
+template <typename T>
+double runScalarKernel(size_t count, int steps, uint64_t& hash){
+    using V = Vec2T<T>;
+    std::vector<V> positions;
+    std::vector<V> velocities;
+    positions.reserve(count);
+    velocities.reserve(count);
+    for (size_t i = 0; i < count; ++i){
+        positions.emplace_back(T(10 + (i % 97) * 0.8f), T(10 + (i % 89) * 0.9f));
+        velocities.emplace_back(T((i % 7) * 0.5f - 1.5f), T(0));
+    }
+    const T dt = T(0.01f);
+    const T invDt = T(100);
+    const T low = T(1);
+    const T high = T(99);
+    const T pull = T(2);
+    const V gravity(T(0), T(9.8f));
+    const V center(T(50), T(50));
+
+    auto start = Clock::now();
+    for (int s = 0; s < steps; ++s){
+        for (size_t i = 0; i < count; ++i){
+            //Attraction vers le centre, atténuée par la distance (une racine par particule)
+            V toCenter = center - positions[i];
+            V acceleration = gravity + toCenter * (pull / (toCenter.norm() + T(1)));
+            V velocity = velocities[i] + acceleration * dt;
+            V expected = positions[i] + velocity * dt;
+            expected.setx(std::min(std::max(expected.getx(), low), high));
+            expected.sety(std::min(std::max(expected.gety(), low), high));
+            velocities[i] = (expected - positions[i]) * invDt;
+            positions[i] = expected;
+        }
+    }
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+    hash = 14695981039346656037ull;
+    for (const V& p: positions){
+        hash = hashScalar(hashScalar(hash, p.getx()), p.gety());
+    }
+    return elapsed.count() / steps;
+}
+
+/**
+ * @brief Compares the throughput of the float, double and fixed-point vectors.
+ */
+void runScalars(size_t count, int steps){
+    std::cout << "scalars: " << count << " particles, " << steps << " steps\n";
+    uint64_t hash = 0;
+    double duration = runScalarKernel<float>(count, steps, hash);
+    std::cout << "float    " << std::fixed << std::setprecision(3) << duration << " ms/step, hash " << std::hex << hash << std::dec << "\n";
+    duration = runScalarKernel<double>(count, steps, hash);
+    std::cout << "double   " << duration << " ms/step, hash " << std::hex << hash << std::dec << "\n";
+    duration = runScalarKernel<Fixed>(count, steps, hash);
+    std::cout << "fixed    " << duration << " ms/step, hash " << std::hex << hash << std::dec
+              << " (identical on every platform)\n";
+}
+
+
+/**
+ * @brief Runs the granular scene while exporting every other frame, in each format.
+ *
+ * @return The mean duration of a step, in milliseconds, including the rendering
+ *         and the waits for a free buffer.
+ */
+double timeExport(size_t count, int steps, ExportSettings::Format format, const char* directory){
+    Context context;
+    buildGranularScene(context, count);
+    ExportSettings settings;
+    settings.directory = directory;
+    settings.format = format;
+    settings.view = AABB{Vec2(0, -200), Vec2(800, 400)};
+    settings.every = 2;
+    double duration;
+    ExportStats stats;
+    {
+        FrameExporter exporter(settings);
+        auto start = Clock::now();
+        for (int s = 0; s < steps; ++s){
+            context.updatePhysicalSystem(context.getConfig().stepDuration);
+            exporter.capture(context);
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        duration = elapsed.count() / steps;
+        exporter.finish();
+        stats = exporter.getStats();
+    }
+    std::cout << "  " << stats.framesWritten << "/" << stats.framesExported << " frames written, render "
+              << stats.renderMs / std::max<size_t>(stats.framesExported, 1) << " ms/frame, blocked "
+              << stats.blockedMs << " ms in total\n";
+    return duration;
+}
+
+/**
+ * @brief Compares a run without export with PNG and raw offscreen exports.
+ */
+void runExport(size_t count, int steps){
+    std::cout << "export: " << count << " particles, " << steps << " steps, every 2nd frame exported\n";
+    Context context;
+    buildGranularScene(context, count);
+    std::cout << "none     " << std::fixed << std::setprecision(3) << timeSteps(context, steps) << " ms/step\n";
+    double duration = timeExport(count, steps, ExportSettings::Format::Png, "export/png");
+    std::cout << "png      " << duration << " ms/step\n";
+    duration = timeExport(count, steps, ExportSettings::Format::Raw, "export/raw");
+    std::cout << "raw      " << duration << " ms/step\n";
+}
+
+/**
+ * @brief Gets the peak resident set size of the process.
+ *
+ * @return The peak, in bytes, or 0 if the system does not report it.
+ */
+size_t peakResidentBytes(){
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    //Linux compte en kilo-octets
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Measures the memory held per particle by the granular scene.
+ *
+ * The growth of the peak resident set size covers every per-particle
+ * structure (storage, broadphase, constraints), not only the particles.
+ */
+void runMemory(size_t count, int steps){
+    std::cout << "memory: " << count << " particles, " << steps << " steps\n";
+    size_t baseline = peakResidentBytes();
+    Context context;
+    buildGranularScene(context, count);
+    double ms = timeSteps(context, steps);
+    size_t peak = peakResidentBytes();
+    size_t storage = context.getParticles().capacity() * sizeof(Particle);
+    double perParticle = count > 0 ? 1.0 / count : 0;
+    std::cout << "particle      " << sizeof(Particle) << " bytes\n";
+    std::cout << "storage       " << std::fixed << std::setprecision(1) << storage * perParticle << " bytes/particle\n";
+    std::cout << "peak RSS      " << peak / (1024.0 * 1024.0) << " MiB, "
+              << (peak - std::min(baseline, peak)) * perParticle << " bytes/particle above the baseline\n";
+    std::cout << "step          " << std::setprecision(3) << ms << " ms/step\n";
+}
+
+/**
+ * @brief Drops a layer of particles on a slope, with and without friction, and compares how fast it falls asleep.
+ *
+ * Without friction the layer slides down the slope forever. The scene is
+ * stepped until nine particles out of ten sleep, or `steps` steps; the step
+ * duration includes the contact response.
+ */
+void runMaterials(size_t count, int steps){
+    std::cout << "materials: " << count << " particles, at most " << steps << " steps\n";
+    std::cout << "material   settled at   awake   ms/step\n";
+    for (bool friction: {false, true}){
+        Context context;
+        context.clear();
+        MaterialId material = 0;
+        if (friction){
+            Material rough;
+            rough.staticFriction = 0.6f;
+            rough.dynamicFriction = 0.4f;
+            rough.restitution = 0.1f;
+            material = context.addMaterial(rough);
+        }
+        auto slope = std::make_unique<PlanCollider>(Vec2(0, 400), Vec2(0.2f, -1));
+        slope->changeMaterial(material);
+        context.addCollider(std::move(slope));
+
+        //Deux rangées de particules au-dessus de la pente
+        const float radius = 2;
+        const float spacing = 2 * radius + 1;
+        const size_t columns = std::max<size_t>(1, count / 2);
+        for (size_t i = 0; i < count; ++i){
+            float x = (i % columns) * spacing;
+            float y = 400 + 0.2f * x - 10 - static_cast<float>(i / columns) * spacing;
+            context.addParticle(Particle(Vec2(x, y), Vec2(0, 0), radius, 1, std::numeric_limits<float>::infinity(), material));
+        }
+
+        int settled = -1;
+        int s = 0;
+        auto start = Clock::now();
+        for (; s < steps && settled < 0; ++s){
+            context.updatePhysicalSystem(context.getConfig().stepDuration);
+            if (context.getStepStats().awakeParticles * 10 <= context.getAliveParticleCount()){
+                settled = s + 1;
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        std::cout << (friction ? "rough    " : "default  ") << std::setw(12)
+                  << (settled < 0 ? std::string("never") : std::to_string(settled))
+                  << std::setw(8) << context.getStepStats().awakeParticles
+                  << std::setw(10) << std::fixed << std::setprecision(3) << elapsed.count() / std::max(s, 1) << "\n";
+    }
+}
+
+/**
+ * @brief Sweeps a thin wall through a layer of particles, teleported or kinematic.
+ *
+ * The wall crosses the layer at 300 units/s, several particle diameters per
+ * step. Teleported with `moveCollider`, it jumps over the particles; as a
+ * kinematic collider, it pushes them all ahead of it.
+ */
+void runKinematic(size_t count, int steps){
+    std::cout << "kinematic: " << count << " particles, " << steps << " steps\n";
+    std::cout << "wall         left behind   ms/step\n";
+    for (bool kinematic: {false, true}){
+        Context context;
+        context.clear();
+        context.addCollider(std::make_unique<PlanCollider>(Vec2(0, 400), Vec2(0, -1)));
+        const float dt = context.getConfig().stepDuration;
+        const float speed = 300;
+        //Le mur descend sous le sol : on ne mesure que les particules qui le traversent
+        auto wall = std::make_unique<SegmentCollider>(Vec2(0, 0), Vec2(0, 800));
+        if (kinematic){
+            wall->changeMotion(std::make_unique<ScriptedMotion>([speed](float time) {
+                ColliderPose pose;
+                pose.offset = Vec2(speed * time, 0);
+                return pose;
+            }), Vec2(0, 0));
+        }
+        context.addCollider(std::move(wall));
+
+        //Couche de particules posées sur le sol, devant le mur
+        const float radius = 2;
+        const float spacing = 2 * radius + 1;
+        const size_t columns = std::max<size_t>(1, count / 10);
+        for (size_t i = 0; i < count; ++i){
+            float x = 50 + (i % columns) * spacing;
+            float y = 400 - radius - static_cast<float>(i / columns) * spacing;
+            context.addParticle(Particle(Vec2(x, y), Vec2(0, 0), radius, 1));
+        }
+
+        auto start = Clock::now();
+        for (int s = 0; s < steps; ++s){
+            if (!kinematic){
+                context.moveCollider(1, Vec2(speed * dt, 0));
+            }
+            context.updatePhysicalSystem(dt);
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        const float wallX = speed * dt * steps;
+        size_t behind = 0;
+        for (const Particle& particle: context.getParticles()){
+            if (particle.isAlive() && particle.getPos().getx() < wallX){
+                ++behind;
+            }
+        }
+        std::cout << (kinematic ? "kinematic  " : "teleported ") << std::setw(13) << behind
+                  << std::setw(10) << std::fixed << std::setprecision(3) << elapsed.count() / std::max(steps, 1) << "\n";
+    }
+}
+
+/**
+ * @brief Compares the rebuilt and the incrementally updated broadphase grids.
+ *
+ * A lattice of particles is binned at every step while a growing fraction of
+ * them jumps to another cell. Both grids must list the same candidates.
+ */
+void runBroadphase(size_t count, int steps){
+    std::cout << "broadphase: " << count << " particles, " << steps << " steps\n";
+    std::cout << "moving   rebuild ms   incremental ms   rebinned   same pairs\n";
+    ThreadPool pool;
+    const float radius = 2;
+    const float spacing = 2 * radius + 1;
+    const size_t columns = static_cast<size_t>(std::sqrt(static_cast<double>(count))) + 1;
+    for (double level: {0.0, 0.001, 0.01, 0.1, 0.5, 1.0}){
+        std::vector<Particle> particles;
+        particles.reserve(count);
+        for (size_t i = 0; i < count; ++i){
+            Vec2 pos((i % columns) * spacing, static_cast<float>(i / columns) * spacing);
+            particles.emplace_back(pos, Vec2(0, 0), radius, 1);
+        }
+        SpatialGrid rebuilt;
+        SpatialGrid incremental;
+        std::chrono::duration<double, std::milli> rebuildTime(0);
+        std::chrono::duration<double, std::milli> incrementalTime(0);
+        size_t rebinned = 0;
+        bool same = true;
+        //Une particule sur `1/level` saute de deux cellules en diagonale
+        const size_t stride = level > 0 ? static_cast<size_t>(1 / level) : 0;
+        for (int s = 0; s < steps; ++s){
+            if (stride > 0){
+                Vec2 shift = (s % 2 == 0 ? Vec2(1, 1) : Vec2(-1, -1)) * (4 * radius);
+                for (size_t i = s % stride; i < count; i += stride){
+                    particles[i].changeExpectedPos(particles[i].getExpectedPos() + shift);
+                }
+            }
+            auto start = Clock::now();
+            rebuilt.build(particles, pool);
+            auto middle = Clock::now();
+            incremental.update(particles, pool);
+            auto end = Clock::now();
+            rebuildTime += middle - start;
+            incrementalTime += end - middle;
+            if (s > 0){
+                rebinned += incremental.getRebinnedCount();
+            }
+
+            //Les deux grilles doivent donner les mêmes candidats, dans le même ordre
+            std::vector<size_t> a;
+            std::vector<size_t> b;
+            for (size_t i = 0; i < count && same; i += 97){
+                a.clear();
+                b.clear();
+                rebuilt.forEachCandidate(i, [&](size_t j) { a.push_back(j); });
+                incremental.forEachCandidate(i, [&](size_t j) { b.push_back(j); });
+                same = a == b;
+            }
+        }
+        std::cout << std::setw(5) << std::fixed << std::setprecision(1) << level * 100 << "%"
+                  << std::setw(13) << std::setprecision(3) << rebuildTime.count() / steps
+                  << std::setw(17) << incrementalTime.count() / steps
+                  << std::setw(11) << rebinned / std::max(steps - 1, 1)
+                  << std::setw(13) << (same ? "yes" : "NO") << "\n";
+    }
+}
+
+/**
+ * @brief Compares substeps and solver iterations on resting stacks, for accuracy and cost.
+ *
+ * Columns of particles start at rest on the ground, exactly touching. An
+ * exact solver would keep them still; the error is the compression of the
+ * columns (or their explosion when the solver gains energy), averaged over
+ * the second half of the run.
+ *
+ * A second scene checks the removals across substeps: particles with short
+ * lifetimes must all get their slot back, whatever the number of substeps.
+ *
+ * A third scene launches a particle at a resting one, through the command
+ * queue, with 8 substeps: the candidate pairs of the first substep must
+ * already cover the speed of the new particle, so that both end where a
+ * single substep puts them.
+ *
+ * @return False if the launched particle went through the resting one.
+ */
+bool runSubsteps(size_t count, int steps){
+    const size_t height = 30;
+    const size_t columns = std::max<size_t>(1, count / height);
+    std::cout << "substeps: " << columns << " columns of " << height << " particles, " << steps << " steps\n";
+    std::cout << "substeps   iterations   height error   max speed   ms/step\n";
+    struct Variant { int substeps; int iterations; };
+    for (Variant variant: {Variant{1, 1}, Variant{1, 4}, Variant{4, 1}, Variant{1, 8}, Variant{8, 1},
+                           Variant{1, 16}, Variant{16, 1}}){
+        Context context;
+        context.clear();
+        SimulationConfig config = context.getConfig();
+        config.substeps = variant.substeps;
+        config.solverIterations = variant.iterations;
+        context.setConfig(config);
+        const float ground = 400;
+        const float radius = 2;
+        context.addCollider(std::make_unique<PlanCollider>(Vec2(0, ground), Vec2(0, -1)));
+        //Colonnes espacées de trois diamètres : elles ne se touchent pas
+        for (size_t c = 0; c < columns; ++c){
+            for (size_t k = 0; k < height; ++k){
+                Vec2 pos(c * 6 * radius, ground - radius - k * 2 * radius);
+                context.addParticle(Particle(pos, Vec2(0, 0), radius, 1));
+            }
+        }
+        const float idealHeight = (height - 1) * 2 * radius;
+
+        //Écart entre la hauteur de chaque colonne (du bas vers le haut) et sa hauteur au repos
+        double error = 0;
+        float maxSpeed = 0;
+        std::chrono::duration<double, std::milli> elapsed(0);
+        int measured = 0;
+        for (int s = 0; s < steps; ++s){
+            auto start = Clock::now();
+            context.updatePhysicalSystem(context.getConfig().stepDuration);
+            elapsed += Clock::now() - start;
+            if (2 * s < steps){
+                continue;
+            }
+            const auto& particles = context.getParticles();
+            for (size_t c = 0; c < columns; ++c){
+                float columnHeight = particles[c * height].getPos().gety() - particles[c * height + height - 1].getPos().gety();
+                error += std::abs(columnHeight - idealHeight) / idealHeight;
+            }
+            maxSpeed = std::max(maxSpeed, context.getStepStats().maxSpeed);
+            measured++;
+        }
+        std::cout << std::setw(8) << variant.substeps << std::setw(13) << variant.iterations
+                  << std::setw(14) << std::fixed << std::setprecision(2) << 100 * error / (std::max(measured, 1) * columns) << "%"
+                  << std::setw(12) << maxSpeed
+                  << std::setw(10) << std::setprecision(3) << elapsed.count() / steps << "\n";
+    }
+
+    //Durées de vie de 0,05 à 0,149 s : les particules meurent à des sous-pas différents
+    std::cout << "substeps   expired   leaked slots\n";
+    for (int substeps: {1, 4, 8}){
+        Context context;
+        context.clear();
+        SimulationConfig config = context.getConfig();
+        config.substeps = substeps;
+        context.setConfig(config);
+        for (size_t i = 0; i < count; ++i){
+            Vec2 pos((i % 100) * 10.0f, (i / 100) * 10.0f);
+            context.addParticle(Particle(pos, Vec2(0, 0), 2, 1, 0.05f + (i % 100) * 0.001f));
+        }
+        //Emplacements morts absents de la liste libre, au pire des pas : la compaction finit par les effacer
+        const auto& particles = context.getParticles();
+        size_t leaked = 0;
+        size_t alive = count;
+        for (int s = 0; s < 10; ++s){
+            context.updatePhysicalSystem(0.016f);
+            alive = std::count_if(particles.begin(), particles.end(), [](const Particle& p) { return p.isAlive(); });
+            size_t freed = particles.size() - context.getAliveParticleCount();
+            leaked = std::max(leaked, particles.size() - alive - freed);
+        }
+        std::cout << std::setw(8) << substeps << std::setw(10) << count - alive << std::setw(15) << leaked << "\n";
+    }
+
+    //Sans gravité, A repose un pas (vitesse maximale nulle), puis B est lancé vers lui à 60 unités/s
+    std::cout << "substeps   resting x   launched x\n";
+    float expected[2] = {0, 0};
+    bool ok = true;
+    for (int substeps: {1, 8}){
+        Context context;
+        context.clear();
+        SimulationConfig config = context.getConfig();
+        config.gravity = Vec2(0, 0);
+        config.substeps = substeps;
+        context.setConfig(config);
+        context.addParticle(Particle(Vec2(0, 0), Vec2(0, 0), 2, 1));
+        context.updatePhysicalSystem(config.stepDuration);
+        AddParticlesCommand command;
+        command.particles.emplace_back(Vec2(-10, 0), Vec2(60, 0), 2, 1);
+        context.getCommandQueue().push(std::move(command));
+        context.updatePhysicalSystem(config.stepDuration);
+        const auto& particles = context.getParticles();
+        float resting = particles[0].getPos().getx();
+        float launched = particles[1].getPos().getx();
+        std::cout << std::setw(8) << substeps << std::setw(12) << std::setprecision(2) << resting
+                  << std::setw(13) << launched << "\n";
+        if (substeps == 1){
+            expected[0] = resting;
+            expected[1] = launched;
+        } else if (std::abs(resting - expected[0]) > 0.1f || std::abs(launched - expected[1]) > 0.1f){
+            ok = false;
+        }
+    }
+    if (!ok){
+        std::cout << "FAILED: the pair of the launched particle was missed\n";
+    }
+    return ok;
+}
+
+/**
+ * @brief Counts the allocations of each stage once the buffers have reached their working size.
+ *
+ * Two scenes are warmed up until the granular pile has settled (at least
+ * 300 steps), then stepped `steps` more times, on one thread and on four:
+ * the granular scene, and a stream of emitted particles culled by their
+ * lifetime and by a kill volume. The emitter keeps running during the
+ * measure: its rate times the lifetime of the particles gives a steady
+ * population, reached long before the end of the warm-up, whose removals
+ * and insertions go through the free list and the compaction. Both scenes
+ * are measured with `count` particles and with a quarter of them.
+ *
+ * @return False if a step of the steady state allocated.
+ */
+bool runAllocations(size_t count, int steps){
+    //Le tas granulaire se tasse pendant quelques secondes : ses tampons grandissent jusque-là
+    const int warmup = std::max(steps, 300);
+    std::cout << "allocations: " << count << " particles, " << warmup << " warm-up and " << steps << " measured steps\n";
+    if (!AllocationCounter::isHooked()){
+        std::cout << "allocation hooks not linked, nothing to count\n";
+        return false;
+    }
+    bool steady = true;
+    for (size_t size: {count / 4, count})
+    for (bool emitted: {false, true})
+    for (unsigned threads: {1u, 4u}){
+        Context context;
+        context.setThreadCount(threads);
+        if (emitted){
+            context.clear();
+            context.addCollider(std::make_unique<PlanCollider>(Vec2(300, 400), Vec2(0, -1)));
+            //Les particules qui glissent à droite du sol sont supprimées avant la fin de leur vie
+            context.addKillVolume(AABB{Vec2(450, -1000), Vec2(2000, 2000)});
+            //Chute de 100 unités en 4,5 s : les particules vivent assez pour toucher le sol et glisser
+            EmissionSettings settings;
+            settings.lifetime = 8;
+            settings.rate = static_cast<float>(size) / settings.lifetime;
+            settings.velocity = Vec2(20, 0);
+            settings.spread = 0.5f;
+            settings.radius = 2;
+            context.addEmitter(std::make_unique<AreaEmitter>(Vec2(0, 300), Vec2(600, 0), settings, 1));
+        } else {
+            buildGranularScene(context, size);
+        }
+        for (int s = 0; s < warmup; ++s){
+            context.updatePhysicalSystem(context.getConfig().stepDuration);
+        }
+
+        context.setAllocationTracking(true);
+        std::vector<StageAllocations> totals;
+        for (int s = 0; s < steps; ++s){
+            context.updatePhysicalSystem(context.getConfig().stepDuration);
+            const auto& stages = context.getStageAllocations();
+            totals.resize(stages.size());
+            for (size_t k = 0; k < stages.size(); ++k){
+                totals[k].stage = stages[k].stage;
+                totals[k].count.allocations += stages[k].count.allocations;
+                totals[k].count.bytes += stages[k].count.bytes;
+            }
+        }
+        std::cout << (emitted ? "emitted" : "granular") << " scene, " << threads << (threads > 1 ? " threads, " : " thread, ")
+                  << context.getAliveParticleCount() << " particles\n";
+        std::cout << "stage        allocations      bytes\n";
+        for (const StageAllocations& stage: totals){
+            std::cout << std::left << std::setw(12) << stage.stage << std::right
+                      << std::setw(12) << stage.count.allocations << std::setw(11) << stage.count.bytes << "\n";
+            steady = steady && stage.count.allocations == 0;
+        }
+    }
+    std::cout << (steady ? "steady state allocation-free\n" : "FAILED: the steady state allocates\n");
+    return steady;
+}
+
+/**
+ * @brief Pans a camera along a long strip of resting piles, paging the tiles in and out.
+ *
+ * The world is built through `TiledWorld::addParticles`, so only the piles
+ * near the camera are ever resident: the peak memory follows the view, not
+ * the number of particles.
+ */
+void runTiles(size_t count, int steps){
+    std::cout << "tiles: " << count << " particles, " << steps << " steps\n";
+    size_t baseline = peakResidentBytes();
+    Context context;
+    context.clear();
+    context.addCollider(std::make_unique<PlanCollider>(Vec2(0, 400), Vec2(0, -1)));
+    TileSettings settings;
+    TiledWorld world(context, settings);
+    AABB view{Vec2(0, -200), Vec2(800, 400)};
+    world.setFocus(view);
+
+    //Colonnes jointives de 16 particules posées sur le sol, construites par lots
+    const float radius = 2;
+    const size_t height = 16;
+    std::vector<Particle> batch;
+    for (size_t i = 0; i < count; ++i){
+        float x = radius + static_cast<float>(i / height) * 2 * radius;
+        float y = 400 - radius - static_cast<float>(i % height) * 2 * radius;
+        batch.emplace_back(Vec2(x, y), Vec2(0, 0), radius, 1);
+        if (batch.size() == 65536){
+            world.addParticles(std::move(batch));
+            batch.clear();
+        }
+    }
+    world.addParticles(std::move(batch));
+    std::cout << "built         " << world.getStats().residentParticles << " resident, "
+              << world.getStats().pagedParticles << " paged\n";
+
+    //La caméra avance d'un huitième de tuile par pas
+    const float speed = settings.tileSize / 8;
+    size_t maxResident = 0;
+    auto start = Clock::now();
+    for (int s = 0; s < steps; ++s){
+        view.min = view.min + Vec2(speed, 0);
+        view.max = view.max + Vec2(speed, 0);
+        world.setFocus(view);
+        world.step(context.getConfig().stepDuration);
+        maxResident = std::max(maxResident, world.getStats().residentParticles);
+    }
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    const TileStats& stats = world.getStats();
+    size_t peak = peakResidentBytes();
+    std::cout << "resident      " << stats.residentParticles << " (at most " << maxResident << "), "
+              << stats.residentTiles << " tiles\n";
+    std::cout << "paged         " << stats.pagedParticles << " in " << stats.pagedTiles << " tiles, page file "
+              << std::fixed << std::setprecision(1) << stats.pageFileBytes / (1024.0 * 1024.0) << " MiB\n";
+    std::cout << "traffic       " << stats.pageIns << " page-ins, " << stats.pageOuts << " page-outs, "
+              << stats.stalls << " stalls\n";
+    std::cout << "peak RSS      " << (peak - std::min(baseline, peak)) / (1024.0 * 1024.0) << " MiB above the baseline\n";
+    std::cout << "step          " << std::setprecision(3) << elapsed.count() / std::max(steps, 1) << " ms/step\n";
+}
+
+/**
+ * @brief Runs a parameter sweep of small granular scenes, one simulation per thread.
+ *
+ * @param sweepFile Path of the sweep description, or null for the default sweep.
+ */
+void runEnsemble(size_t count, int steps, const char* sweepFile){
+    ParameterSweep sweep;
+    if (sweepFile != nullptr){
+        std::ifstream in(sweepFile);
+        if (!in){
+            std::cerr << "Cannot open " << sweepFile << "\n";
+            return;
+        }
+        try {
+            sweep = ParameterSweep::parse(in);
+        } catch (const std::runtime_error& error){
+            std::cerr << error.what() << "\n";
+            return;
+        }
+    } else {
+        sweep.masses = {0.5f, 1, 2};
+        sweep.radii = {1.5f, 2, 3};
+        sweep.gravities = {4.9f, 9.8f};
+        sweep.repeats = 2;
+    }
+    size_t runs = sweep.expand().size();
+    EnsembleRunner runner;
+    std::cout << "ensemble: " << runs << " simulations of " << count << " particles, " << steps << " steps, "
+              << std::thread::hardware_concurrency() << " at once\n";
+
+    auto buildScene = [count](Context& context, const EnsembleParameters& parameters) {
+        context.addCollider(std::make_unique<PlanCollider>(Vec2(300, 400), Vec2(0, -1)));
+        context.addCollider(std::make_unique<PlanCollider>(Vec2(0, 300), Vec2(1, -1)));
+        context.addCollider(std::make_unique<SphereCollider>(Vec2(500, 200), 30));
+        const float spacing = 2 * parameters.radius + 1;
+        const size_t columns = 60;
+        std::vector<Particle> batch;
+        batch.reserve(count);
+        for (size_t i = 0; i < count; ++i){
+            Vec2 pos(200 + (i % columns) * spacing, 300 - static_cast<float>(i / columns) * spacing);
+            batch.emplace_back(pos, Vec2(0, 0), parameters.radius, parameters.mass);
+        }
+        context.addParticles(std::move(batch));
+    };
+
+    auto start = Clock::now();
+    std::vector<EnsembleResult> results = runner.run(sweep, buildScene, steps);
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    std::ofstream out("ensemble.csv");
+    EnsembleRunner::writeCsv(out, results);
+    double busy = 0;
+    for (const auto& result: results){
+        busy += result.durationMs;
+    }
+    std::cout << std::fixed << std::setprecision(3) << "total    " << elapsed.count() << " s, "
+              << busy / std::max<size_t>(runs, 1) << " ms/simulation\n"
+              << "rate     " << std::setprecision(0) << runs / elapsed.count() * 3600 << " simulations/hour\n"
+              << "results  ensemble.csv\n";
+}
+
+/**
+ * @brief Runs the granular scene split into slabs, one process per slab.
+ *
+ * Rank 0 builds all the particles: they spread to the other slabs by
+ * migration, and the boundaries then follow the particle counts.
+ */
+void runDistributed(size_t count, int steps, int processCount){
+    //Les processus sont créés avant tout thread
+    std::unique_ptr<SocketTransport> transport;
+    try {
+        transport = SocketTransport::spawn(processCount);
+    } catch (const std::runtime_error& error){
+        std::cerr << error.what() << "\n";
+        return;
+    }
+    int rank = transport->getRank();
+    if (rank == 0){
+        std::cout << "distributed: " << count << " particles, " << steps << " steps, " << processCount << " processes\n";
+    }
+
+    Context context;
+    context.setThreadCount(std::max(1u, std::thread::hardware_concurrency() / processCount));
+    buildGranularScene(context, rank == 0 ? count : 0);
+    //Frontières initiales régulières sur la largeur de la scène
+    std::vector<float> boundaries;
+    for (int r = 1; r < processCount; ++r){
+        boundaries.push_back(100 + 600.0f * r / processCount);
+    }
+    SlabDomain slab(context, *transport, boundaries);
+
+    SlabStats totals;
+    auto start = Clock::now();
+    for (int s = 0; s < steps; ++s){
+        slab.step(context.getConfig().stepDuration);
+        totals.ghostsReceived += slab.getStats().ghostsReceived;
+        totals.migrantsSent += slab.getStats().migrantsSent;
+        totals.bytesExchanged += slab.getStats().bytesExchanged;
+    }
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+    //Rassemblement des résultats sur le rang 0
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1) << "rank " << rank << "  [" << slab.getLowerBound() << ", "
+           << slab.getUpperBound() << ")  " << slab.getStats().ownedParticles << " particles, "
+           << std::setprecision(3) << elapsed.count() / steps << " ms/step, "
+           << totals.ghostsReceived / std::max(steps, 1) << " ghosts/step, " << totals.migrantsSent << " migrations, "
+           << totals.bytesExchanged / std::max(steps, 1) << " bytes/step\n";
+    std::string line = report.str();
+    Transport::Message message(line.begin(), line.end());
+    if (rank != 0){
+        transport->exchange(0, message);
+        return;
+    }
+    std::cout << line;
+    for (int r = 1; r < processCount; ++r){
+        Transport::Message other = transport->exchange(r, Transport::Message());
+        std::cout << std::string(other.begin(), other.end());
+    }
+}
+}
+
+int main(int argc, char *argv[])
+{
+    const char* scenario = argc > 1 ? argv[1] : "scaling";
+    size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20000;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    if (std::strcmp(scenario, "scaling") == 0){
+        runScaling(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "emitters") == 0){
+        runEmitters(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "colliders") == 0){
+        runColliders(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "polygons") == 0){
+        runPolygons(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "layers") == 0){
+        runLayers(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "config") == 0){
+        runConfig(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "scalars") == 0){
+        runScalars(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "export") == 0){
+        runExport(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "distributed") == 0){
+        runDistributed(count, steps, argc > 4 ? std::atoi(argv[4]) : 2);
+        return 0;
+    }
+    if (std::strcmp(scenario, "ensemble") == 0){
+        runEnsemble(count, steps, argc > 4 ? argv[4] : nullptr);
+        return 0;
+    }
+    if (std::strcmp(scenario, "memory") == 0){
+        runMemory(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "tiles") == 0){
+        runTiles(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "materials") == 0){
+        runMaterials(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "kinematic") == 0){
+        runKinematic(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "broadphase") == 0){
+        runBroadphase(count, steps);
+        return 0;
+    }
+    if (std::strcmp(scenario, "substeps") == 0){
+        return runSubsteps(count, steps) ? 0 : 1;
+    }
+    if (std::strcmp(scenario, "allocations") == 0){
+        return runAllocations(count, steps) ? 0 : 1;
+    }
+    std::cerr << "Unknown scenario: " << scenario << "\n";
+    std::cerr << "Scenarios: scaling, emitters, colliders, polygons, layers, config, scalars, export, ensemble, distributed, memory, tiles, materials, kinematic, broadphase, substeps, allocations\n";
+    return 1;
+}
@@ -0,0 +1,152 @@
+#include "bvh.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr int binCount = 16;
+constexpr int maxLeafSize = 4;
+constexpr int maxDepth = 30;
+
+float perimeter(const AABB& box){
+    return 2 * ((box.max.getx() - box.min.getx()) + (box.max.gety() - box.min.gety()));
+}
+
+float centroid(const AABB& box, int axis){
+    return axis == 0 ? (box.min.getx() + box.max.getx()) / 2 : (box.min.gety() + box.max.gety()) / 2;
+}
+
+}
+
+void Bvh::build(const std::vector<AABB>& boxes){
+    this->boxes = boxes;
+    nodes.clear();
+    items.resize(boxes.size());
+    std::iota(items.begin(), items.end(), 0);
+    leafOfItem.assign(boxes.size(), 0);
+    if (boxes.empty()){
+        return;
+    }
+    //Un arbre binaire a au plus 2n-1 noeuds
+    nodes.reserve(2 * boxes.size());
+    nodes.emplace_back();
+    subdivide(0, 0, static_cast<int>(boxes.size()), 0);
+}
+
+void Bvh::subdivide(int nodeIndex, int first, int count, int depth){
+    AABB box = boxes[items[first]];
+    AABB centroids{Vec2(centroid(box, 0), centroid(box, 1)), Vec2(centroid(box, 0), centroid(box, 1))};
+    for (int k = first; k < first + count; ++k){
+        const AABB& itemBox = boxes[items[k]];
+        box = box.merged(itemBox);
+        Vec2 c(centroid(itemBox, 0), centroid(itemBox, 1));
+        centroids = centroids.merged(AABB{c, c});
+    }
+    nodes[nodeIndex].box = box;
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].count = count;
+    for (int k = first; k < first + count; ++k){
+        leafOfItem[items[k]] = nodeIndex;
+    }
+    if (count <= maxLeafSize || depth >= maxDepth){
+        return;
+    }
+
+    //Découpe le long de l'axe où les centres sont les plus étalés
+    float extentX = centroids.max.getx() - centroids.min.getx();
+    float extentY = centroids.max.gety() - centroids.min.gety();
+    int axis = extentX >= extentY ? 0 : 1;
+    float low = axis == 0 ? centroids.min.getx() : centroids.min.gety();
+    float extent = axis == 0 ? extentX : extentY;
+    if (extent <= 0){
+        return;
+    }
+
+    //Répartit les éléments dans des intervalles réguliers puis évalue chaque plan de coupe
+    struct Bin { AABB box; int count = 0; };
+    Bin bins[binCount];
+    auto binOf = [&](size_t item) {
+        int b = static_cast<int>((centroid(boxes[item], axis) - low) / extent * binCount);
+        return std::min(b, binCount - 1);
+    };
+    for (int k = first; k < first + count; ++k){
+        Bin& bin = bins[binOf(items[k])];
+        bin.box = bin.count == 0 ? boxes[items[k]] : bin.box.merged(boxes[items[k]]);
+        ++bin.count;
+    }
+    float rightCost[binCount] = {};
+    AABB accumulated;
+    int accumulatedCount = 0;
+    for (int b = binCount - 1; b > 0; --b){
+        if (bins[b].count > 0){
+            accumulated = accumulatedCount == 0 ? bins[b].box : accumulated.merged(bins[b].box);
+            accumulatedCount += bins[b].count;
+        }
+        rightCost[b] = accumulatedCount == 0 ? 0 : perimeter(accumulated) * accumulatedCount;
+    }
+    float bestCost = std::numeric_limits<float>::infinity();
+    int bestSplit = -1;
+    accumulatedCount = 0;
+    for (int b = 0; b < binCount - 1; ++b){
+        if (bins[b].count > 0){
+            accumulated = accumulatedCount == 0 ? bins[b].box : accumulated.merged(bins[b].box);
+            accumulatedCount += bins[b].count;
+        }
+        if (accumulatedCount == 0 || accumulatedCount == count){
+            continue;
+        }
+        float cost = perimeter(accumulated) * accumulatedCount + rightCost[b + 1];
+        if (cost < bestCost){
+            bestCost = cost;
+            bestSplit = b;
+        }
+    }
+    //Une feuille coûte autant de tests que d'éléments : on ne coupe que si c'est rentable
+    if (bestSplit < 0 || bestCost >= perimeter(box) * count){
+        return;
+    }
+
+    auto middle = std::partition(items.begin() + first, items.begin() + first + count,
+                                 [&](size_t item) { return binOf(item) <= bestSplit; });
+    int leftCount = static_cast<int>(middle - items.begin()) - first;
+
+    int left = static_cast<int>(nodes.size());
+    nodes.emplace_back();
+    nodes.emplace_back();
+    nodes[left].parent = nodeIndex;
+    nodes[left + 1].parent = nodeIndex;
+    nodes[nodeIndex].first = left;
+    nodes[nodeIndex].count = 0;
+    subdivide(left, first, leftCount, depth + 1);
+    subdivide(left + 1, first + leftCount, count - leftCount, depth + 1);
+}
+
+void Bvh::refit(size_t item, const AABB& box){
+    boxes[item] = box;
+    int nodeIndex = leafOfItem[item];
+    while (nodeIndex >= 0){
+        Node& node = nodes[nodeIndex];
+        if (node.count > 0){
+            node.box = boxes[items[node.first]];
+            for (int k = 1; k < node.count; ++k){
+                node.box = node.box.merged(boxes[items[node.first + k]]);
+            }
+        } else {
+            node.box = nodes[node.first].box.merged(nodes[node.first + 1].box);
+        }
+        nodeIndex = node.parent;
+    }
+}
+
+void Bvh::translate(const Vec2& offset){
+    for (AABB& box: boxes){
+        box = AABB{box.min + offset, box.max + offset};
+    }
+    for (Node& node: nodes){
+        node.box = AABB{node.box.min + offset, node.box.max + offset};
+    }
+}
+
+bool Bvh::empty() const{
+    return nodes.empty();
+}
@@ -0,0 +1,181 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "aabb.h"
+
+/**
+ * @brief Bounding-volume hierarchy over a set of axis-aligned boxes.
+ *
+ * The tree is built top-down with a binned surface-area heuristic (the 2D
+ * analogue, which weighs each side of a split by the perimeter of its box).
+ * Queries only descend into the nodes whose box is relevant, so their cost
+ * grows with the logarithm of the number of items.
+ *
+ * Items are identified by their index in the array given to `build`.
+ */
+class Bvh {
+public:
+    /// Value returned by `nearest` when the hierarchy is empty.
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    /**
+     * @brief Default constructor for `Bvh`.
+     */
+    Bvh() = default;
+
+    /**
+     * @brief Builds the hierarchy.
+     *
+     * @param boxes The bounding box of each item.
+     */
+    void build(const std::vector<AABB>& boxes);
+
+    /**
+     * @brief Updates the box of one item and refits its ancestors.
+     *
+     * The topology of the tree is kept, so the cost is proportional to the
+     * depth of the item. Suited to items that move a little between builds.
+     *
+     * @param item Index of the item.
+     * @param box The new bounding box of the item.
+     */
+    void refit(size_t item, const AABB& box);
+
+    /**
+     * @brief Moves every box of the hierarchy by the same offset.
+     *
+     * @param offset The displacement to apply.
+     */
+    void translate(const Vec2& offset);
+
+    /**
+     * @brief Tells whether the hierarchy holds no item.
+     *
+     * @return True if the hierarchy is empty.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Calls `visit(item)` for every item whose box overlaps `box`.
+     *
+     * @param box The query box.
+     * @param visit Function called with the index of each overlapping item.
+     */
+    template <typename Visitor>
+    void query(const AABB& box, Visitor&& visit) const {
+        if (nodes.empty()){
+            return;
+        }
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0){
+            const Node& node = nodes[stack[--top]];
+            if (!node.box.overlaps(box)){
+                continue;
+            }
+            if (node.count > 0){
+                for (int k = 0; k < node.count; ++k){
+                    size_t item = items[node.first + k];
+                    if (boxes[item].overlaps(box)){
+                        visit(item);
+                    }
+                }
+                continue;
+            }
+            stack[top++] = node.first;
+            stack[top++] = node.first + 1;
+        }
+    }
+
+    /**
+     * @brief Finds the item closest to a point.
+     *
+     * Nodes whose box is farther than the best distance found so far are
+     * pruned, and the closest child is visited first.
+     *
+     * @param p The query point.
+     * @param distance Function returning the exact distance from `p` to an item.
+     * @return The index of the closest item, or `npos` if the hierarchy is empty.
+     */
+    template <typename Distance>
+    size_t nearest(const Vec2& p, Distance&& distance) const {
+        size_t best = npos;
+        float bestDistance = std::numeric_limits<float>::infinity();
+        if (nodes.empty()){
+            return best;
+        }
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0){
+            const Node& node = nodes[stack[--top]];
+            if (boxDistance(node.box, p) >= bestDistance){
+                continue;
+            }
+            if (node.count > 0){
+                for (int k = 0; k < node.count; ++k){
+                    size_t item = items[node.first + k];
+                    float d = distance(item);
+                    if (d < bestDistance){
+                        bestDistance = d;
+                        best = item;
+                    }
+                }
+                continue;
+            }
+            int near = node.first;
+            int far = node.first + 1;
+            if (boxDistance(nodes[far].box, p) < boxDistance(nodes[near].box, p)){
+                std::swap(near, far);
+            }
+            stack[top++] = far;
+            stack[top++] = near;
+        }
+        return best;
+    }
+
+    /**
+     * @brief Computes the distance from a point to a box.
+     *
+     * @param box The box.
+     * @param p The point.
+     * @return 0 if `p` is inside the box, the Euclidean distance to the box otherwise.
+     */
+    static float boxDistance(const AABB& box, const Vec2& p) {
+        float dx = std::fmax(0.0f, std::fmax(box.min.getx() - p.getx(), p.getx() - box.max.getx()));
+        float dy = std::fmax(0.0f, std::fmax(box.min.gety() - p.gety(), p.gety() - box.max.gety()));
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+private:
+    /// Node of the tree: a leaf (`count > 0`) or an inner node whose children are `first` and `first + 1`.
+    struct Node {
+        AABB box;       ///< Bounding box of the node.
+        int first = 0;  ///< First item (leaf) or left child (inner node).
+        int count = 0;  ///< Number of items of a leaf, 0 for an inner node.
+        int parent = -1;///< Parent node, -1 for the root.
+    };
+
+    std::vector<Node> nodes;       ///< Nodes, the root first.
+    std::vector<size_t> items;     ///< Item indices, grouped by leaf.
+    std::vector<AABB> boxes;       ///< Bounding box of each item.
+    std::vector<int> leafOfItem;   ///< Leaf node holding each item.
+
+    /**
+     * @brief Recursively splits the items `[first, first + count)` of `items` under `nodeIndex`.
+     *
+     * @param nodeIndex The node to fill.
+     * @param first First item of the node.
+     * @param count Number of items of the node.
+     * @param depth Depth of the node, bounded to keep the query stacks small.
+     */
+    void subdivide(int nodeIndex, int first, int count, int depth);
+};
+
+#endif // BVH_H
@@ -0,0 +1,51 @@
+#include "collider.h"
+#include <algorithm>
+
+void Collider::advance(float dt){
+    if (!motion){
+        return;
+    }
+    motionTime += dt;
+    ColliderPose target = motion->poseAt(motionTime);
+    //Déplacement du pas : rotation autour du pivot courant, puis translation
+    step.angle = target.angle - pose.angle;
+    step.offset = target.offset - pose.offset;
+    stepPivot = pivot;
+    if (step.angle != 0){
+        rotate(pivot, step.angle);
+    }
+    translate(step.offset);
+    pivot += step.offset;
+    pose = target;
+    linearVelocity = dt > 0 ? step.offset / dt : Vec2(0, 0);
+    angularVelocity = dt > 0 ? step.angle / dt : 0;
+}
+
+float Collider::getMaxSpeed(float dt, int substeps) const{
+    float surfaceSpeed = surfaceVelocity.norm();
+    if (!motion || dt <= 0 || substeps < 1){
+        return surfaceSpeed;
+    }
+    //Bras de levier maximal : le coin de la boîte le plus éloigné du pivot
+    float arm = 0;
+    if (std::optional<AABB> bounds = getBounds()){
+        for (const Vec2& corner: {bounds->min, bounds->max, Vec2(bounds->min.getx(), bounds->max.gety()),
+                                  Vec2(bounds->max.getx(), bounds->min.gety())}){
+            arm = std::max(arm, (corner - pivot).norm());
+        }
+    }
+    float h = dt / substeps;
+    ColliderPose previous = pose;
+    float fastest = 0;
+    for (int k = 1; k <= substeps; ++k){
+        ColliderPose next = motion->poseAt(motionTime + k * h);
+        float moved = (next.offset - previous.offset).norm() + std::abs(next.angle - previous.angle) * arm;
+        fastest = std::max(fastest, moved / h);
+        previous = next;
+    }
+    return fastest + surfaceSpeed;
+}
+
+Vec2 Collider::carry(const Vec2& point) const{
+    return rotateAround(point, stepPivot, step.angle) + step.offset;
+}
@@ -2,6 +2,13 @@
 #define COLLIDER_H
 
 #include "staticconstraint.h"
+#include "aabb.h"
+#include "collidermotion.h"
+#include "collisionfilter.h"
+#include "material.h"
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <QPainter>
 
@@ -10,6 +17,11 @@
  *
  * Represents an abstract interface for objects that can detect collisions
  * with particles and optionally apply constraints to resolve those collisions.
+ *
+ * A collider is static unless it is given a motion (see `changeMotion`),
+ * which makes it kinematic: it then follows its trajectory at every step and
+ * the particles it touches get its velocity. A static collider may still
+ * have a surface velocity, like a conveyor belt.
  */
 class Collider {
 public:
@@ -51,6 +63,237 @@ public:
     virtual std::optional<StaticConstraint> checkContact(Particle& particle) const {
         return std::nullopt;
     }
+
+    /**
+     * @brief Tells whether the collider can be baked into a signed-distance grid.
+     *
+     * Colliders that cannot be baked are always tested with `checkContact`.
+     *
+     * @return True if `signedDistance` is implemented.
+     */
+    virtual bool isBakeable() const {
+        return false;
+    }
+
+    /**
+     * @brief Evaluates the signed distance from a point to the collider.
+     *
+     * @param p The point.
+     * @param gradient Receives the gradient of the distance at `p` (the outward normal).
+     * @return The signed distance, negative inside the collider.
+     */
+    virtual float signedDistance(const Vec2& /*p*/, Vec2& /*gradient*/) const {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    /**
+     * @brief Intersects a ray with the collider.
+     *
+     * The default implementation marches along the ray by steps of
+     * `signedDistance` (sphere tracing), so it only finds bakeable colliders.
+     *
+     * @param origin Origin of the ray.
+     * @param direction Unit direction of the ray.
+     * @param maxDistance Length of the ray.
+     * @param normal Receives the outward normal at the hit point.
+     * @return The distance along the ray to the surface, 0 if the origin is
+     *         inside, or `std::nullopt` if the ray misses the collider.
+     */
+    virtual std::optional<float> rayCast(const Vec2& origin, const Vec2& direction, float maxDistance, Vec2& normal) const {
+        if (!isBakeable()){
+            return std::nullopt;
+        }
+        constexpr int maxIterations = 128;
+        constexpr float tolerance = 1e-3f;
+        float t = 0;
+        for (int i = 0; i < maxIterations && t <= maxDistance; ++i){
+            float distance = signedDistance(origin + direction * t, normal);
+            if (distance < tolerance){
+                return t;
+            }
+            //Aucune surface n'est plus proche que la distance : on peut avancer d'autant
+            t += distance;
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Gets the bounding box of the collider.
+     *
+     * @return The bounding box, or `std::nullopt` for unbounded colliders such as planes.
+     */
+    virtual std::optional<AABB> getBounds() const {
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Moves the collider.
+     *
+     * @param offset The displacement to apply.
+     */
+    virtual void translate(const Vec2& /*offset*/) {}
+
+    /**
+     * @brief Rotates the collider.
+     *
+     * Colliders that do not override it cannot turn: only the translation of
+     * their motion is applied.
+     *
+     * @param pivot Center of the rotation.
+     * @param angle Angle of the rotation, in radians.
+     */
+    virtual void rotate(const Vec2& /*pivot*/, float /*angle*/) {}
+
+    /**
+     * @brief Gets the collision layer and mask of the collider.
+     *
+     * @return A constant reference to the filter of the collider.
+     */
+    const CollisionFilter& getFilter() const {
+        return filter;
+    }
+
+    /**
+     * @brief Changes the collision layer and mask of the collider.
+     *
+     * Must be called before the collider is added to a `Context`, which
+     * groups its colliders by filter.
+     *
+     * @param newFilter The new filter.
+     */
+    void changeFilter(const CollisionFilter& newFilter) {
+        filter = newFilter;
+    }
+
+    /**
+     * @brief Gets the material of the collider.
+     *
+     * @return The index of the material in the table of the `Context`.
+     */
+    MaterialId getMaterial() const {
+        return material;
+    }
+
+    /**
+     * @brief Changes the material of the collider.
+     *
+     * Must be called before the collider is added to a `Context`, which
+     * only samples baked colliders sharing a single material.
+     *
+     * @param newMaterial The index of the material in the table of the `Context`.
+     */
+    void changeMaterial(MaterialId newMaterial) {
+        material = newMaterial;
+    }
+
+    /**
+     * @brief Makes the collider kinematic.
+     *
+     * Must be called before the collider is added to a `Context`, which never
+     * bakes kinematic colliders. The poses of the motion are relative to the
+     * current placement of the collider, and its clock starts at 0.
+     *
+     * @param newMotion The trajectory of the collider.
+     * @param newPivot Center of the rotations of the motion, in the current placement.
+     */
+    void changeMotion(std::unique_ptr<ColliderMotion> newMotion, const Vec2& newPivot) {
+        motion = std::move(newMotion);
+        pivot = newPivot;
+        pose = ColliderPose();
+        motionTime = 0;
+    }
+
+    /**
+     * @brief Tells whether the collider follows a motion.
+     *
+     * @return True if a motion was given to `changeMotion`.
+     */
+    bool isKinematic() const {
+        return motion != nullptr;
+    }
+
+    /**
+     * @brief Changes the velocity of the surface of the collider, e.g. a conveyor belt.
+     *
+     * The collider does not move, but the friction of its contacts drags the
+     * particles along. Must be called before the collider is added to a
+     * `Context`, which never bakes colliders with a surface velocity.
+     *
+     * @param velocity The velocity of the surface.
+     */
+    void changeSurfaceVelocity(const Vec2& velocity) {
+        surfaceVelocity = velocity;
+    }
+
+    /**
+     * @brief Tells whether the contacts of the collider depend on its velocity.
+     *
+     * @return True if the collider is kinematic or has a surface velocity.
+     */
+    bool isMoving() const {
+        return motion != nullptr || !(surfaceVelocity == Vec2(0, 0));
+    }
+
+    /**
+     * @brief Gets the velocity of the collider at a point, over the last step.
+     *
+     * @param point The point, typically the contact position of a particle.
+     * @return The velocity of the rigid motion at the point, plus the surface velocity.
+     */
+    Vec2 getVelocityAt(const Vec2& point) const {
+        Vec2 arm = point - pivot;
+        return linearVelocity + Vec2(-arm.gety(), arm.getx()) * angularVelocity + surfaceVelocity;
+    }
+
+    /**
+     * @brief Bounds the speed of the points of the collider over the next step.
+     *
+     * Samples the motion at the end of each substep ahead of the current
+     * pose, without moving the collider. The rotation is bounded on the
+     * bounding box, so the rotation of an unbounded collider is ignored.
+     *
+     * @param dt The duration of the next step in seconds.
+     * @param substeps The number of substeps the step is split into.
+     * @return The largest speed of the rigid motion over a substep, plus the surface speed.
+     */
+    float getMaxSpeed(float dt, int substeps) const;
+
+    /**
+     * @brief Moves a kinematic collider to the pose of its motion after a step.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void advance(float dt);
+
+    /**
+     * @brief Tells whether the last `advance` changed the pose of the collider.
+     *
+     * @return True if the collider moved or turned during the last step.
+     */
+    bool hasMoved() const { return step.angle != 0 || !(step.offset == Vec2(0, 0)); }
+
+    /**
+     * @brief Moves a point along with the collider over the last step.
+     *
+     * @param point A point at the beginning of the step.
+     * @return Where the point would be at the end of the step if it was attached to the collider.
+     */
+    Vec2 carry(const Vec2& point) const;
+
+protected:
+    CollisionFilter filter;   ///< Collision layer and mask of the collider.
+    MaterialId material = 0;  ///< Material of the collider.
+
+private:
+    std::unique_ptr<ColliderMotion> motion;  ///< Trajectory of a kinematic collider, null for a static one.
+    Vec2 pivot = Vec2(0, 0);                 ///< Center of the rotations, in the current pose.
+    ColliderPose pose;                       ///< Pose reached so far.
+    float motionTime = 0;                    ///< Time elapsed on the motion (s).
+    Vec2 linearVelocity = Vec2(0, 0);        ///< Velocity of the pivot over the last step.
+    float angularVelocity = 0;               ///< Angular velocity over the last step (rad/s).
+    Vec2 surfaceVelocity = Vec2(0, 0);       ///< Velocity of the surface, see `changeSurfaceVelocity`.
+    Vec2 stepPivot = Vec2(0, 0);             ///< Pivot at the beginning of the last step.
+    ColliderPose step;                       ///< Displacement of the last step, around `stepPivot`.
 };
 
 #endif // COLLIDER_H
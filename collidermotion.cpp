@@ -0,0 +1,48 @@
+#include "collidermotion.h"
+#include <algorithm>
+#include <stdexcept>
+
+KeyframeMotion::KeyframeMotion(std::vector<Keyframe> keyframes, bool loop)
+    : keyframes(std::move(keyframes)), loop(loop) {
+    if (this->keyframes.empty()){
+        throw std::invalid_argument("A keyframe motion needs at least 1 keyframe");
+    }
+    bool sorted = std::is_sorted(this->keyframes.begin(), this->keyframes.end(),
+                                 [](const Keyframe& a, const Keyframe& b) { return a.time < b.time; });
+    if (!sorted){
+        throw std::invalid_argument("The keyframes must be sorted by time");
+    }
+}
+
+ColliderPose KeyframeMotion::poseAt(float time) const{
+    const float first = keyframes.front().time;
+    const float last = keyframes.back().time;
+    if (loop && last > first){
+        time = first + std::fmod(time - first, last - first);
+        if (time < first){
+            time += last - first;
+        }
+    }
+    if (time <= first){
+        return keyframes.front().pose;
+    }
+    if (time >= last){
+        return keyframes.back().pose;
+    }
+    //Première clé strictement après l'instant : l'intervalle est [next - 1, next]
+    auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+                                 [](float t, const Keyframe& keyframe) { return t < keyframe.time; });
+    const Keyframe& a = *(next - 1);
+    const Keyframe& b = *next;
+    float u = (time - a.time) / (b.time - a.time);
+    ColliderPose pose;
+    pose.offset = a.pose.offset + (b.pose.offset - a.pose.offset) * u;
+    pose.angle = a.pose.angle + (b.pose.angle - a.pose.angle) * u;
+    return pose;
+}
+
+ScriptedMotion::ScriptedMotion(std::function<ColliderPose(float)> script): script(std::move(script)) {}
+
+ColliderPose ScriptedMotion::poseAt(float time) const{
+    return script(time);
+}
@@ -0,0 +1,109 @@
+#ifndef COLLIDERMOTION_H
+#define COLLIDERMOTION_H
+
+#include <cmath>
+#include <functional>
+#include <vector>
+#include "vec2.h"
+
+/**
+ * @brief Placement of a kinematic collider relative to its placement at construction.
+ *
+ * The collider is first rotated by `angle` around its pivot, then translated
+ * by `offset`.
+ */
+struct ColliderPose {
+    Vec2 offset = Vec2(0, 0);  ///< Translation of the collider (and of its pivot).
+    float angle = 0;           ///< Rotation around the pivot, in radians.
+};
+
+/**
+ * @brief Rotates a point around a pivot.
+ *
+ * @param p The point.
+ * @param pivot Center of the rotation.
+ * @param angle Angle of the rotation, in radians.
+ * @return The rotated point.
+ */
+inline Vec2 rotateAround(const Vec2& p, const Vec2& pivot, float angle){
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    Vec2 d = p - pivot;
+    return pivot + Vec2(d.getx() * c - d.gety() * s, d.getx() * s + d.gety() * c);
+}
+
+/**
+ * @brief Base class for the trajectories of kinematic colliders.
+ *
+ * A kinematic collider is not affected by the particles: its pose is read
+ * from its motion at the beginning of every step, and the particles it
+ * touches get its velocity.
+ */
+class ColliderMotion {
+public:
+    /**
+     * @brief Default constructor for ColliderMotion.
+     */
+    ColliderMotion() = default;
+
+    /**
+     * @brief Virtual destructor for ColliderMotion.
+     */
+    virtual ~ColliderMotion() = default;
+
+    /**
+     * @brief Evaluates the pose of the collider.
+     *
+     * @param time Time elapsed since the motion was attached to the collider (s).
+     * @return The pose at that time.
+     */
+    virtual ColliderPose poseAt(float time) const = 0;
+};
+
+/**
+ * @brief Trajectory interpolated linearly between keyframes, e.g. a piston.
+ */
+class KeyframeMotion : public ColliderMotion {
+public:
+    /// Pose of the collider at a given time.
+    struct Keyframe {
+        float time = 0;     ///< Time of the keyframe (s).
+        ColliderPose pose;  ///< Pose at that time.
+    };
+
+    /**
+     * @brief Constructs a new `KeyframeMotion`.
+     *
+     * @param keyframes The keyframes, at least one, sorted by increasing time.
+     * @param loop True to start over after the last keyframe, false to stay there.
+     * @throw std::invalid_argument if there is no keyframe or they are not sorted.
+     */
+    explicit KeyframeMotion(std::vector<Keyframe> keyframes, bool loop = true);
+
+    ColliderPose poseAt(float time) const override;
+
+private:
+    std::vector<Keyframe> keyframes;  ///< The keyframes, sorted by time.
+    bool loop;                        ///< Whether the motion repeats.
+};
+
+/**
+ * @brief Trajectory computed by a function of time, e.g. a flipper driven by the player.
+ */
+class ScriptedMotion : public ColliderMotion {
+public:
+    /**
+     * @brief Constructs a new `ScriptedMotion`.
+     *
+     * @param script Function giving the pose from the time, called from the
+     *        thread stepping the simulation.
+     */
+    explicit ScriptedMotion(std::function<ColliderPose(float)> script);
+
+    ColliderPose poseAt(float time) const override;
+
+private:
+    std::function<ColliderPose(float)> script;  ///< The function of time.
+};
+
+#endif // COLLIDERMOTION_H
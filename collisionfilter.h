@@ -0,0 +1,29 @@
+#ifndef COLLISIONFILTER_H
+#define COLLISIONFILTER_H
+
+#include <cstdint>
+
+/**
+ * @brief Collision layer and mask of a particle or a collider.
+ *
+ * Each object belongs to the layers set in `layer` and only collides with
+ * the objects whose layers are set in its `mask`. Two objects interact when
+ * each one accepts the other, so a group such as debris can be kept away from
+ * another one by clearing a single bit of the mask.
+ */
+struct CollisionFilter {
+    uint32_t layer = 1;      ///< Layers the object belongs to.
+    uint32_t mask = ~0u;     ///< Layers the object collides with.
+
+    /**
+     * @brief Tells whether two objects may collide.
+     *
+     * @param other The filter of the other object.
+     * @return True if each object belongs to a layer accepted by the other one.
+     */
+    bool accepts(const CollisionFilter& other) const {
+        return (layer & other.mask) != 0 && (other.layer & mask) != 0;
+    }
+};
+
+#endif // COLLISIONFILTER_H
@@ -0,0 +1,95 @@
+#include "commandqueue.h"
+
+CommandQueue::CommandQueue(){
+    //Le nœud sentinelle ne porte jamais de commande
+    Node* stub = acquireNode();
+    head.store(stub, std::memory_order_relaxed);
+    tail = stub;
+}
+
+CommandQueue::~CommandQueue(){
+    //Les nœuds des blocs sont libérés avec leur bloc, les autres un par un
+    Node* node = tail;
+    while (node != nullptr){
+        Node* next = node->next.load(std::memory_order_relaxed);
+        if (node->slot == noSlot){
+            delete node;
+        }
+        node = next;
+    }
+    for (auto& block: blocks){
+        delete[] block.load(std::memory_order_relaxed);
+    }
+}
+
+void CommandQueue::push(Command command){
+    Node* node = acquireNode();
+    node->command = std::move(command);
+    //Le nœud est publié d'abord dans head, puis chaîné à son prédécesseur
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+bool CommandQueue::pop(Command& command){
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr){
+        return false;
+    }
+    //Le nœud suivant devient la sentinelle après avoir cédé sa commande
+    command = std::move(next->command);
+    releaseNode(tail);
+    tail = next;
+    return true;
+}
+
+CommandQueue::Node* CommandQueue::nodeAt(uint32_t slot) const{
+    return blocks[slot / blockSize].load(std::memory_order_acquire) + slot % blockSize;
+}
+
+CommandQueue::Node* CommandQueue::acquireNode(){
+    uint64_t top = freeTop.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(top) != 0){
+        Node* node = nodeAt(static_cast<uint32_t>(top) - 1);
+        //Le nœud peut être repris entre-temps : l'étiquette fait alors échouer l'échange
+        uint64_t below = node->nextFree.load(std::memory_order_relaxed);
+        uint64_t popped = ((top >> 32) + 1) << 32 | below;
+        if (freeTop.compare_exchange_weak(top, popped, std::memory_order_acquire, std::memory_order_acquire)){
+            return node;
+        }
+    }
+
+    //Liste vide : un nouveau bloc, dont on garde le premier nœud
+    uint32_t block = blockCount.fetch_add(1, std::memory_order_relaxed);
+    if (block >= maxBlocks){
+        return new Node();
+    }
+    Node* nodes = new Node[blockSize];
+    for (uint32_t k = 0; k < blockSize; ++k){
+        nodes[k].slot = block * blockSize + k;
+    }
+    blocks[block].store(nodes, std::memory_order_release);
+    for (uint32_t k = 1; k < blockSize; ++k){
+        pushFree(&nodes[k]);
+    }
+    return &nodes[0];
+}
+
+void CommandQueue::releaseNode(Node* node){
+    if (node->slot == noSlot){
+        delete node;
+        return;
+    }
+    //La commande déplacée peut garder des ressources : on la remplace par une commande vide
+    node->command = Command();
+    node->next.store(nullptr, std::memory_order_relaxed);
+    pushFree(node);
+}
+
+void CommandQueue::pushFree(Node* node){
+    uint64_t top = freeTop.load(std::memory_order_relaxed);
+    uint64_t pushed;
+    do {
+        node->nextFree.store(static_cast<uint32_t>(top), std::memory_order_relaxed);
+        pushed = ((top >> 32) + 1) << 32 | (uint64_t(node->slot) + 1);
+    } while (!freeTop.compare_exchange_weak(top, pushed, std::memory_order_release, std::memory_order_relaxed));
+}
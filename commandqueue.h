@@ -0,0 +1,178 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <variant>
+#include <vector>
+#include "particle.h"
+#include "simulationconfig.h"
+
+/**
+ * @brief Adds particles to the simulation (see `Context::addParticles`).
+ */
+struct AddParticlesCommand {
+    std::vector<Particle> particles;  ///< The particles to add.
+};
+
+/**
+ * @brief Restores the simulation to its initial state (see `Context::reset`).
+ */
+struct ResetCommand {};
+
+/**
+ * @brief Moves a collider (see `Context::moveCollider`).
+ */
+struct MoveColliderCommand {
+    size_t index;  ///< Index of the collider, ignored if it no longer exists.
+    Vec2 offset;   ///< The displacement to apply.
+};
+
+/**
+ * @brief Replaces the configuration of the simulation (see `Context::setConfig`).
+ */
+struct ChangeConfigCommand {
+    SimulationConfig config;  ///< The new configuration.
+};
+
+/**
+ * @brief Starts or continues dragging a particle towards a target position.
+ *
+ * The particle is given, at every step, the velocity that brings it to the
+ * target, so it still collides on its way and keeps its speed when released.
+ */
+struct DragParticleCommand {
+    std::optional<size_t> index;  ///< Index of the particle, ignored if it was removed, or empty to only move the target of the dragged particle.
+    Vec2 target;                  ///< Position the particle is pulled to.
+};
+
+/**
+ * @brief Stops dragging the particle.
+ */
+struct ReleaseParticleCommand {};
+
+/// A request to modify the simulation, applied between two steps.
+using Command = std::variant<AddParticlesCommand, ResetCommand, MoveColliderCommand, ChangeConfigCommand,
+                             DragParticleCommand, ReleaseParticleCommand>;
+
+/**
+ * @brief Lock-free multiple-producer single-consumer queue of commands.
+ *
+ * Any thread (the GUI, a script, a network client) may `push` commands
+ * concurrently: a push is a single atomic exchange and never waits for the
+ * consumer. Only the thread stepping the simulation may `pop`, which is also
+ * wait-free. Commands are popped in the order their pushes took effect.
+ *
+ * The queue is an intrusive linked list with a stub node (Vyukov's MPSC
+ * queue): producers swing `head` and then link the previous node, and the
+ * consumer follows the links from `tail`. A node whose link is not yet
+ * published is simply seen at the next pop.
+ *
+ * Nodes are allocated by blocks and recycled through a lock-free free list,
+ * so that once the queue has seen its largest backlog a push only allocates
+ * what the command itself owns. The free list is a stack of node slots
+ * whose top carries a tag, incremented at every change, against the ABA
+ * problem. Beyond `maxBlocks` blocks, nodes are allocated one by one.
+ */
+class CommandQueue {
+public:
+    /**
+     * @brief Constructs an empty queue.
+     */
+    CommandQueue();
+
+    /**
+     * @brief Destroys the queue and the commands that were never popped.
+     */
+    ~CommandQueue();
+
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+
+    /**
+     * @brief Appends a command. Safe to call from any thread.
+     *
+     * @param command The command, moved into the queue.
+     */
+    void push(Command command);
+
+    /**
+     * @brief Removes the oldest command. Must only be called by the consumer thread.
+     *
+     * @param command Receives the command.
+     * @return False if the queue is empty.
+     */
+    bool pop(Command& command);
+
+    /**
+     * @brief Pops and applies the commands pushed before the call. Consumer thread only.
+     *
+     * Commands pushed while draining are left for the next drain, so that
+     * busy producers cannot hold the consumer forever.
+     *
+     * @param apply Function called with each command, in order.
+     * @return The number of commands applied.
+     */
+    template <typename Visitor>
+    size_t drain(Visitor&& apply) {
+        Node* last = head.load(std::memory_order_acquire);
+        size_t applied = 0;
+        Command command;
+        while (tail != last && pop(command)){
+            apply(command);
+            applied++;
+        }
+        return applied;
+    }
+
+private:
+    static constexpr uint32_t blockSize = 64;   ///< Nodes per block.
+    static constexpr uint32_t maxBlocks = 64;   ///< Blocks that can be allocated.
+    static constexpr uint32_t noSlot = UINT32_MAX;  ///< Slot of a node allocated alone.
+
+    /// A queued command.
+    struct Node {
+        std::atomic<Node*> next{nullptr};     ///< The node pushed after this one.
+        Command command;                      ///< The command, moved out when popped.
+        uint32_t slot = noSlot;               ///< Index of the node in the blocks, `noSlot` if allocated alone.
+        std::atomic<uint32_t> nextFree{0};    ///< Slot + 1 of the next free node, 0 at the bottom of the free list.
+    };
+
+    /**
+     * @brief Takes a node from the free list, allocating a block if it is empty. Any thread.
+     *
+     * @return A node whose `next` is null.
+     */
+    Node* acquireNode();
+
+    /**
+     * @brief Gives a node back to the free list, or deletes it if it was allocated alone.
+     *
+     * @param node A node no longer reachable from the queue.
+     */
+    void releaseNode(Node* node);
+
+    /**
+     * @brief Pushes a pooled node on the free list.
+     *
+     * @param node The node, with a valid slot.
+     */
+    void pushFree(Node* node);
+
+    /**
+     * @brief Gets the node of a slot.
+     *
+     * @param slot Index of the node in the blocks.
+     * @return The node.
+     */
+    Node* nodeAt(uint32_t slot) const;
+
+    std::atomic<Node*> head;  ///< Last pushed node, swung by the producers.
+    Node* tail;               ///< Node of the last popped command (initially the stub), owned by the consumer.
+    std::atomic<uint64_t> freeTop{0};        ///< Tag in the high half, slot + 1 of the top free node in the low half.
+    std::atomic<Node*> blocks[maxBlocks] = {};  ///< Blocks of nodes, published before their nodes are freed.
+    std::atomic<uint32_t> blockCount{0};     ///< Number of blocks claimed.
+};
+
+#endif // COMMANDQUEUE_H
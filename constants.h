@@ -5,28 +5,21 @@
  * @file constants.h
  * @brief Defines global constants used throughout the simulation.
  *
- * This file contains constants for physical parameters and simulation settings
+ * This file contains constants for physical parameters and simulation settings.
+ * Parameters that can be tuned per scene live in `SimulationConfig`.
  */
 
 /**
- * @brief Gravitational acceleration (m/s²).
+ * @brief Speed under which a particle is considered at rest (units/s).
  *
- * Represents the gravitational constant used in the simulation.
+ * A particle staying under this speed for `sleep_frames` consecutive steps
+ * falls asleep and is no longer integrated until something moves it.
  */
-#define g 9.8
+#define sleep_speed 0.5
 
 /**
- * @brief Maximum allowed speed for particles (units/s).
- *
- * Serves as a cap on particle velocity to prevent unrealistic behaviors.
- */
-#define max_speed 60
-
-/**
- * @brief Time step duration for the simulation (ms).
- *
- * Used to control the frequency of updates in the simulation loop.
+ * @brief Number of consecutive resting steps before a particle falls asleep.
  */
-#define tau 16.0
+#define sleep_frames 30
 
 #endif // CONSTANTS_H
@@ -0,0 +1,30 @@
+#include "contactconstraint.h"
+
+ContactConstraint::ContactConstraint(Vec2 normal, float C, Particle* particle1, Particle* particle2)
+    : normal(normal), C(C), particle1(particle1), particle2(particle2),
+      normalSpeed((particle1->getVelocity() - particle2->getVelocity()).dot(normal)) {}
+
+const Vec2& ContactConstraint::getNormal() const{
+    return normal;
+}
+
+float ContactConstraint::getC() const{
+    return C;
+}
+
+Particle* ContactConstraint::getParticle1() const{
+    return particle1;
+}
+
+Particle* ContactConstraint::getParticle2() const{
+    return particle2;
+}
+
+void ContactConstraint::changeParticles(Particle* newParticle1, Particle* newParticle2){
+    particle1 = newParticle1;
+    particle2 = newParticle2;
+}
+
+float ContactConstraint::getNormalSpeed() const{
+    return normalSpeed;
+}
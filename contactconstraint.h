@@ -0,0 +1,87 @@
+#ifndef CONTACTCONSTRAINT_H
+#define CONTACTCONSTRAINT_H
+
+#include "vec2.h"
+#include "particle.h"
+
+/**
+ * @brief Represents a contact constraint between two particles.
+ *
+ * Unlike `StaticConstraint`, which only moves a single particle, the
+ * `ContactConstraint` is generated once per pair of overlapping particles
+ * and moves both of them, each one proportionally to its inverse mass.
+ */
+class ContactConstraint {
+private:
+    Vec2 normal;            ///< Unit contact normal, pointing from `particle2` towards `particle1`.
+    float C;                ///< Constraint value (negative penetration depth).
+    Particle* particle1;    ///< First particle of the pair.
+    Particle* particle2;    ///< Second particle of the pair.
+    float normalSpeed;      ///< Relative speed of `particle1` along the normal before the projection (negative when approaching).
+
+public:
+    /**
+     * @brief Constructs a new `ContactConstraint`.
+     *
+     * The normal speed is taken from the current (predicted) velocities of
+     * the particles.
+     *
+     * @param normal Unit contact normal, pointing from `particle2` towards `particle1`.
+     * @param C Constraint value (negative when the particles overlap).
+     * @param particle1 Pointer to the first particle of the pair.
+     * @param particle2 Pointer to the second particle of the pair.
+     */
+    ContactConstraint(Vec2 normal, float C, Particle* particle1, Particle* particle2);
+
+    /**
+     * @brief Default destructor for `ContactConstraint`.
+     */
+    ~ContactConstraint() = default;
+
+    /**
+     * @brief Retrieves the unit contact normal.
+     *
+     * @return A constant reference to the normal, pointing from `particle2` towards `particle1`.
+     */
+    const Vec2& getNormal() const;
+
+    /**
+     * @brief Retrieves the constraint value.
+     *
+     * @return The (negative) penetration depth of the contact.
+     */
+    float getC() const;
+
+    /**
+     * @brief Retrieves the first particle of the pair.
+     *
+     * @return A pointer to the first particle.
+     */
+    Particle* getParticle1() const;
+
+    /**
+     * @brief Retrieves the second particle of the pair.
+     *
+     * @return A pointer to the second particle.
+     */
+    Particle* getParticle2() const;
+
+    /**
+     * @brief Changes the particles of the pair.
+     *
+     * Used to fix up the constraint when the particle storage is compacted.
+     *
+     * @param newParticle1 Pointer to the new location of the first particle.
+     * @param newParticle2 Pointer to the new location of the second particle.
+     */
+    void changeParticles(Particle* newParticle1, Particle* newParticle2);
+
+    /**
+     * @brief Retrieves the relative speed along the normal before the projection.
+     *
+     * @return The normal speed, negative when the particles were approaching each other.
+     */
+    float getNormalSpeed() const;
+};
+
+#endif // CONTACTCONSTRAINT_H
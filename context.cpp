@@ -1,9 +1,119 @@
 #include "context.h"
-#include "constants.h"
 #include "plancollider.h"
 #include "spherecollider.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 
-Context::Context() {
+namespace {
+//Vide les tampons par morceau en conservant leur capacité
+template <typename Chunks>
+void prepareChunks(Chunks& chunks, size_t count){
+    if (chunks.size() < count){
+        chunks.resize(count);
+    }
+    for (auto& chunk: chunks){
+        chunk.clear();
+    }
+}
+
+//Agrandit les tampons par morceau sans les vider, pour ceux qui s'accumulent sur plusieurs passes
+template <typename Chunks>
+void growChunks(Chunks& chunks, size_t count){
+    if (chunks.size() < count){
+        chunks.resize(count);
+    }
+}
+
+//Concatène les tampons dans l'ordre des morceaux : le résultat ne dépend pas de l'ordonnancement
+template <typename Chunks, typename Out>
+void gatherChunks(const Chunks& chunks, Out& out){
+    out.clear();
+    for (const auto& chunk: chunks){
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+}
+
+//Fonctionnalités compilées dans les noyaux fusionnés : les branches inutiles disparaissent
+template <bool ClampSpeed, bool ForceFields>
+struct StepPolicy {
+    static constexpr bool clampSpeed = ClampSpeed;    //Vitesse bornée à config.maxSpeed
+    static constexpr bool forceFields = ForceFields;  //Champs de force à évaluer en plus de la gravité
+};
+
+//Borne la norme d'une vitesse (chemin non fusionné)
+Vec2 clampedVelocity(const Vec2& velocity, float maxSpeed){
+    float speed = velocity.norm();
+    return speed > maxSpeed ? velocity * (maxSpeed / speed) : velocity;
+}
+
+//Contact avec un collider cinématique, vu depuis le collider : la particule part du point où il l'aurait emportée
+std::optional<StaticConstraint> kinematicContact(const Collider& collider, Particle& particle){
+    Particle carried = particle;
+    carried.changePos(collider.carry(particle.getPos()));
+    std::optional<StaticConstraint> constraint = collider.checkContact(carried);
+    if (constraint){
+        constraint->changeParticle(&particle);
+    }
+    return constraint;
+}
+
+//Propriétés de contact de deux matériaux : moyenne géométrique des frottements, restitution maximale
+Material combined(const Material& a, const Material& b){
+    Material material;
+    material.staticFriction = std::sqrt(a.staticFriction * b.staticFriction);
+    material.dynamicFriction = std::sqrt(a.dynamicFriction * b.dynamicFriction);
+    material.restitution = std::max(a.restitution, b.restitution);
+    return material;
+}
+
+//Variation de la vitesse relative d'un contact : rebond le long de la normale, frottement de Coulomb le long de la tangente
+Vec2 responseChange(const Vec2& velocity, const Vec2& normal, float approachSpeed, float correctionSpeed,
+                    const Material& material, float restingSpeed){
+    float normalSpeed = velocity.dot(normal);
+    //La vitesse normale vaut le rebond : la séparation due à la correction d'une pénétration est absorbée
+    float bounce = approachSpeed < -restingSpeed ? -material.restitution * approachSpeed : 0;
+    Vec2 change = normal * (bounce - normalSpeed);
+    Vec2 tangent = velocity - normal * normalSpeed;
+    float tangentSpeed = tangent.norm();
+    if (tangentSpeed > 0){
+        if (tangentSpeed <= material.staticFriction * correctionSpeed){
+            change = change - tangent;
+        } else {
+            change = change - tangent * std::min(1.0f, material.dynamicFriction * correctionSpeed / tangentSpeed);
+        }
+    }
+    return change;
+}
+
+//Noms des étapes d'un pas, dans l'ordre de Context::StepStage
+constexpr const char* stepStageNames[] = {
+    "commands", "emission", "drag", "ghosts", "kinematic", "prediction",
+    "statics", "broadphase", "contacts", "projection", "finalize",
+    "removals", "compaction"
+};
+}
+
+template <typename Work>
+void Context::runStage(StepStage stage, Work&& work){
+    if (!allocationTracking){
+        work();
+        return;
+    }
+    AllocationCount before = AllocationCounter::get();
+    work();
+    //Les étapes des sous-pas s'additionnent
+    AllocationCount made = AllocationCounter::get().since(before);
+    stageAllocations[stage].count.allocations += made.allocations;
+    stageAllocations[stage].count.bytes += made.bytes;
+}
+
+Context::Context(): threadPool(std::make_unique<ThreadPool>()) {
+    buildStepGraph();
+    selectKernels();
     initializeExampleConfiguration();
 }
 
@@ -12,8 +122,8 @@ void Context::initializeExampleConfiguration() {
     Vec2 null(0, 0);
     float radius_part = 50;
 
-    particles.push_back(std::make_unique<Particle>(Vec2(50, 100), null, radius_part, 100));
-    particles.push_back(std::make_unique<Particle>(Vec2(450, 100), null, radius_part, 100));
+    particles.emplace_back(Vec2(50, 100), null, radius_part, 100);
+    particles.emplace_back(Vec2(450, 100), null, radius_part, 100);
 
     // Plans
     colliders.push_back(std::make_unique<PlanCollider>(Vec2(300, 400), Vec2(0, -1)));
@@ -22,89 +132,1219 @@ void Context::initializeExampleConfiguration() {
     // Spheres
     colliders.push_back(std::make_unique<SphereCollider>(Vec2(600, 400), 100));
     colliders.push_back(std::make_unique<SphereCollider>(Vec2(500, 200), 30));
+
+    refreshColliderLists();
+
+    // Les particules qui sortent largement de la fenêtre sont supprimées
+    worldBounds = AABB{Vec2(-1000, -1000), Vec2(2000, 2000)};
 }
 
-const std::vector<std::unique_ptr<Particle>>& Context::getParticles() const{
+const std::vector<Particle>& Context::getParticles() const{
     return particles;
 }
 const std::vector<std::unique_ptr<Collider>>& Context::getColliders() const{
     return colliders;
 }
 
+uint64_t Context::getColliderRevision() const{
+    return colliderRevision;
+}
+
+uint64_t Context::getEnvironmentRevision() const{
+    return environmentRevision;
+}
+
+uint64_t Context::getResetCount() const{
+    return resetCount;
+}
+
 
 void Context::addParticle(Particle&& particle){
     //std::move et pas une R-Value reference en paramètre car dans l'appel
-    //de std::make_unique, particle devient une l-value
-    particles.push_back(std::make_unique<Particle>(std::move(particle)));
+    //de push_back, particle devient une l-value
+    broadphaseCurrent = false;
+    if (!freeList.empty()){
+        particles[freeList.back()] = std::move(particle);
+        freeList.pop_back();
+        return;
+    }
+    particles.push_back(std::move(particle));
+    freeList.reserve(particles.capacity());
+}
+
+void Context::findParticlesInBox(const AABB& box, std::vector<size_t>& indices) const{
+    indices.clear();
+    auto visit = [&](size_t i) {
+        //La grille peut encore indexer les fantômes du dernier pas
+        if (i >= particles.size()){
+            return;
+        }
+        const Particle& particle = particles[i];
+        if (particle.isAlive() && AABB::around(particle.getPos(), particle.getRadius()).overlaps(box)){
+            indices.push_back(i);
+        }
+    };
+    if (broadphaseCurrent){
+        //La grille est construite sur les positions prédites : une cellule de marge couvre
+        //le rayon des particules et leur déplacement pendant la projection
+        Vec2 margin(broadphase.getCellSize(), broadphase.getCellSize());
+        if (broadphase.forEachInBox(box.min - margin, box.max + margin, visit)){
+            return;
+        }
+    }
+    for (size_t i = 0; i < particles.size(); ++i){
+        visit(i);
+    }
+}
+
+void Context::findParticlesInCircle(const Vec2& center, float radius, std::vector<size_t>& indices) const{
+    findParticlesInBox(AABB::around(center, radius), indices);
+    indices.erase(std::remove_if(indices.begin(), indices.end(), [&](size_t i) {
+        const Particle& particle = particles[i];
+        float reach = radius + particle.getRadius();
+        Vec2 offset = particle.getPos() - center;
+        return offset.dot(offset) > reach * reach;
+    }), indices.end());
+}
+
+std::optional<size_t> Context::findNearestParticle(const Vec2& point, float maxDistance) const{
+    std::vector<size_t> candidates;
+    findParticlesInBox(AABB::around(point, maxDistance), candidates);
+    std::optional<size_t> nearest;
+    float nearestDistance = maxDistance;
+    for (size_t i: candidates){
+        //Distance au disque : nulle quand le point est dans la particule
+        const Particle& particle = particles[i];
+        float distance = std::max((particle.getPos() - point).norm() - particle.getRadius(), 0.0f);
+        if (distance <= nearestDistance && (!nearest || distance < nearestDistance)){
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+std::optional<RayHit> Context::rayCast(const Vec2& origin, const Vec2& direction, float maxDistance) const{
+    Vec2 unit = direction.normalize();
+    std::optional<RayHit> best;
+    auto segmentBox = [&](float from, float to) {
+        Vec2 a = origin + unit * from;
+        Vec2 b = origin + unit * to;
+        return AABB{Vec2(std::min(a.getx(), b.getx()), std::min(a.gety(), b.gety())),
+                    Vec2(std::max(a.getx(), b.getx()), std::max(a.gety(), b.gety()))};
+    };
+
+    //Les colliders bornés passent par leur hiérarchie, les autres sont tous testés
+    auto testCollider = [&](const Collider* collider) {
+        Vec2 normal(0, 0);
+        float reach = best ? best->distance : maxDistance;
+        std::optional<float> t = collider->rayCast(origin, unit, reach, normal);
+        if (t && (!best || *t < best->distance)){
+            size_t index = std::find_if(colliders.begin(), colliders.end(),
+                                        [&](const auto& owned) { return owned.get() == collider; }) - colliders.begin();
+            best = RayHit{*t, origin + unit * *t, normal, false, index};
+        }
+    };
+    colliderBvh.query(segmentBox(0, maxDistance), [&](size_t item) { testCollider(boundedColliders[item]); });
+    for (const Collider* collider: unboundedColliders){
+        testCollider(collider);
+    }
+
+    //Particules : le rayon est parcouru par tronçons de quelques cellules, et la
+    //recherche s'arrête au premier tronçon contenant un impact
+    float stretch = broadphaseCurrent && std::isfinite(maxDistance) ? 8 * broadphase.getCellSize() : maxDistance;
+    std::vector<size_t> candidates;
+    for (float from = 0; from < maxDistance; from += stretch){
+        float to = std::min(from + stretch, maxDistance);
+        if (best && best->distance < from){
+            break;
+        }
+        findParticlesInBox(segmentBox(from, to), candidates);
+        for (size_t i: candidates){
+            const Particle& particle = particles[i];
+            std::optional<float> t = rayDiscIntersection(origin, unit, particle.getPos(), particle.getRadius());
+            if (t && *t <= maxDistance && (!best || *t < best->distance)){
+                Vec2 point = origin + unit * *t;
+                Vec2 outward = point - particle.getPos();
+                Vec2 normal = outward.norm() > 0 ? outward.normalize() : unit * -1.0f;
+                best = RayHit{*t, point, normal, true, i};
+            }
+        }
+    }
+    return best;
+}
+
+size_t Context::getAliveParticleCount() const{
+    return particles.size() - freeList.size();
+}
+
+void Context::removeParticle(size_t index, bool wakeNeighbours){
+    if (index < particles.size() && particles[index].isAlive()){
+        particles[index].kill();
+        freeList.push_back(index);
+        if (wakeNeighbours){
+            wakeParticlesInBox(AABB::around(particles[index].getPos(), particles[index].getRadius()));
+        }
+        if (draggedParticle == index){
+            draggedParticle.reset();
+        }
+    }
+}
+
+void Context::addKillVolume(const AABB& volume){
+    killVolumes.push_back(volume);
+}
+
+void Context::clearKillVolumes(){
+    killVolumes.clear();
+}
+
+void Context::setWorldBounds(const std::optional<AABB>& bounds){
+    worldBounds = bounds;
+}
+
+void Context::applyDrag(float dt){
+    if (!draggedParticle){
+        return;
+    }
+    Particle& particle = particles[*draggedParticle];
+    if (!particle.isAlive()){
+        draggedParticle.reset();
+        return;
+    }
+    //La prédiction amène la particule sur la cible (à la gravité près), les contacts restent résolus
+    particle.changeVelocity((dragTarget - particle.getPos()) / dt);
+    particle.updateSleep(std::numeric_limits<float>::infinity());
+}
+
+void Context::setGhostParticles(std::vector<Particle>&& ghosts){
+    pendingGhosts = std::move(ghosts);
+}
+
+void Context::appendGhosts(){
+    ghostBegin = particles.size();
+    ghostCount = pendingGhosts.size();
+    if (ghostCount == 0){
+        return;
+    }
+    particles.insert(particles.end(), std::make_move_iterator(pendingGhosts.begin()), std::make_move_iterator(pendingGhosts.end()));
+    pendingGhosts.clear();
+}
+
+void Context::dropGhosts(){
+    if (ghostCount == 0){
+        return;
+    }
+    //Les fantômes sont en fin de tableau : un pointeur au-delà de firstGhost désigne un fantôme
+    const Particle* firstGhost = particles.data() + ghostBegin;
+    staticConstraints.erase(std::remove_if(staticConstraints.begin(), staticConstraints.end(), [&](StaticConstraint& constraint) {
+        return constraint.getParticle() >= firstGhost;
+    }), staticConstraints.end());
+    contactConstraints.erase(std::remove_if(contactConstraints.begin(), contactConstraints.end(), [&](ContactConstraint& constraint) {
+        return constraint.getParticle1() >= firstGhost || constraint.getParticle2() >= firstGhost;
+    }), contactConstraints.end());
+    for (auto& chunk: removalChunks){
+        chunk.erase(std::remove_if(chunk.begin(), chunk.end(), [&](size_t index) { return index >= ghostBegin; }), chunk.end());
+    }
+    particles.erase(particles.begin() + ghostBegin, particles.end());
+    ghostCount = 0;
+}
+
+void Context::reserveParticles(size_t count){
+    particles.reserve(count);
+    freeList.reserve(particles.capacity());
+}
+
+void Context::addParticles(std::vector<Particle>&& batch){
+    broadphaseCurrent = false;
+    //On remplit d'abord les emplacements libérés
+    size_t next = 0;
+    while (next < batch.size() && !freeList.empty()){
+        particles[freeList.back()] = std::move(batch[next++]);
+        freeList.pop_back();
+    }
+    size_t needed = particles.size() + batch.size() - next;
+    if (needed > particles.capacity()){
+        //Croissance géométrique : réserver exactement rendrait les insertions répétées quadratiques
+        particles.reserve(std::max(needed, 2 * particles.capacity()));
+        freeList.reserve(particles.capacity());
+    }
+    particles.insert(particles.end(), std::make_move_iterator(batch.begin() + next), std::make_move_iterator(batch.end()));
+    batch.clear();
+}
+
+void Context::addEmitter(std::unique_ptr<Emitter> emitter){
+    emitters.push_back(std::move(emitter));
+}
+
+void Context::clearEmitters(){
+    emitters.clear();
+}
+
+void Context::addCollider(std::unique_ptr<Collider> collider){
+    colliders.push_back(std::move(collider));
+    refreshColliderLists();
+    if (staticSdf.isBaked() && colliders.back()->isBakeable() && !colliders.back()->isMoving()){
+        staticSdf.rebake(bakedColliders, staticSdf.influenceOf(*colliders.back()), *threadPool);
+    }
+}
+
+void Context::moveCollider(size_t index, const Vec2& offset){
+    colliderRevision++;
+    environmentRevision++;
+    Collider& collider = *colliders[index];
+    std::optional<AABB> before = staticSdf.influenceOf(collider);
+    std::optional<AABB> boundsBefore = collider.getBounds();
+    collider.translate(offset);
+    //Seule la branche de la hiérarchie contenant le collider est réajustée
+    auto slot = std::find(boundedColliders.begin(), boundedColliders.end(), &collider);
+    std::optional<AABB> bounds = collider.getBounds();
+    if (slot != boundedColliders.end() && bounds){
+        colliderBvh.refit(slot - boundedColliders.begin(), *bounds);
+    }
+    //Les particules posées sur l'ancienne position ou touchées par la nouvelle reprennent leur mouvement
+    if (boundsBefore && bounds){
+        wakeParticlesInBox(boundsBefore->merged(*bounds));
+    } else {
+        wakeAllParticles();
+    }
+    if (staticSdf.isBaked() && collider.isBakeable() && !collider.isMoving()){
+        std::optional<AABB> after = staticSdf.influenceOf(collider);
+        std::optional<AABB> dirty;
+        if (before && after){
+            dirty = before->merged(*after);
+        }
+        staticSdf.rebake(bakedColliders, dirty, *threadPool);
+    }
+}
+
+void Context::advanceKinematicColliders(float dt){
+    if (kinematicColliders.empty()){
+        return;
+    }
+    colliderRevision++;
+    for (const auto& [collider, slot]: kinematicColliders){
+        std::optional<AABB> before = collider->getBounds();
+        collider->advance(dt);
+        if (!collider->hasMoved()){
+            continue;
+        }
+        //Boîte balayée : les particules traversées pendant le pas sont testées, et réveillées
+        if (slot != Bvh::npos && before){
+            AABB swept = before->merged(*collider->getBounds());
+            colliderBvh.refit(slot, swept);
+            wakeParticlesInBox(swept);
+        } else {
+            wakeAllParticles();
+        }
+    }
+}
+
+void Context::bakeStaticColliders(const AABB& region, float cellSize, float band){
+    refreshColliderLists();
+    staticSdf.bake(bakedColliders, region, cellSize, band, *threadPool);
+}
+
+void Context::disableBakedColliders(){
+    staticSdf.clear();
+}
+
+void Context::wakeParticlesInBox(const AABB& box){
+    auto wake = [&](size_t i) {
+        if (i >= particles.size()){
+            return;
+        }
+        Particle& particle = particles[i];
+        if (particle.isAlive() && particle.isAsleep() && AABB::around(particle.getPos(), particle.getRadius()).overlaps(box)){
+            particle.wakeUp();
+        }
+    };
+    //Même marge que findParticlesInBox : la grille indexe les positions prédites
+    if (broadphaseCurrent){
+        Vec2 margin(broadphase.getCellSize(), broadphase.getCellSize());
+        if (broadphase.forEachInBox(box.min - margin, box.max + margin, wake)){
+            return;
+        }
+    }
+    for (size_t i = 0; i < particles.size(); ++i){
+        wake(i);
+    }
+}
+
+void Context::wakeAllParticles(){
+    for (auto& particle: particles){
+        particle.wakeUp();
+    }
+}
+
+void Context::refreshColliderLists(){
+    colliderRevision++;
+    bakedColliders.clear();
+    bakedFilters.clear();
+    bakedMaterial.reset();
+    bool mixedMaterials = false;
+    boundedColliders.clear();
+    unboundedColliders.clear();
+    kinematicColliders.clear();
+    std::vector<AABB> boxes;
+    for (const auto& collider: colliders){
+        if (collider->isKinematic()){
+            kinematicColliders.emplace_back(collider.get(), collider->getBounds() ? boundedColliders.size() : Bvh::npos);
+        }
+        //La grille ne connaît pas la vitesse des colliders : ceux qui bougent sont testés directement
+        if (collider->isBakeable() && !collider->isMoving()){
+            bakedColliders.push_back(collider.get());
+            const CollisionFilter& filter = collider->getFilter();
+            bool known = std::any_of(bakedFilters.begin(), bakedFilters.end(), [&](const CollisionFilter& other) {
+                return other.layer == filter.layer && other.mask == filter.mask;
+            });
+            if (!known){
+                bakedFilters.push_back(filter);
+            }
+            if (!bakedMaterial){
+                bakedMaterial = collider->getMaterial();
+            } else if (*bakedMaterial != collider->getMaterial()){
+                mixedMaterials = true;
+            }
+        }
+        std::optional<AABB> bounds = collider->getBounds();
+        if (bounds){
+            boundedColliders.push_back(collider.get());
+            boxes.push_back(*bounds);
+        } else {
+            unboundedColliders.push_back(collider.get());
+        }
+    }
+    //La grille ne garde pas le collider le plus proche : elle ne sert qu'à un seul matériau
+    if (mixedMaterials){
+        bakedMaterial.reset();
+    }
+    colliderBvh.build(boxes);
+}
+
+void Context::addForceField(std::unique_ptr<ForceField> field){
+    forceFields.push_back(std::move(field));
+    selectKernels();
+    environmentRevision++;
+    wakeAllParticles();
+}
+
+void Context::clearForceFields(){
+    forceFields.clear();
+    selectKernels();
+    environmentRevision++;
+    wakeAllParticles();
+}
+
+const std::vector<std::unique_ptr<ForceField>>& Context::getForceFields() const{
+    return forceFields;
+}
+
+MaterialId Context::addMaterial(const Material& material){
+    if (materials.size() > std::numeric_limits<MaterialId>::max()){
+        throw std::runtime_error("Table des matériaux pleine");
+    }
+    materials.push_back(material);
+    contactResponse = contactResponse || material.hasResponse();
+    selectKernels();
+    return static_cast<MaterialId>(materials.size() - 1);
+}
+
+void Context::changeMaterial(MaterialId id, const Material& material){
+    if (id >= materials.size()){
+        throw std::runtime_error("Matériau inconnu");
+    }
+    materials[id] = material;
+    contactResponse = std::any_of(materials.begin(), materials.end(), [](const Material& m) { return m.hasResponse(); });
+    selectKernels();
+    environmentRevision++;
+    wakeAllParticles();
+}
+
+const std::vector<Material>& Context::getMaterials() const{
+    return materials;
+}
+
+const Material& Context::materialOf(MaterialId id) const{
+    return id < materials.size() ? materials[id] : materials.front();
+}
+
+void Context::clear(){
+    particles.clear();
+    freeList.clear();
+    broadphaseCurrent = false;
+    broadphase.clear();
+    stepsSinceCompaction = 0;
+    draggedParticle.reset();
+    colliders.clear();
+    refreshColliderLists();
+    staticSdf.clear();
+    emitters.clear();
+    killVolumes.clear();
+    worldBounds.reset();
+    staticConstraints.clear();
+    contactConstraints.clear();
+    candidatePairs.clear();
+}
+
+void Context::reset(){
+    clear();
+    clearForceFields();
+    materials.assign(1, Material());
+    contactResponse = false;
+    selectKernels();
+    setConfig(SimulationConfig());
+    initializeExampleConfiguration();
+    resetCount++;
+}
+
+CommandQueue& Context::getCommandQueue(){
+    return commands;
+}
+
+void Context::applyCommands(){
+    commands.drain([this](Command& command) {
+        std::visit([this](auto& c) {
+            using T = std::decay_t<decltype(c)>;
+            if constexpr (std::is_same_v<T, AddParticlesCommand>){
+                addParticles(std::move(c.particles));
+            } else if constexpr (std::is_same_v<T, ResetCommand>){
+                reset();
+            } else if constexpr (std::is_same_v<T, MoveColliderCommand>){
+                //L'indice a pu devenir invalide entre l'envoi et l'application
+                if (c.index < colliders.size()){
+                    moveCollider(c.index, c.offset);
+                }
+            } else if constexpr (std::is_same_v<T, ChangeConfigCommand>){
+                setConfig(c.config);
+            } else if constexpr (std::is_same_v<T, DragParticleCommand>){
+                //Sans indice, seule la cible bouge : l'indice a pu changer depuis la sélection
+                if (!c.index){
+                    dragTarget = c.target;
+                } else if (*c.index < particles.size() && particles[*c.index].isAlive()){
+                    draggedParticle = c.index;
+                    dragTarget = c.target;
+                }
+            } else {
+                draggedParticle.reset();
+            }
+        }, command);
+    });
+}
+
+void Context::setThreadCount(unsigned threadCount){
+    threadPool = std::make_unique<ThreadPool>(threadCount);
+}
+
+unsigned Context::getThreadCount() const{
+    return threadPool->getThreadCount();
+}
+
+void Context::setFusedIntegration(bool fused){
+    fusedIntegration = fused;
+    selectKernels();
+}
+
+const SimulationConfig& Context::getConfig() const{
+    return config;
+}
+
+void Context::setConfig(const SimulationConfig& newConfig){
+    bool collisionsChanged = newConfig.particleCollisions != config.particleCollisions;
+    config = newConfig;
+    if (collisionsChanged){
+        candidatePairs.clear();
+        contactConstraints.clear();
+        skippedPairChunks.clear();
+        broadphaseCurrent = false;
+        buildStepGraph();
+    }
+    selectKernels();
+    environmentRevision++;
+    wakeAllParticles();
+}
+
+const StepStats& Context::getStepStats() const{
+    return stepStats;
+}
+
+void Context::setAllocationTracking(bool enabled){
+    allocationTracking = enabled;
+    stageAllocations.clear();
+    if (enabled){
+        static_assert(std::size(stepStageNames) == StepStageCount, "Un nom par étape");
+        for (const char* name: stepStageNames){
+            stageAllocations.push_back(StageAllocations{name, AllocationCount()});
+        }
+    }
+}
+
+const std::vector<StageAllocations>& Context::getStageAllocations() const{
+    return stageAllocations;
+}
+
+void Context::buildStepGraph(){
+    using TaskId = TaskGraph::TaskId;
+    stepGraph = TaskGraph();
+    TaskId prediction = stepGraph.addTask([this]() { runStage(PredictionStage, [this]() { predict(stepDt); }); });
+    TaskId statics    = stepGraph.addTask([this]() { runStage(StaticStage, [this]() { addStaticContactConstraints(); }); });
+    std::optional<TaskId> contacts;
+    if (config.particleCollisions){
+        TaskId broad = stepGraph.addTask([this]() { runStage(BroadphaseStage, [this]() { buildBroadphase(); }); });
+        contacts = stepGraph.addTask([this]() { runStage(ContactStage, [this]() { addParticleContactConstraints(); }); });
+        stepGraph.addDependency(prediction, broad);
+        stepGraph.addDependency(broad, *contacts);
+    }
+    TaskId projection = stepGraph.addTask([this]() { runStage(ProjectionStage, [this]() { projectConstraints(); }); });
+    TaskId writeBack  = stepGraph.addTask([this]() { runStage(FinalizeStage, [this]() { finalize(stepDt); }); });
+    stepGraph.addDependency(prediction, statics);
+    stepGraph.addDependency(statics, projection);
+    stepGraph.addDependency(projection, writeBack);
+
+    //Les colliders et les paires de particules sont indépendants jusqu'à la projection
+    if (contacts){
+        stepGraph.addDependency(*contacts, projection);
+    }
+}
+
+template <typename Policy>
+void Context::useFusedKernels(){
+    predictKernel = &Context::predictFused<Policy>;
+    //La réponse des contacts doit passer entre la mise à jour des vitesses et celle du sommeil
+    finalizeKernel = contactResponse ? &Context::finalizeUnfused : &Context::finalizeFused<Policy>;
+}
+
+void Context::selectKernels(){
+    if (!fusedIntegration){
+        predictKernel = &Context::predictUnfused;
+        finalizeKernel = &Context::finalizeUnfused;
+        return;
+    }
+    bool fields = !forceFields.empty();
+    if (config.clampSpeed){
+        fields ? useFusedKernels<StepPolicy<true, true>>() : useFusedKernels<StepPolicy<true, false>>();
+    } else {
+        fields ? useFusedKernels<StepPolicy<false, true>>() : useFusedKernels<StepPolicy<false, false>>();
+    }
 }
 
 void Context::updatePhysicalSystem(float dt){
-    applyExternalForce(dt);
+    for (auto& stage: stageAllocations){
+        stage.count = AllocationCount();
+    }
+    runStage(CommandStage, [this]() { applyCommands(); });
+    runStage(EmissionStage, [&]() { emitParticles(dt); });
+    runStage(DragStage, [&]() { applyDrag(dt); });
+    runStage(GhostStage, [this]() { appendGhosts(); });
+
+    const int substeps = std::max(1, config.substeps);
+    stepDt = dt / substeps;
+    //Les paires du premier sous-pas servent tout le pas : marge de deux déplacements maximaux
+    broadphase.setMargin(substeps > 1 ? 2 * upcomingMaxSpeed(dt, substeps) * dt : 0);
+    for (substep = 0; substep < substeps; ++substep){
+        runStage(KinematicStage, [this]() { advanceKinematicColliders(stepDt); });
+        stepGraph.run(*threadPool);
+    }
+    substep = 0;
+    runStage(RemovalStage, [this]() {
+        dropGhosts();
+        gatherRemovals();
+    });
+    runStage(CompactionStage, [this]() { compactParticlesIfNeeded(); });
+    frameArena.release();
+}
+
+float Context::upcomingMaxSpeed(float dt, int substeps){
+    //Les champs de force n'ont pas de borne : seule la limite de vitesse les couvre
+    float speed = std::numeric_limits<float>::infinity();
+    if (forceFields.empty() || !config.clampSpeed){
+        size_t grain = threadPool->grainFor(particles.size(), 1024);
+        speedChunks.assign(ThreadPool::chunkCount(particles.size(), grain), 0);
+        threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+            float fastest = 0;
+            for (size_t i = first; i < last; ++i){
+                const Particle& particle = particles[i];
+                if (particle.isAlive() && !particle.isAsleep()){
+                    fastest = std::max(fastest, particle.getVelocity().norm());
+                }
+            }
+            speedChunks[first / grain] = fastest;
+        });
+        speed = 0;
+        for (float fastest: speedChunks){
+            speed = std::max(speed, fastest);
+        }
+        //Les particules endormies se réveillent avec une vitesse nulle, la gravité s'y ajoute
+        speed += config.gravity.norm() * dt;
+    }
+    if (config.clampSpeed){
+        speed = std::min(speed, config.maxSpeed);
+    }
+    float colliderSpeed = 0;
+    for (const auto& collider: colliders){
+        if (collider->isMoving()){
+            colliderSpeed = std::max(colliderSpeed, collider->getMaxSpeed(dt, substeps));
+        }
+    }
+    //Vitesse bornée : le collider déplace la particule à sa vitesse ; sinon elle peut rebondir jusqu'à deux fois plus vite
+    return config.clampSpeed ? std::max(speed, colliderSpeed) : speed + 2 * colliderSpeed;
+}
+
+bool Context::mustBeRemoved(const Particle& particle) const{
+    if (particle.isExpired()){
+        return true;
+    }
+    const Vec2& pos = particle.getPos();
+    if (worldBounds && !worldBounds->contains(pos)){
+        return true;
+    }
+    for (const auto& volume: killVolumes){
+        if (volume.contains(pos)){
+            return true;
+        }
+    }
+    return false;
+}
+
+void Context::killDuringFinalize(Particle& particle, size_t index, std::pmr::vector<size_t>& removed){
+    particle.kill();
+    removed.push_back(index);
+}
+
+void Context::gatherRemovals(){
+    for (auto& chunk: removalChunks){
+        freeList.insert(freeList.end(), chunk.begin(), chunk.end());
+        //Sans contacts entre particules, aucune ne repose sur une autre
+        if (config.particleCollisions){
+            for (size_t index: chunk){
+                wakeParticlesInBox(AABB::around(particles[index].getPos(), particles[index].getRadius()));
+            }
+        }
+        chunk.clear();
+    }
+    //L'emplacement pourra être réutilisé : la particule tirée ne doit pas changer d'identité
+    if (draggedParticle && !particles[*draggedParticle].isAlive()){
+        draggedParticle.reset();
+    }
+}
+
+void Context::compactParticlesIfNeeded(){
+    stepsSinceCompaction++;
+    if (freeList.empty()){
+        return;
+    }
+    //Compactage dès qu'un quart des emplacements est libre, et au moins toutes les 64 étapes
+    if (freeList.size() * 4 >= particles.size() || stepsSinceCompaction >= 64){
+        compactParticles();
+    }
+}
+
+void Context::compactParticles(){
+    constexpr size_t removed = static_cast<size_t>(-1);
+    std::pmr::vector<size_t> remap(particles.size(), removed, &frameArena);
+    size_t kept = 0;
+    for (size_t i = 0; i < particles.size(); ++i){
+        if (!particles[i].isAlive()){
+            continue;
+        }
+        if (kept != i){
+            particles[kept] = std::move(particles[i]);
+        }
+        remap[i] = kept++;
+    }
+    particles.erase(particles.begin() + kept, particles.end());
+    freeList.clear();
+    broadphaseCurrent = false;
+    broadphase.clear();
+    stepsSinceCompaction = 0;
+    if (draggedParticle){
+        draggedParticle = remap[*draggedParticle];
+    }
+
+    //Mise à jour des références vers les particules déplacées. Le stockage ne
+    //rétrécit pas en mémoire : l'ancien indice se déduit toujours du pointeur.
+    Particle* base = particles.data();
+    auto relocate = [&](Particle* particle) -> Particle* {
+        size_t index = remap[particle - base];
+        return index == removed ? nullptr : base + index;
+    };
+    staticConstraints.erase(std::remove_if(staticConstraints.begin(), staticConstraints.end(), [&](StaticConstraint& constraint) {
+        Particle* particle = relocate(constraint.getParticle());
+        constraint.changeParticle(particle);
+        return particle == nullptr;
+    }), staticConstraints.end());
+    contactConstraints.erase(std::remove_if(contactConstraints.begin(), contactConstraints.end(), [&](ContactConstraint& constraint) {
+        Particle* particle1 = relocate(constraint.getParticle1());
+        Particle* particle2 = relocate(constraint.getParticle2());
+        constraint.changeParticles(particle1, particle2);
+        return particle1 == nullptr || particle2 == nullptr;
+    }), contactConstraints.end());
+    candidatePairs.erase(std::remove_if(candidatePairs.begin(), candidatePairs.end(), [&](std::pair<size_t, size_t>& pair) {
+        pair = {remap[pair.first], remap[pair.second]};
+        return pair.first == removed || pair.second == removed;
+    }), candidatePairs.end());
+}
+
+void Context::emitParticles(float dt){
+    for (auto& emitter: emitters){
+        emitter->spawn(dt, emissionBatch);
+    }
+    if (!emissionBatch.empty()){
+        addParticles(std::move(emissionBatch));
+    }
+}
+
+void Context::predict(float dt){
+    (this->*predictKernel)(dt);
+}
+
+void Context::predictUnfused(float dt){
+    applyExternalForce();
     updateVelocity(dt);
     updateExpectedPosition(dt);
-    addStaticContactConstraints();
-    projectConstraints();
-    updateVelocityAndPosition(dt);
-
 }
-void Context::applyExternalForce(float dt){
-    for (auto& particle: particles){
-        //Reinitialisation des forces
-        particle->resetFext();
 
-        //Recalcule des forces
+void Context::accumulateForceFields(size_t first, size_t last, std::pmr::vector<Vec2>& accelerations) const{
+    accelerations.assign(last - first, Vec2(0, 0));
+    for (const auto& field: forceFields){
+        field->accumulate(particles, first, last, accelerations.data());
+    }
+}
 
-            //Gravite
-        particle->changeFext(Vec2(0,particle->getFext().gety() + g * particle->getMass()));
+template <typename Policy>
+void Context::predictFused(float dt){
+    const float maxSpeed = config.maxSpeed;
+    const float maxSpeed2 = maxSpeed * maxSpeed;
+    const float gx = config.gravity.getx();
+    const float gy = config.gravity.gety();
+    size_t grain = threadPool->grainFor(particles.size(), 1024);
+    if constexpr (Policy::forceFields){
+        prepareChunks(accelerationChunks, ThreadPool::chunkCount(particles.size(), grain));
     }
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        const Vec2* accelerations = nullptr;
+        if constexpr (Policy::forceFields){
+            auto& chunk = accelerationChunks[first / grain];
+            accumulateForceFields(first, last, chunk);
+            accelerations = chunk.data();
+        }
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive() || particle.isAsleep()){
+                particle.changeExpectedPos(particle.getPos());
+                continue;
+            }
+            //Les champs donnent directement l'accélération f/m
+            float ax = gx;
+            float ay = gy;
+            if constexpr (Policy::forceFields){
+                ax += accelerations[i - first].getx();
+                ay += accelerations[i - first].gety();
+            }
+            float vx = particle.getVelocity().getx() + ax * dt;
+            float vy = particle.getVelocity().gety() + ay * dt;
+            if constexpr (Policy::clampSpeed){
+                float speed2 = vx * vx + vy * vy;
+                if (speed2 > maxSpeed2){
+                    float scale = maxSpeed / std::sqrt(speed2);
+                    vx *= scale;
+                    vy *= scale;
+                }
+            }
+            Vec2 velocity(vx, vy);
+            particle.changeVelocity(velocity);
+            particle.changeExpectedPos(particle.getPos() + velocity * dt);
+        }
+    });
+}
+
+void Context::applyExternalForce(){
+    size_t grain = threadPool->grainFor(particles.size(), 1024);
+    prepareChunks(accelerationChunks, ThreadPool::chunkCount(particles.size(), grain));
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        auto& accelerations = accelerationChunks[first / grain];
+        accumulateForceFields(first, last, accelerations);
+        //Les accélérations restent dans les blocs jusqu'à updateVelocity, rien n'est stocké dans les particules
+        for (Vec2& acceleration: accelerations){
+            acceleration += config.gravity;
+        }
+    });
 }
 
 void Context::updateVelocity(float dt){
-    for (auto& particle: particles){
-        particle->changeVelocity(particle->getVelocity() + particle->getFext() * dt/particle->getMass());
-    }
+    //Même découpage que applyExternalForce : chaque bloc retrouve ses accélérations
+    size_t grain = threadPool->grainFor(particles.size(), 1024);
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        const auto& accelerations = accelerationChunks[first / grain];
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive() || particle.isAsleep()){
+                continue;
+            }
+            Vec2 velocity = particle.getVelocity() + accelerations[i - first] * dt;
+            particle.changeVelocity(config.clampSpeed ? clampedVelocity(velocity, config.maxSpeed) : velocity);
+        }
+    });
 }
 
 void Context::updateExpectedPosition(float dt){
-    for (auto& particle: particles){
-        particle->changeExpectedPos(particle->getPos() + particle->getVelocity()*dt);
+    threadPool->parallelFor(0, particles.size(), threadPool->grainFor(particles.size(), 1024), [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive() || particle.isAsleep()){
+                particle.changeExpectedPos(particle.getPos());
+                continue;
+            }
+            particle.changeExpectedPos(particle.getPos() + particle.getVelocity()*dt);
+        }
+    });
+}
+
+void Context::buildBroadphase(){
+    if (substep > 0 && reuseCandidates){
+        return;
     }
+    if (config.incrementalBroadphase){
+        broadphase.update(particles, *threadPool);
+    } else {
+        broadphase.build(particles, *threadPool);
+    }
+    broadphaseCurrent = true;
+    //Marge tronquée : des paires se rapprochant plus vite seraient manquées aux sous-pas suivants
+    reuseCandidates = broadphase.coversMargin();
+    size_t grain = threadPool->grainFor(particles.size(), 256);
+    prepareChunks(candidatePairChunks, ThreadPool::chunkCount(particles.size(), grain));
+    skippedPairChunks.assign(candidatePairChunks.size(), 0);
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        auto& chunk = candidatePairChunks[first / grain];
+        size_t& skipped = skippedPairChunks[first / grain];
+        for (size_t i = first; i < last; ++i){
+            if (!particles[i].isAlive()){
+                continue;
+            }
+            const CollisionFilter& filter = particles[i].getFilter();
+            broadphase.forEachCandidate(i, [&](size_t j) {
+                if (filter.accepts(particles[j].getFilter())){
+                    chunk.emplace_back(i, j);
+                } else {
+                    ++skipped;
+                }
+            });
+        }
+    });
+    gatherChunks(candidatePairChunks, candidatePairs);
 }
 
 void Context::addStaticContactConstraints(){
-    staticConstraints.clear();
-    for (auto& collider: colliders){
-        for (auto& particle: particles){
-            std::optional<StaticConstraint> constraint = collider->checkContact(*particle);
-            if (constraint) {
-                staticConstraints.push_back(std::make_unique<StaticConstraint>(*constraint));
+    const bool baked = staticSdf.isBaked() && bakedMaterial.has_value();
+    //La grille n'est exacte que dans la bande : les grosses particules sont testées directement
+    const float maxBakedRadius = staticSdf.getBand() - 1.5f * staticSdf.getCellSize();
+    //Découpage calé sur la capacité : les tampons ne changent pas quand le nombre de particules varie
+    size_t grain = threadPool->grainFor(particles.capacity(), 256);
+    prepareChunks(staticConstraintChunks, ThreadPool::chunkCount(particles.capacity(), grain));
+    skippedColliderChunks.assign(staticConstraintChunks.size(), 0);
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        auto& chunk = staticConstraintChunks[first / grain];
+        //Un contact par particule dès le premier pas : le tas qui se tasse ne fait plus grandir le tampon
+        chunk.reserve(grain);
+        size_t& skipped = skippedColliderChunks[first / grain];
+        Vec2 normal(0, -1);
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive()){
+                continue;
+            }
+            const CollisionFilter& filter = particle.getFilter();
+            //La grille mélange tous les colliders cuits : elle ne sert qu'aux particules qui les acceptent tous
+            bool acceptsBaked = std::all_of(bakedFilters.begin(), bakedFilters.end(),
+                                            [&](const CollisionFilter& other) { return filter.accepts(other); });
+            float distance;
+            bool sampled = baked && acceptsBaked && particle.getRadius() <= maxBakedRadius
+                && staticSdf.sample(particle.getExpectedPos(), distance, normal);
+            if (sampled){
+                float C = distance - particle.getRadius();
+                if (C < 0){
+                    chunk.emplace_back(normal * (-C), &particle);
+                    chunk.back().changeMaterial(*bakedMaterial);
+                }
+            }
+            //Les colliders déjà échantillonnés dans la grille ne sont pas retestés
+            auto collide = [&](const Collider* collider) {
+                if (sampled && collider->isBakeable()){
+                    return;
+                }
+                if (!filter.accepts(collider->getFilter())){
+                    ++skipped;
+                    return;
+                }
+                std::optional<StaticConstraint> constraint = collider->isKinematic()
+                    ? kinematicContact(*collider, particle) : collider->checkContact(particle);
+                if (constraint) {
+                    constraint->changeCollider(collider);
+                    constraint->changeMaterial(collider->getMaterial());
+                    if (collider->isMoving()){
+                        constraint->changeColliderVelocity(collider->getVelocityAt(particle.getExpectedPos()));
+                    }
+                    chunk.push_back(*constraint);
+                }
+            };
+            for (const Collider* collider: unboundedColliders){
+                collide(collider);
             }
+            //Boîte couvrant tout le trajet, pour les colliders minces qu'une particule rapide traverse
+            AABB swept = AABB::around(particle.getExpectedPos(), particle.getRadius())
+                             .merged(AABB::around(particle.getPos(), particle.getRadius()));
+            colliderBvh.query(swept, [&](size_t k) { collide(boundedColliders[k]); });
         }
-    }
-    for (auto& particle1: particles){
-        for (auto& particle2: particles){
-            std::optional<StaticConstraint> constraint = particle1->checkContact(*particle2);
+    });
+    staticConstraints.reserve(particles.capacity());
+    gatherChunks(staticConstraintChunks, staticConstraints);
+}
+
+void Context::addParticleContactConstraints(){
+    //Au plus une contrainte par paire : des tampons à la taille des morceaux ne grandissent plus
+    size_t grain = threadPool->grainFor(candidatePairs.capacity(), 1024);
+    prepareChunks(contactConstraintChunks, ThreadPool::chunkCount(candidatePairs.capacity(), grain));
+    threadPool->parallelFor(0, candidatePairs.size(), grain, [&](size_t first, size_t last) {
+        auto& chunk = contactConstraintChunks[first / grain];
+        chunk.reserve(grain);
+        for (size_t k = first; k < last; ++k){
+            const auto& [i, j] = candidatePairs[k];
+            //Une paire trouvée au premier sous-pas peut contenir une particule supprimée depuis
+            if (!particles[i].isAlive() || !particles[j].isAlive()){
+                continue;
+            }
+            std::optional<ContactConstraint> constraint = particles[i].checkContact(particles[j]);
             if (constraint) {
-                staticConstraints.push_back(std::make_unique<StaticConstraint>(*constraint));
+                chunk.push_back(*constraint);
             }
         }
-    }
+    });
+    contactConstraints.reserve(candidatePairs.capacity());
+    gatherChunks(contactConstraintChunks, contactConstraints);
 }
 
 void Context::enforceStaticGroundConstraint(const StaticConstraint& constraint,Particle& particle){
     particle.changeExpectedPos(particle.getExpectedPos() + constraint.getDelta());
 }
 
+void Context::enforceContactConstraint(const ContactConstraint& constraint){
+    Particle& particle1 = *constraint.getParticle1();
+    Particle& particle2 = *constraint.getParticle2();
+    float w1 = particle1.getInverseMass();
+    float w2 = particle2.getInverseMass();
+    Vec2 correction = constraint.getNormal() * (-constraint.getC() / (w1 + w2));
+    particle1.changeExpectedPos(particle1.getExpectedPos() + correction * w1);
+    particle2.changeExpectedPos(particle2.getExpectedPos() - correction * w2);
+}
+
+//La projection reste séquentielle : deux contraintes peuvent partager une particule
 void Context::projectConstraints(){
+    const int iterations = std::max(1, config.solverIterations);
+    for (int iteration = 0; iteration < iterations; ++iteration){
+        //Les corrections sont figées à la détection : chaque passe suivante les recalcule
+        if (iteration > 0){
+            addStaticContactConstraints();
+            if (config.particleCollisions){
+                addParticleContactConstraints();
+            }
+        }
+        for (auto& constraint: staticConstraints){
+            enforceStaticGroundConstraint(constraint,*constraint.getParticle());
+        }
+        for (const auto& constraint: contactConstraints){
+            enforceContactConstraint(constraint);
+        }
+        if (!kinematicColliders.empty()){
+            enforceKinematicColliders();
+        }
+    }
+}
+
+void Context::enforceKinematicColliders(){
+    auto enforce = [&](Particle& particle) {
+        auto push = [&](const Collider* collider) {
+            if (!collider->isKinematic() || !particle.getFilter().accepts(collider->getFilter())){
+                return;
+            }
+            std::optional<StaticConstraint> constraint = kinematicContact(*collider, particle);
+            if (constraint){
+                enforceStaticGroundConstraint(*constraint, particle);
+            }
+        };
+        for (const Collider* collider: unboundedColliders){
+            push(collider);
+        }
+        AABB swept = AABB::around(particle.getExpectedPos(), particle.getRadius())
+                         .merged(AABB::around(particle.getPos(), particle.getRadius()));
+        colliderBvh.query(swept, [&](size_t k) { push(boundedColliders[k]); });
+    };
+    //Seules les particules déplacées depuis la détection peuvent être passées de l'autre côté
+    for (auto& constraint: staticConstraints){
+        const Collider* collider = constraint.getCollider();
+        if (collider != nullptr && collider->isKinematic()){
+            enforce(*constraint.getParticle());
+        }
+    }
+    for (const auto& constraint: contactConstraints){
+        enforce(*constraint.getParticle1());
+        enforce(*constraint.getParticle2());
+    }
+}
+
+//Séquentiel comme la projection : deux contraintes peuvent partager une particule
+void Context::applyContactResponse(float dt){
+    if (!contactResponse){
+        return;
+    }
+    //En dessous, l'approche vient de la gravité d'un seul pas : un rebond ferait trembler les piles
+    const float restingSpeed = 2 * config.gravity.norm() * dt;
     for (auto& constraint: staticConstraints){
-        enforceStaticGroundConstraint(*constraint,*constraint->getParticle());
+        Particle& particle = *constraint.getParticle();
+        float depth = constraint.getDelta().norm();
+        if (!particle.isAlive() || depth <= 0){
+            continue;
+        }
+        Vec2 normal = constraint.getDelta() / depth;
+        Material material = combined(materialOf(particle.getMaterial()), materialOf(constraint.getMaterial()));
+        if (!material.hasResponse()){
+            continue;
+        }
+        Vec2 change = responseChange(particle.getVelocity() - constraint.getColliderVelocity(), normal,
+                                     constraint.getNormalSpeed(), depth / dt, material, restingSpeed);
+        particle.changeVelocity(particle.getVelocity() + change);
+    }
+    for (const auto& constraint: contactConstraints){
+        Particle& particle1 = *constraint.getParticle1();
+        Particle& particle2 = *constraint.getParticle2();
+        float depth = -constraint.getC();
+        if (!particle1.isAlive() || !particle2.isAlive() || depth <= 0){
+            continue;
+        }
+        Material material = combined(materialOf(particle1.getMaterial()), materialOf(particle2.getMaterial()));
+        if (!material.hasResponse()){
+            continue;
+        }
+        Vec2 change = responseChange(particle1.getVelocity() - particle2.getVelocity(), constraint.getNormal(),
+                                     constraint.getNormalSpeed(), depth / dt, material, restingSpeed);
+        float w1 = particle1.getInverseMass();
+        float w2 = particle2.getInverseMass();
+        particle1.changeVelocity(particle1.getVelocity() + change * (w1 / (w1 + w2)));
+        particle2.changeVelocity(particle2.getVelocity() - change * (w2 / (w1 + w2)));
     }
 }
 
 void Context::updateVelocityAndPosition(float dt){
-    for (auto& particle: particles){
-        particle->changeVelocity((particle->getExpectedPos() - particle->getPos())*1/dt);
-        particle->changePos(particle->getExpectedPos());
+    threadPool->parallelFor(0, particles.size(), threadPool->grainFor(particles.size(), 1024), [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive()){
+                continue;
+            }
+            Vec2 velocity = (particle.getExpectedPos() - particle.getPos())*1/dt;
+            particle.changeVelocity(config.clampSpeed ? clampedVelocity(velocity, config.maxSpeed) : velocity);
+            particle.changePos(particle.getExpectedPos());
+            particle.age(dt);
+        }
+    });
+}
+
+void Context::updateSleepAndStats(){
+    size_t grain = threadPool->grainFor(particles.size(), 1024);
+    stepStatsChunks.assign(ThreadPool::chunkCount(particles.size(), grain), StepStats());
+    //Pas de vidage : les suppressions de tous les sous-pas attendent gatherRemovals
+    growChunks(removalChunks, ThreadPool::chunkCount(particles.size(), grain));
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        StepStats& stats = stepStatsChunks[first / grain];
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive()){
+                continue;
+            }
+            if (mustBeRemoved(particle)){
+                killDuringFinalize(particle, i, removalChunks[first / grain]);
+                continue;
+            }
+            float speed = particle.getVelocity().norm();
+            particle.updateSleep(speed);
+            stats.awakeParticles += particle.isAsleep() ? 0 : 1;
+            stats.maxSpeed = std::max(stats.maxSpeed, speed);
+            stats.kineticEnergy += 0.5f * particle.getMass() * speed * speed;
+        }
+    });
+    reduceStepStats();
+}
+
+void Context::reduceStepStats(){
+    stepStats = StepStats();
+    for (const auto& stats: stepStatsChunks){
+        stepStats.awakeParticles += stats.awakeParticles;
+        stepStats.maxSpeed = std::max(stepStats.maxSpeed, stats.maxSpeed);
+        stepStats.kineticEnergy += stats.kineticEnergy;
     }
+    for (size_t skipped: skippedPairChunks){
+        stepStats.skippedPairTests += skipped;
+    }
+    for (size_t skipped: skippedColliderChunks){
+        stepStats.skippedPairTests += skipped;
+    }
+    if (config.particleCollisions){
+        stepStats.rebinnedParticles = broadphase.getRebinnedCount();
+    }
+}
+
+void Context::finalize(float dt){
+    (this->*finalizeKernel)(dt);
 }
 
+void Context::finalizeUnfused(float dt){
+    updateVelocityAndPosition(dt);
+    applyContactResponse(dt);
+    updateSleepAndStats();
+}
+
+template <typename Policy>
+void Context::finalizeFused(float dt){
+    const float maxSpeed = config.maxSpeed;
+    const float maxSpeed2 = maxSpeed * maxSpeed;
+    const float invDt = 1 / dt;
+    size_t grain = threadPool->grainFor(particles.size(), 1024);
+    stepStatsChunks.assign(ThreadPool::chunkCount(particles.size(), grain), StepStats());
+    //Pas de vidage : les suppressions de tous les sous-pas attendent gatherRemovals
+    growChunks(removalChunks, ThreadPool::chunkCount(particles.size(), grain));
+    threadPool->parallelFor(0, particles.size(), grain, [&](size_t first, size_t last) {
+        StepStats& stats = stepStatsChunks[first / grain];
+        for (size_t i = first; i < last; ++i){
+            Particle& particle = particles[i];
+            if (!particle.isAlive()){
+                continue;
+            }
+            const Vec2& expected = particle.getExpectedPos();
+            float vx = (expected.getx() - particle.getPos().getx()) * invDt;
+            float vy = (expected.gety() - particle.getPos().gety()) * invDt;
+            float speed2 = vx * vx + vy * vy;
+            if constexpr (Policy::clampSpeed){
+                if (speed2 > maxSpeed2){
+                    float scale = maxSpeed / std::sqrt(speed2);
+                    vx *= scale;
+                    vy *= scale;
+                    speed2 = maxSpeed2;
+                }
+            }
+            particle.changeVelocity(Vec2(vx, vy));
+            particle.changePos(expected);
+            particle.age(dt);
+            if (mustBeRemoved(particle)){
+                killDuringFinalize(particle, i, removalChunks[first / grain]);
+                continue;
+            }
+
+            float speed = std::sqrt(speed2);
+            particle.updateSleep(speed);
+            stats.awakeParticles += particle.isAsleep() ? 0 : 1;
+            stats.maxSpeed = std::max(stats.maxSpeed, speed);
+            stats.kineticEnergy += 0.5f * particle.getMass() * speed2;
+        }
+    });
+    reduceStepStats();
+}
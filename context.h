@@ -1,9 +1,46 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
 #include <vector>
+#include "aabb.h"
+#include "allocationcounter.h"
+#include "bvh.h"
 #include "particle.h"
+#include "rayhit.h"
 #include "collider.h"
+#include "commandqueue.h"
+#include "contactconstraint.h"
+#include "emitter.h"
+#include "framearena.h"
+#include "forcefield.h"
+#include "material.h"
+#include "sdfgrid.h"
+#include "simulationconfig.h"
+#include "spatialgrid.h"
+#include "taskgraph.h"
+#include "threadpool.h"
+
+/**
+ * @brief Statistics gathered while finalizing a step.
+ */
+struct StepStats {
+    size_t awakeParticles = 0;  ///< Number of particles that are not asleep after the step.
+    float maxSpeed = 0;         ///< Largest particle speed after the step.
+    float kineticEnergy = 0;    ///< Total kinetic energy of the particles after the step.
+    size_t skippedPairTests = 0;///< Number of particle-particle and particle-collider tests skipped by the collision filters.
+    size_t rebinnedParticles = 0;///< Number of particles binned again by the broadphase, see `SpatialGrid::update`.
+};
+
+/**
+ * @brief Allocations made by one stage of a step.
+ */
+struct StageAllocations {
+    const char* stage = "";  ///< Name of the stage.
+    AllocationCount count;   ///< Allocations of the stage during the last step.
+};
 
 /**
  * @brief Manages the simulation context.
@@ -11,6 +48,15 @@
  * The `Context` class handles the entire physical simulation, including the
  * particles, colliders, and constraints. It provides functionality to update
  * the physical system over time and resolve constraints between objects.
+ *
+ * Every stage of a step runs on a work-stealing `ThreadPool`. The stages are
+ * nodes of a `TaskGraph`, so that the collider narrowphase overlaps with the
+ * particle broadphase and narrowphase.
+ *
+ * The buffers kept from one step to the next take their memory from a
+ * pool resource, and the temporaries of a step from a `FrameArena`
+ * released when the step ends: once the buffers have reached their
+ * working size, a step does not allocate (see `setAllocationTracking`).
  */
 class Context {
 public:
@@ -28,6 +74,9 @@ public:
      */
     ~Context() = default;
 
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
     /**
      * @brief Initializes the context with an example configuration.
      *
@@ -40,9 +89,63 @@ public:
      *
      * Provides read-only access to the particles managed by the context.
      *
-     * @return A constant reference to the vector of `std::unique_ptr<Particle>`.
+     * Removed particles keep their slot (see `Particle::isAlive`) until the
+     * storage is compacted, so callers must skip them.
+     *
+     * @return A constant reference to the vector of particles, stored contiguously.
+     */
+    const std::vector<Particle>& getParticles() const;
+
+    /**
+     * @brief Lists the alive particles whose disc overlaps a box.
+     *
+     * Uses the broadphase grid of the last step while it still matches the
+     * particle storage, so the cost follows the number of particles in the
+     * box; falls back to a scan of every particle otherwise (particle
+     * collisions disabled, particles added or compacted since the step).
+     *
+     * @param box The box, in world coordinates.
+     * @param indices Cleared, then filled with indices in `getParticles()`.
+     */
+    void findParticlesInBox(const AABB& box, std::vector<size_t>& indices) const;
+
+    /**
+     * @brief Lists the alive particles whose disc overlaps a circle.
+     *
+     * @param center Center of the circle.
+     * @param radius Radius of the circle.
+     * @param indices Cleared, then filled with indices in `getParticles()`.
+     */
+    void findParticlesInCircle(const Vec2& center, float radius, std::vector<size_t>& indices) const;
+
+    /**
+     * @brief Finds the alive particle whose disc is closest to a point.
+     *
+     * @param point The point.
+     * @param maxDistance Particles whose disc is farther than this from `point` are ignored.
+     * @return The index of the particle in `getParticles()`, or `std::nullopt`.
+     */
+    std::optional<size_t> findNearestParticle(const Vec2& point, float maxDistance) const;
+
+    /**
+     * @brief Finds the first particle or collider hit by a ray.
+     *
+     * Particles are searched through the broadphase grid, one stretch of the
+     * ray at a time so that the search stops at the first hit, and colliders
+     * through their bounding volume hierarchy. Only bakeable colliders and
+     * colliders overriding `Collider::rayCast` can be hit.
+     *
+     * The queries are `const` and keep no scratch state in the context, so
+     * any number of threads may run them while the scene is rendered; they
+     * must not overlap `updatePhysicalSystem`.
+     *
+     * @param origin Origin of the ray.
+     * @param direction Direction of the ray (normalized by the call).
+     * @param maxDistance Length of the ray.
+     * @return The closest hit, or `std::nullopt`.
+     * @throw std::runtime_error if `direction` is zero.
      */
-    const std::vector<std::unique_ptr<Particle>>& getParticles() const;
+    std::optional<RayHit> rayCast(const Vec2& origin, const Vec2& direction, float maxDistance) const;
 
     /**
      * @brief Retrieves the list of colliders in the simulation.
@@ -53,6 +156,37 @@ public:
      */
     const std::vector<std::unique_ptr<Collider>>& getColliders() const;
 
+    /**
+     * @brief Gets a counter incremented whenever a collider is added, moved or removed.
+     *
+     * Lets renderers cache the drawing of the colliders until it changes.
+     *
+     * @return The current revision of the colliders.
+     */
+    uint64_t getColliderRevision() const;
+
+    /**
+     * @brief Gets a counter incremented whenever a change of the world wakes sleeping particles.
+     *
+     * Changes of the configuration, of the force fields, of the materials and
+     * moves of colliders count; the continuous motion of kinematic colliders
+     * does not. Lets the owners of particles kept out of the context, like
+     * `TiledWorld`, tell whether they may still be put back asleep.
+     *
+     * @return The current revision of the environment.
+     */
+    uint64_t getEnvironmentRevision() const;
+
+    /**
+     * @brief Gets the number of times the context was reset.
+     *
+     * A `ResetCommand` is only applied at the beginning of the next step:
+     * comparing this counter before and after a step tells whether it was.
+     *
+     * @return The number of calls to `reset`.
+     */
+    uint64_t getResetCount() const;
+
     /**
      * @brief Adds a new particle to the simulation.
      *
@@ -62,41 +196,655 @@ public:
      */
     void addParticle(Particle&& particle);
 
+    /**
+     * @brief Gets the number of particles that have not been removed.
+     *
+     * @return The number of alive particles.
+     */
+    size_t getAliveParticleCount() const;
+
+    /**
+     * @brief Adds a batch of particles to the simulation.
+     *
+     * Slots freed by removed particles are reused first, then the storage
+     * grows at most once for the rest of the batch.
+     *
+     * @param batch The particles to add, moved into the context.
+     */
+    void addParticles(std::vector<Particle>&& batch);
+
+    /**
+     * @brief Sets ghost particles, taking part in the next step only.
+     *
+     * Ghosts are copies of particles owned by another simulation, e.g. a
+     * neighbouring slab of a `SlabDomain`. They are appended to the storage
+     * for the next step, so that the particles near them collide with them,
+     * then dropped when the step ends: `getParticles()` never shows them
+     * between two steps. They are counted in the step statistics.
+     *
+     * @param ghosts The ghost particles, moved into the context.
+     */
+    void setGhostParticles(std::vector<Particle>&& ghosts);
+
+    /**
+     * @brief Reserves storage for a number of particles.
+     *
+     * @param count Total number of particles the context should hold without reallocating.
+     */
+    void reserveParticles(size_t count);
+
+    /**
+     * @brief Removes a particle from the simulation.
+     *
+     * The removal is deferred: the particle is skipped from now on and its
+     * slot goes to the free list, to be reused or compacted away later.
+     * The sleeping particles it touched are woken up, since they may have
+     * rested on it.
+     *
+     * @param index Index of the particle in `getParticles()`.
+     * @param wakeNeighbours False when the particle goes on living elsewhere,
+     *        e.g. paged out or migrated to another process, so that its
+     *        neighbours keep sleeping.
+     */
+    void removeParticle(size_t index, bool wakeNeighbours = true);
+
+    /**
+     * @brief Adds a kill volume: particles entering it are removed.
+     *
+     * @param volume The region of the kill volume.
+     */
+    void addKillVolume(const AABB& volume);
+
+    /**
+     * @brief Removes every kill volume.
+     */
+    void clearKillVolumes();
+
+    /**
+     * @brief Sets the bounds of the world: particles leaving them are removed.
+     *
+     * @param bounds The bounds of the world, or `std::nullopt` to disable culling.
+     */
+    void setWorldBounds(const std::optional<AABB>& bounds);
+
+    /**
+     * @brief Registers a particle emitter.
+     *
+     * Emitters run at the beginning of every step and their particles are
+     * inserted as a single batch.
+     *
+     * @param emitter The emitter, whose ownership is transferred to the context.
+     */
+    void addEmitter(std::unique_ptr<Emitter> emitter);
+
+    /**
+     * @brief Removes every emitter.
+     */
+    void clearEmitters();
+
+    /**
+     * @brief Adds a new collider to the simulation.
+     *
+     * @param collider The collider, whose ownership is transferred to the context.
+     */
+    void addCollider(std::unique_ptr<Collider> collider);
+
+    /**
+     * @brief Registers an external force field.
+     *
+     * Fields are evaluated in batch over the particle array, in registration
+     * order, on top of the gravity of the configuration. No field is
+     * registered by default, in which case the step skips their evaluation.
+     * Every particle is woken up.
+     *
+     * @param field The force field, whose ownership is transferred to the context.
+     */
+    void addForceField(std::unique_ptr<ForceField> field);
+
+    /**
+     * @brief Removes every force field (the gravity of the configuration is kept) and wakes every particle.
+     */
+    void clearForceFields();
+
+    /**
+     * @brief Retrieves the list of force fields in the simulation.
+     *
+     * @return A constant reference to the vector of `std::unique_ptr<ForceField>`.
+     */
+    const std::vector<std::unique_ptr<ForceField>>& getForceFields() const;
+
+    /**
+     * @brief Adds a material to the table of the simulation.
+     *
+     * Particles and colliders refer to a material by its index in the table.
+     * Index 0 is the default material, without friction nor restitution, and
+     * unknown indices fall back to it. As long as no material has friction or
+     * restitution, the step skips the contact response.
+     *
+     * @param material The material.
+     * @return The index of the material.
+     * @throw std::runtime_error if the table is full.
+     */
+    MaterialId addMaterial(const Material& material);
+
+    /**
+     * @brief Changes a material of the table.
+     *
+     * The particles and colliders made of it are affected from the next step,
+     * and every particle is woken up.
+     *
+     * @param id Index of the material.
+     * @param material The new properties.
+     * @throw std::runtime_error if the index is not in the table.
+     */
+    void changeMaterial(MaterialId id, const Material& material);
+
+    /**
+     * @brief Retrieves the material table.
+     *
+     * @return A constant reference to the materials, indexed by `MaterialId`.
+     */
+    const std::vector<Material>& getMaterials() const;
+
+    /**
+     * @brief Moves a collider.
+     *
+     * When the static colliders are baked, only the part of the grid around
+     * the old and new positions of the collider is resampled. The particles
+     * around the old and new positions are woken up, all of them if the
+     * collider is unbounded.
+     *
+     * @param index Index of the collider in `getColliders()`.
+     * @param offset The displacement to apply.
+     */
+    void moveCollider(size_t index, const Vec2& offset);
+
+    /**
+     * @brief Bakes the bakeable colliders into a signed-distance grid.
+     *
+     * Inside `region`, each particle then gets its contact with all the baked
+     * colliders from a single grid lookup instead of one test per collider.
+     * Colliders added or moved afterwards are rebaked incrementally. Particles
+     * outside the region, or too large for the band, fall back to exact tests.
+     *
+     * @param region The region of the world covered by the grid.
+     * @param cellSize Distance between two nodes of the grid.
+     * @param band Width of the band around the surfaces in which distances are exact.
+     */
+    void bakeStaticColliders(const AABB& region, float cellSize, float band);
+
+    /**
+     * @brief Drops the baked grid and goes back to one test per collider.
+     */
+    void disableBakedColliders();
+
+    /**
+     * @brief Removes every particle, collider and emitter from the simulation.
+     *
+     * Force fields and materials are kept.
+     */
+    void clear();
+
+    /**
+     * @brief Restores the state of a newly constructed context.
+     *
+     * Clears the simulation, the force fields and the materials, restores
+     * the default configuration and rebuilds the example scene. The thread count and
+     * the integration mode are kept.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the queue of commands applied at the beginning of the next step.
+     *
+     * Unlike the other modifiers, pushing a command is safe from any thread
+     * while the simulation is stepping, and never blocks.
+     *
+     * @return The command queue of the context.
+     */
+    CommandQueue& getCommandQueue();
+
+    /**
+     * @brief Changes the number of threads used to update the physical system.
+     *
+     * @param threadCount Number of threads, including the calling one (1 runs every stage inline).
+     */
+    void setThreadCount(unsigned threadCount);
+
+    /**
+     * @brief Gets the number of threads used to update the physical system.
+     *
+     * @return The number of threads, including the calling one.
+     */
+    unsigned getThreadCount() const;
+
+    /**
+     * @brief Selects the fused or the unfused integration kernels.
+     *
+     * The fused kernels predict and finalize each particle in a single pass
+     * over the particle array. The unfused path runs one pass per stage and is
+     * kept for debugging. Both paths are equivalent up to rounding.
+     *
+     * @param fused True to use the fused kernels (default).
+     */
+    void setFusedIntegration(bool fused);
+
+    /**
+     * @brief Gets the runtime parameters of the simulation.
+     *
+     * @return A constant reference to the current configuration.
+     */
+    const SimulationConfig& getConfig() const;
+
+    /**
+     * @brief Changes the runtime parameters of the simulation.
+     *
+     * Selects the stepping kernels compiled for the enabled features, and
+     * drops the particle-particle stages from the step graph when
+     * `particleCollisions` is off. Every particle is woken up, since the
+     * gravity or the clamping may have changed.
+     *
+     * @param newConfig The new configuration.
+     */
+    void setConfig(const SimulationConfig& newConfig);
+
+    /**
+     * @brief Gets the statistics of the last step.
+     *
+     * @return A constant reference to the statistics gathered by the last step.
+     */
+    const StepStats& getStepStats() const;
+
+    /**
+     * @brief Enables the counting of the allocations made by each stage of a step.
+     *
+     * The counts come from `AllocationCounter`, so they stay at zero unless
+     * the allocation hooks are linked into the executable. Stages running
+     * concurrently in the step graph may be charged for each other's
+     * allocations; the total of a step is exact.
+     *
+     * @param enabled True to count the allocations of the next steps.
+     */
+    void setAllocationTracking(bool enabled);
+
+    /**
+     * @brief Gets the allocations made by each stage during the last step.
+     *
+     * @return One entry per stage, in execution order, or nothing if the
+     *         tracking is disabled.
+     */
+    const std::vector<StageAllocations>& getStageAllocations() const;
+
     /**
      * @brief Updates the physical system over a time step.
      *
      * Simulates the evolution of the system by applying external forces,
      * resolving constraints, and updating particle positions and velocities.
+     * The pending commands (see `getCommandQueue`) are applied first, in the
+     * order they were pushed, before the emitters run.
+     *
+     * With `config.substeps` above 1, the step is split into substeps of
+     * `dt / substeps`, each predicting, projecting and updating the
+     * velocities on its own. The particle pairs are only searched at the
+     * first substep, with a margin covering the motion of the whole step
+     * (see `SpatialGrid::setMargin`); the later substeps evaluate the
+     * contacts of these pairs again. When the particles move too fast for
+     * the grid to cover that margin, the pairs are searched again at every
+     * substep instead. Commands, emitters, drag and removals still run once
+     * per step: the particles removed by any substep are freed at its end.
      *
      * @param dt The time step duration in seconds.
      */
     void updatePhysicalSystem(float dt);
 
 private:
+    /// Stages of a step, in execution order, indexing `stageAllocations`.
+    enum StepStage {
+        CommandStage, EmissionStage, DragStage, GhostStage, KinematicStage, PredictionStage,
+        StaticStage, BroadphaseStage, ContactStage, ProjectionStage, FinalizeStage,
+        RemovalStage, CompactionStage, StepStageCount
+    };
+
+    /// Memory of the buffers kept from one step to the next, pooled by size. Declared first: it outlives them.
+    std::pmr::synchronized_pool_resource stepMemory;
+
+    /// Memory of the temporaries of a step, released when the step ends.
+    FrameArena frameArena{&stepMemory};
+
+    /// Whether `stageAllocations` is filled at every step.
+    bool allocationTracking = false;
+
+    /// Allocations of each stage during the last step, by `StepStage`.
+    std::vector<StageAllocations> stageAllocations;
+
     /// List of particles in the simulation.
-    std::vector<std::unique_ptr<Particle>> particles;
+    std::vector<Particle> particles;
 
     /// List of colliders (e.g., planes, spheres) in the simulation.
     std::vector<std::unique_ptr<Collider>> colliders;
 
+    /// Revision of the colliders, see `getColliderRevision`.
+    uint64_t colliderRevision = 0;
+
+    /// Revision of the environment, see `getEnvironmentRevision`.
+    uint64_t environmentRevision = 0;
+
+    /// Number of resets, see `getResetCount`.
+    uint64_t resetCount = 0;
+
+    /// Indices of removed particles whose slots can be reused, until the next compaction.
+    /// Reserved with the particle storage, so that the removals never allocate.
+    std::pmr::vector<size_t> freeList{&stepMemory};
+
+    /// Number of steps since the last compaction.
+    int stepsSinceCompaction = 0;
+
+    /// Regions removing the particles entering them.
+    std::vector<AABB> killVolumes;
+
+    /// Bounds of the world, particles leaving them are removed.
+    std::optional<AABB> worldBounds;
+
+    /// Per-chunk indices of the particles removed by the finalize passes of the step, emptied by `gatherRemovals`.
+    std::pmr::vector<std::pmr::vector<size_t>> removalChunks{&stepMemory};
+
+    /// Signed-distance grid of the baked colliders, empty when baking is disabled.
+    SdfGrid staticSdf;
+
+    /// Colliders sampled in `staticSdf`.
+    std::vector<const Collider*> bakedColliders;
+
+    /// Distinct filters of the baked colliders: `staticSdf` is only used by the particles accepting all of them.
+    std::vector<CollisionFilter> bakedFilters;
+
+    /// Colliders with a bounding box, in the order of the items of `colliderBvh`.
+    std::vector<const Collider*> boundedColliders;
+
+    /// Colliders without a bounding box (e.g., planes), tested against every particle.
+    std::vector<const Collider*> unboundedColliders;
+
+    /// Hierarchy of the bounding boxes of `boundedColliders`.
+    Bvh colliderBvh;
+
+    /// Kinematic colliders, with the index of their box in `colliderBvh` (`Bvh::npos` if unbounded).
+    std::vector<std::pair<Collider*, size_t>> kinematicColliders;
+
+    /// Particle emitters, run at the beginning of every step.
+    std::vector<std::unique_ptr<Emitter>> emitters;
+
+    /// Batch filled by the emitters, reused from one step to the next.
+    std::vector<Particle> emissionBatch;
+
+    /// External force fields, evaluated in registration order.
+    std::vector<std::unique_ptr<ForceField>> forceFields;
+
+    /// Material table, the default material first.
+    std::vector<Material> materials{Material()};
+
+    /// Whether some material has friction or restitution, otherwise `applyContactResponse` is skipped.
+    bool contactResponse = false;
+
+    /// Material shared by all the baked colliders, empty if they differ: `staticSdf` is then not used.
+    std::optional<MaterialId> bakedMaterial;
+
     /// List of static constraints detected in the current frame.
-    std::vector<std::unique_ptr<StaticConstraint>> staticConstraints;
+    std::pmr::vector<StaticConstraint> staticConstraints{&stepMemory};
+
+    /// List of particle-particle contact constraints detected in the current frame (one per pair).
+    std::pmr::vector<ContactConstraint> contactConstraints{&stepMemory};
+
+    /// Thread pool running the stages of a step.
+    std::unique_ptr<ThreadPool> threadPool;
+
+    /// Dependency graph of the stages of a step, rebuilt when `config.particleCollisions` changes.
+    TaskGraph stepGraph;
+
+    /// Time step of the step or substep being computed, read by the stages of `stepGraph`.
+    float stepDt = 0;
+
+    /// Index of the substep being computed: the broadphase only runs at the first one.
+    int substep = 0;
+
+    /// Whether the candidate pairs of the first substep cover the whole step, see `buildBroadphase`.
+    bool reuseCandidates = false;
+
+    /// Whether the fused integration kernels are used.
+    bool fusedIntegration = true;
+
+    /// Runtime parameters of the simulation.
+    SimulationConfig config;
+
+    /// Prediction kernel selected by `selectKernels` for the current configuration.
+    void (Context::*predictKernel)(float) = nullptr;
+
+    /// Finalization kernel selected by `selectKernels` for the current configuration.
+    void (Context::*finalizeKernel)(float) = nullptr;
+
+    /// Statistics of the last step.
+    StepStats stepStats;
+
+    /// Per-chunk acceleration accumulators filled by the force fields.
+    std::pmr::vector<std::pmr::vector<Vec2>> accelerationChunks{&stepMemory};
+
+    /// Per-chunk statistics, reduced in chunk order into `stepStats`.
+    std::pmr::vector<StepStats> stepStatsChunks{&stepMemory};
+
+    /// Per-chunk largest particle speed, reduced by `upcomingMaxSpeed`.
+    std::pmr::vector<float> speedChunks{&stepMemory};
+
+    /// Per-chunk number of candidate pairs dropped by the collision filters in `buildBroadphase`.
+    std::pmr::vector<size_t> skippedPairChunks{&stepMemory};
+
+    /// Per-chunk number of collider tests skipped by the collision filters in `addStaticContactConstraints`.
+    std::pmr::vector<size_t> skippedColliderChunks{&stepMemory};
+
+    /// Ghost particles waiting for the next step, see `setGhostParticles`.
+    std::vector<Particle> pendingGhosts;
+
+    /// Index of the first ghost in `particles` during a step.
+    size_t ghostBegin = 0;
+
+    /// Number of ghosts at the end of `particles` during a step.
+    size_t ghostCount = 0;
+
+    /// Particle pulled towards `dragTarget`, see `DragParticleCommand`.
+    std::optional<size_t> draggedParticle;
+
+    /// Position the dragged particle is pulled to.
+    Vec2 dragTarget = Vec2(0, 0);
+
+    /// Commands pushed by other threads, drained at the beginning of each step.
+    CommandQueue commands;
+
+    /// Broadphase of particle-particle collisions.
+    SpatialGrid broadphase{&stepMemory};
+
+    /// Whether `broadphase` still indexes the particle storage (no insertion or compaction since it was built).
+    bool broadphaseCurrent = false;
+
+    /// Pairs of particle indices whose cells are adjacent in the current frame.
+    std::pmr::vector<std::pair<size_t, size_t>> candidatePairs{&stepMemory};
+
+    /// Per-chunk buffers filled in parallel, then gathered in chunk order for determinism.
+    std::pmr::vector<std::pmr::vector<std::pair<size_t, size_t>>> candidatePairChunks{&stepMemory};
+    std::pmr::vector<std::pmr::vector<StaticConstraint>> staticConstraintChunks{&stepMemory};
+    std::pmr::vector<std::pmr::vector<ContactConstraint>> contactConstraintChunks{&stepMemory};
+
+    /**
+     * @brief Applies and removes every pending command.
+     */
+    void applyCommands();
+
+    /**
+     * @brief Gives the dragged particle the velocity that brings it to `dragTarget` in one step.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void applyDrag(float dt);
+
+    /**
+     * @brief Bounds the speed of the particles over the next step.
+     *
+     * Reads the velocities once the commands, the emitters and the drag
+     * have been applied, so that the particles they launched are accounted
+     * for, and adds the gravity of the step. With `SimulationConfig::clampSpeed`,
+     * the bound never exceeds `SimulationConfig::maxSpeed`, which is the
+     * only bound of the force fields. The moving colliders push the
+     * particles they touch at their own speed.
+     *
+     * @param dt The time step duration in seconds.
+     * @param substeps The number of substeps the step is split into.
+     * @return The bound, in units per second.
+     */
+    float upcomingMaxSpeed(float dt, int substeps);
+
+    /**
+     * @brief Moves the kinematic colliders to the pose of their motion at the end of the step.
+     *
+     * Only the boxes of the kinematic colliders are refitted in `colliderBvh`,
+     * to their box swept over the step.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void advanceKinematicColliders(float dt);
+
+    /**
+     * @brief Appends the pending ghosts at the end of the storage.
+     */
+    void appendGhosts();
+
+    /**
+     * @brief Removes the ghosts of the step, their constraints and their removals.
+     */
+    void dropGhosts();
+
+    /**
+     * @brief Registers the stages of a step and their dependencies in `stepGraph`.
+     *
+     * The broadphase and particle contact stages are only registered when
+     * `config.particleCollisions` is on.
+     */
+    void buildStepGraph();
+
+    /**
+     * @brief Runs a stage of a step, counting its allocations when the tracking is enabled.
+     *
+     * @param stage The stage.
+     * @param work The work of the stage.
+     */
+    template <typename Work>
+    void runStage(StepStage stage, Work&& work);
+
+    /**
+     * @brief Picks the instantiation of the stepping kernels matching the configuration.
+     *
+     * Called whenever the configuration, the integration mode or the set of
+     * force fields changes, so that the hot loops never test these settings.
+     */
+    void selectKernels();
+
+    /**
+     * @brief Selects the fused kernels instantiated for a feature policy.
+     *
+     * @tparam Policy The features compiled in the kernels (see `StepPolicy` in context.cpp).
+     */
+    template <typename Policy>
+    void useFusedKernels();
+
+    /**
+     * @brief Tells whether a particle must be removed at the end of a step.
+     *
+     * @param particle The particle to test.
+     * @return True if its lifetime is over, it left the world bounds or it entered a kill volume.
+     */
+    bool mustBeRemoved(const Particle& particle) const;
+
+    /**
+     * @brief Kills a particle during the finalize pass and records it for the free list.
+     *
+     * @param particle The particle to kill.
+     * @param index Index of the particle.
+     * @param removed Removal buffer of the current chunk.
+     */
+    void killDuringFinalize(Particle& particle, size_t index, std::pmr::vector<size_t>& removed);
+
+    /**
+     * @brief Appends the particles removed during the finalize pass to the free list.
+     */
+    void gatherRemovals();
+
+    /**
+     * @brief Compacts the particle storage when it holds too many removed particles.
+     *
+     * Compaction happens when a quarter of the slots are free, or periodically
+     * when some are. It keeps the order of the surviving particles and fixes up
+     * every particle reference held by the constraints and candidate pairs.
+     */
+    void compactParticlesIfNeeded();
+
+    /**
+     * @brief Removes the free slots from the particle storage.
+     */
+    void compactParticles();
+
+    /**
+     * @brief Runs the emitters and inserts their particles as a single batch.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void emitParticles(float dt);
+
+    /**
+     * @brief Evaluates every force field over a block of particles.
+     *
+     * @param first Index of the first particle of the block.
+     * @param last Past-the-end index of the block.
+     * @param accelerations Accumulator of the block, reset then filled by the fields.
+     */
+    void accumulateForceFields(size_t first, size_t last, std::pmr::vector<Vec2>& accelerations) const;
 
     /**
-     * @brief Applies external forces to all particles.
+     * @brief Predicts the expected positions of the particles.
      *
-     * Calculates forces such as gravity and updates each particle's
-     * force accumulator accordingly.
+     * Runs the kernel selected by `selectKernels`: an instantiation of
+     * `predictFused`, or `predictUnfused`.
      *
      * @param dt The time step duration in seconds.
      */
-    void applyExternalForce(float dt);
+    void predict(float dt);
+
+    /**
+     * @brief Runs `applyExternalForce`, `updateVelocity` and `updateExpectedPosition`.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void predictUnfused(float dt);
+
+    /**
+     * @brief Applies the external forces, integrates and predicts in a single pass.
+     *
+     * Forces are evaluated on the fly instead of being stored between two
+     * passes. Sleeping particles are not integrated.
+     *
+     * @tparam Policy The features compiled in the kernel (speed clamp, force fields).
+     * @param dt The time step duration in seconds.
+     */
+    template <typename Policy>
+    void predictFused(float dt);
+
+    /**
+     * @brief Evaluates the external accelerations of all particles.
+     *
+     * Adds the gravity to the force fields, into `accelerationChunks`, where
+     * `updateVelocity` reads them back.
+     */
+    void applyExternalForce();
 
     /**
      * @brief Updates the velocity of all particles.
      *
-     * Uses the forces applied to particles to calculate their new
-     * velocities based on the given time step.
+     * Integrates the accelerations left in `accelerationChunks` by
+     * `applyExternalForce` over the given time step.
      *
      * @param dt The time step duration in seconds.
      */
@@ -112,14 +860,58 @@ private:
      */
     void updateExpectedPosition(float dt);
 
+    /**
+     * @brief Bins the particles in the broadphase grid and lists the candidate pairs.
+     *
+     * Does nothing after the first substep of a step: the pairs found at the
+     * first substep are reused, unless the grid could not cover the margin
+     * of the step (see `SpatialGrid::coversMargin`).
+     *
+     * The grid is updated incrementally when `config.incrementalBroadphase`
+     * is on, and rebuilt otherwise. Pairs whose collision filters do not accept each other are never listed.
+     */
+    void buildBroadphase();
+
+    /**
+     * @brief Wakes the particles overlapping a box.
+     *
+     * @param box The region that changed, e.g. the old and new bounds of a collider.
+     */
+    void wakeParticlesInBox(const AABB& box);
+
+    /**
+     * @brief Wakes every particle, after a change of the whole world.
+     */
+    void wakeAllParticles();
+
+    /**
+     * @brief Rebuilds `bakedColliders`, `bakedFilters`, `bakedMaterial`, the bounded, unbounded and kinematic lists and `colliderBvh`.
+     */
+    void refreshColliderLists();
+
     /**
      * @brief Detects and adds static contact constraints.
      *
-     * Iterates over all particles and colliders, checking for active
-     * collisions and generating constraints to resolve them.
+     * Iterates over all particles, checking for active collisions with the
+     * unbounded colliders and with the colliders whose bounding box overlaps
+     * the particle in `colliderBvh`, once their collision filters accept
+     * each other. When the colliders are baked and share a material, a single
+     * lookup in `staticSdf` replaces the tests against every baked collider.
+     * A kinematic collider is tested against the motion of the particle
+     * relative to it, so that a thin collider sweeping over a particle pushes
+     * it instead of going through; the contacts of moving colliders record
+     * their velocity.
      */
     void addStaticContactConstraints();
 
+    /**
+     * @brief Detects and adds particle-particle contact constraints.
+     *
+     * Tests every candidate pair found by the broadphase, so that each unordered
+     * pair of distinct particles is tested at most once.
+     */
+    void addParticleContactConstraints();
+
     /**
      * @brief Resolves a static ground constraint for a particle.
      *
@@ -131,14 +923,63 @@ private:
      */
     void enforceStaticGroundConstraint(const StaticConstraint& constraint, Particle& particle);
 
+    /**
+     * @brief Resolves a contact constraint between two particles.
+     *
+     * Moves both particles' expected positions along the contact normal,
+     * each one proportionally to its inverse mass.
+     *
+     * @param constraint The contact constraint to enforce.
+     */
+    void enforceContactConstraint(const ContactConstraint& constraint);
+
     /**
      * @brief Projects all constraints to resolve collisions.
      *
      * Iterates over the list of constraints and applies corrections
-     * to enforce the constraints on the associated particles.
+     * to enforce the constraints on the associated particles, then runs
+     * `enforceKinematicColliders` if there are kinematic colliders. With
+     * `config.solverIterations` above 1, the contacts with the colliders and
+     * between the candidate pairs are detected again at the corrected
+     * positions before each further pass.
      */
     void projectConstraints();
 
+    /**
+     * @brief Projects the particles moved by the constraints out of the kinematic colliders.
+     *
+     * Runs after the particle contacts, which may have pushed a particle
+     * through a thin kinematic collider. The contacts are detected again from
+     * the current expected positions, so the colliders have the last word.
+     */
+    void enforceKinematicColliders();
+
+    /**
+     * @brief Gets a material of the table.
+     *
+     * @param id Index of the material.
+     * @return The material, or the default one if the index is not in the table.
+     */
+    const Material& materialOf(MaterialId id) const;
+
+    /**
+     * @brief Applies friction and restitution to the velocities of the constrained particles.
+     *
+     * Runs in the finalize pass, between the velocity update and the sleep
+     * update, over the constraints of the step whose combined material has
+     * friction or restitution. Along the normal, the relative velocity is set
+     * to the restitution times the approach speed, so that the separation
+     * created by pushing overlaps apart is not kept; contacts approaching
+     * slower than twice the speed gained from gravity in one step are resting
+     * and do not bounce. Along the tangent, the relative velocity is cancelled
+     * while it stays below the static friction times the speed of the normal
+     * correction, and reduced by the dynamic friction times that speed beyond.
+     * Pair changes are shared in proportion to the inverse masses.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void applyContactResponse(float dt);
+
     /**
      * @brief Updates the final velocity and position of particles.
      *
@@ -148,6 +989,44 @@ private:
      * @param dt The time step duration in seconds.
      */
     void updateVelocityAndPosition(float dt);
+
+    /**
+     * @brief Updates the sleep state of the particles and gathers the step statistics.
+     */
+    void updateSleepAndStats();
+
+    /**
+     * @brief Reduces the per-chunk statistics into `stepStats`, in chunk order.
+     */
+    void reduceStepStats();
+
+    /**
+     * @brief Finalizes the positions and velocities of the particles.
+     *
+     * Runs the kernel selected by `selectKernels`: an instantiation of
+     * `finalizeFused`, or `finalizeUnfused`.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void finalize(float dt);
+
+    /**
+     * @brief Runs `updateVelocityAndPosition`, `applyContactResponse` and `updateSleepAndStats`.
+     *
+     * Also used by the fused integration as soon as a material has a response.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void finalizeUnfused(float dt);
+
+    /**
+     * @brief Updates velocities, positions, sleep states and statistics in a single pass.
+     *
+     * @tparam Policy The features compiled in the kernel (speed clamp).
+     * @param dt The time step duration in seconds.
+     */
+    template <typename Policy>
+    void finalizeFused(float dt);
 };
 
 #endif // CONTEXT_H
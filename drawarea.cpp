@@ -1,38 +1,266 @@
 #include "drawarea.h"
 #include "QPainter"
 #include "QPaintEvent"
+#include "QWheelEvent"
 #include "context.h"
-#include "constants.h"
+#include <algorithm>
+#include <cmath>
 
 DrawArea::DrawArea(QOpenGLWidget *parent)
     : QOpenGLWidget{parent}, context(std::make_unique<Context>())
 {
+    lastResetCount = context->getResetCount();
+    lastFrameInterval = getFrameInterval();
+    //Le contenu de l'image précédente est conservé entre deux repeints partiels
+    setUpdateBehavior(QOpenGLWidget::PartialUpdate);
     this->update();
 }
 
-void DrawArea::paintEvent(QPaintEvent *e){
+void DrawArea::paintEvent(QPaintEvent *){
+    if (!backgroundValid || backgroundRevision != context->getColliderRevision()
+        || background.size() != size() * devicePixelRatioF()){
+        renderBackground();
+        fullRepaint = true;
+    }
+    QRegion region = fullRepaint ? QRegion(rect()) : dirtyRegion;
+    dirtyRegion = QRegion();
+    fullRepaint = false;
+    if (region.isEmpty()){
+        return;
+    }
+
     QPainter p(this);
-    p.fillRect(e->rect(), Qt::black);
-    animate();
-    for(const auto& particle: context->getParticles()){
-        particle->draw(p);
+    p.setClipRegion(region);
+    p.drawPixmap(0, 0, background);
+
+    //Seules les particules de la zone repeinte sont récupérées
+    context->findParticlesInBox(worldBox(region.boundingRect()), visibleParticles);
+    const auto& particles = context->getParticles();
+    p.setTransform(cameraTransform());
+    for (size_t index: visibleParticles){
+        const Particle& particle = particles[index];
+        if (particle.getRadius() * zoom < lodRadius){
+            accumulateDensity(particle);
+        } else {
+            particle.draw(p);
+        }
     }
+    p.resetTransform();
+    drawDensity(p);
+}
+
+void DrawArea::renderBackground(){
+    qreal ratio = devicePixelRatioF();
+    background = QPixmap(size() * ratio);
+    background.setDevicePixelRatio(ratio);
+    background.fill(Qt::black);
+    QPainter p(&background);
+    p.setTransform(cameraTransform());
     for(const auto& collider: context->getColliders()){
         collider->draw(p);
     }
+    backgroundRevision = context->getColliderRevision();
+    backgroundValid = true;
 }
 
-void DrawArea::mouseDoubleClickEvent(QMouseEvent *event) {
-    QPointF mousePos = event->position();
-    this->context->addParticle(Particle(Vec2(mousePos.x(), mousePos.y()), Vec2(0, 0), 10, 1));
+bool DrawArea::awakeParticlesRegion(QRegion& region){
+    context->findParticlesInBox(worldBox(rect()), visibleParticles);
+    const auto& particles = context->getParticles();
+    size_t awake = 0;
+    for (size_t index: visibleParticles){
+        const Particle& particle = particles[index];
+        if (particle.isAsleep()){
+            continue;
+        }
+        if (++awake > maxDirtyParticles){
+            return false;
+        }
+        region += screenRect(particle);
+    }
+    return true;
+}
+
+QTransform DrawArea::cameraTransform() const{
+    QTransform transform;
+    transform.scale(zoom, zoom);
+    transform.translate(-cameraOrigin.x(), -cameraOrigin.y());
+    return transform;
+}
+
+Vec2 DrawArea::screenToWorld(const QPointF& point) const{
+    return Vec2(cameraOrigin.x() + point.x() / zoom, cameraOrigin.y() + point.y() / zoom);
+}
+
+AABB DrawArea::worldBox(const QRect& rect) const{
+    return AABB{screenToWorld(QPointF(rect.left(), rect.top())),
+                screenToWorld(QPointF(rect.right() + 1, rect.bottom() + 1))};
+}
+
+QRect DrawArea::screenRect(const Particle& particle) const{
+    //La marge d'un pixel couvre aussi le dernier déplacement (sous le pixel)
+    //d'une particule qui vient de s'endormir
+    qreal x = (particle.getPos().getx() - cameraOrigin.x()) * zoom;
+    qreal y = (particle.getPos().gety() - cameraOrigin.y()) * zoom;
+    qreal r = particle.getRadius() * zoom + 1;
+    return QRectF(x - r, y - r, 2 * r, 2 * r).toAlignedRect();
+}
+
+void DrawArea::accumulateDensity(const Particle& particle){
+    int w = width();
+    int h = height();
+    if (coverage.size() != static_cast<size_t>(w) * h){
+        coverage.assign(static_cast<size_t>(w) * h, 0);
+        coveredPixels.clear();
+    }
+    int x = static_cast<int>(std::floor((particle.getPos().getx() - cameraOrigin.x()) * zoom));
+    int y = static_cast<int>(std::floor((particle.getPos().gety() - cameraOrigin.y()) * zoom));
+    if (x < 0 || y < 0 || x >= w || y >= h){
+        return;
+    }
+    //Fraction du pixel couverte par le disque
+    size_t pixel = static_cast<size_t>(y) * w + x;
+    if (coverage[pixel] == 0){
+        coveredPixels.push_back(pixel);
+    }
+    float r = particle.getRadius() * static_cast<float>(zoom);
+    coverage[pixel] += 3.14159265f * r * r;
+}
+
+void DrawArea::drawDensity(QPainter& p){
+    if (coveredPixels.empty()){
+        return;
+    }
+    int w = width();
+    if (densityLayer.size() != size()){
+        densityLayer = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+        densityLayer.fill(Qt::transparent);
+    }
+    //Blanc d'autant plus opaque que le pixel est couvert, avec un minimum pour rester visible
+    for (size_t pixel: coveredPixels){
+        int alpha = static_cast<int>(255 * std::clamp(coverage[pixel], 0.25f, 1.0f));
+        auto line = reinterpret_cast<QRgb*>(densityLayer.scanLine(static_cast<int>(pixel / w)));
+        line[pixel % w] = qRgba(alpha, alpha, alpha, alpha);
+    }
+    p.drawImage(0, 0, densityLayer);
+    for (size_t pixel: coveredPixels){
+        auto line = reinterpret_cast<QRgb*>(densityLayer.scanLine(static_cast<int>(pixel / w)));
+        line[pixel % w] = 0;
+        coverage[pixel] = 0;
+    }
+    coveredPixels.clear();
+}
+
+void DrawArea::cameraChanged(){
+    backgroundValid = false;
+    requestFullRepaint();
+}
+
+void DrawArea::requestFullRepaint(){
+    fullRepaint = true;
+    movingRegion = QRegion();
     this->update();
 }
 
+void DrawArea::resizeEvent(QResizeEvent *e){
+    QOpenGLWidget::resizeEvent(e);
+    requestFullRepaint();
+}
+
+void DrawArea::mouseDoubleClickEvent(QMouseEvent *event) {
+    //La particule est ajoutée au début du prochain pas, sans attendre la simulation
+    AddParticlesCommand command;
+    command.particles.emplace_back(screenToWorld(event->position()), Vec2(0, 0), 10, 1);
+    context->getCommandQueue().push(std::move(command));
+}
+
+void DrawArea::mousePressEvent(QMouseEvent *event){
+    if (event->button() == Qt::LeftButton){
+        //La distance de sélection est fixe à l'écran, quel que soit le zoom
+        Vec2 target = screenToWorld(event->position());
+        std::optional<size_t> picked = context->findNearestParticle(target, pickDistance / static_cast<float>(zoom));
+        if (picked){
+            dragging = true;
+            context->getCommandQueue().push(DragParticleCommand{*picked, target});
+        }
+    }
+    if (event->button() == Qt::RightButton || event->button() == Qt::MiddleButton){
+        panAnchor = event->position();
+    }
+}
+
+void DrawArea::mouseMoveEvent(QMouseEvent *event){
+    if (dragging){
+        context->getCommandQueue().push(DragParticleCommand{std::nullopt, screenToWorld(event->position())});
+    }
+    if (!panAnchor){
+        return;
+    }
+    QPointF delta = event->position() - *panAnchor;
+    panAnchor = event->position();
+    cameraOrigin = QPointF(cameraOrigin.x() - delta.x() / zoom, cameraOrigin.y() - delta.y() / zoom);
+    cameraChanged();
+}
+
+void DrawArea::mouseReleaseEvent(QMouseEvent *event){
+    if (event->button() == Qt::LeftButton && dragging){
+        dragging = false;
+        context->getCommandQueue().push(ReleaseParticleCommand());
+    }
+    if (event->button() == Qt::RightButton || event->button() == Qt::MiddleButton){
+        panAnchor.reset();
+    }
+}
+
+void DrawArea::wheelEvent(QWheelEvent *event){
+    //Le point du monde sous le curseur reste fixe
+    Vec2 anchor = screenToWorld(event->position());
+    qreal factor = std::pow(1.15, event->angleDelta().y() / 120.0);
+    zoom = std::clamp(zoom * factor, minZoom, maxZoom);
+    cameraOrigin = QPointF(anchor.getx() - event->position().x() / zoom,
+                           anchor.gety() - event->position().y() / zoom);
+    cameraChanged();
+}
+
+
+int DrawArea::getFrameInterval() const{
+    return context->getConfig().frameInterval;
+}
 
 void DrawArea::animate(){
-    context->updatePhysicalSystem(tau/100);
+    context->updatePhysicalSystem(context->getConfig().stepDuration);
+
+    //Les commandes ne sont appliquées qu'au début du pas : on prévient seulement maintenant
+    if (lastResetCount != context->getResetCount()){
+        lastResetCount = context->getResetCount();
+        emit contextReset();
+    }
+    if (lastFrameInterval != getFrameInterval()){
+        lastFrameInterval = getFrameInterval();
+        emit frameIntervalChanged(lastFrameInterval);
+    }
+
+    //Une particule supprimée disparaît d'un endroit qu'on ne connaît plus : on repeint tout
+    size_t aliveCount = context->getAliveParticleCount();
+    bool removed = aliveCount < lastAliveCount;
+    lastAliveCount = aliveCount;
+
+    //Les commandes appliquées pendant le pas ont pu déplacer ou remplacer les colliders
+    bool collidersChanged = backgroundRevision != context->getColliderRevision();
+
+    QRegion moving;
+    if (removed || collidersChanged || !awakeParticlesRegion(moving)){
+        requestFullRepaint();
+        return;
+    }
+    //Anciennes et nouvelles positions des particules éveillées
+    dirtyRegion += movingRegion;
+    dirtyRegion += moving;
+    movingRegion = moving;
+    if (!dirtyRegion.isEmpty()){
+        this->update();
+    }
 }
 
 void DrawArea::resetContext(){
-    context = std::make_unique<Context>();
+    context->getCommandQueue().push(ResetCommand());
 }
@@ -1,7 +1,13 @@
 #ifndef DRAWAREA_H
 #define DRAWAREA_H
 
+#include <QImage>
 #include <QOpenGLWidget>
+#include <QPixmap>
+#include <QRegion>
+#include <QTransform>
+#include <optional>
+#include <vector>
 #include "context.h"
 
 /**
@@ -10,6 +16,19 @@
  * The `DrawArea` class is a custom widget that renders the simulation
  * context and allows user interactions such as adding particles via mouse events.
  * It inherits from `QOpenGLWidget` to support OpenGL-based rendering.
+ *
+ * The colliders are drawn once into a cached background layer, redrawn only
+ * when they change. When few particles are awake, only the region they
+ * covered in the previous and in the current frame is repainted: the rest of
+ * the framebuffer is kept from the previous frame.
+ *
+ * A camera maps the world to the widget: the wheel zooms around the cursor
+ * and a right or middle drag pans. A left drag picks the particle under the
+ * cursor, through `Context::findNearestParticle`, and drags it along. Only the particles inside the repainted
+ * part of the view are fetched, through `Context::findParticlesInBox`, and
+ * the particles smaller than a pixel are accumulated into a density layer
+ * instead of being drawn one by one, so the cost of a frame follows what is
+ * visible rather than the number of particles.
  */
 class DrawArea : public QOpenGLWidget {
     Q_OBJECT
@@ -34,8 +53,8 @@ public:
     /**
      * @brief Paints the simulation on the widget.
      *
-     * Called whenever the widget needs to be repainted. Renders the current
-     * state of the simulation context.
+     * Called whenever the widget needs to be repainted. Composites the cached
+     * background and the particles over the dirty region only.
      *
      * @param e The paint event triggering the repaint.
      */
@@ -44,30 +63,219 @@ public:
     /**
      * @brief Animates the simulation by updating its state.
      *
-     * Advances the simulation by a small time step and triggers a repaint.
+     * Advances the simulation by a small time step, then schedules the
+     * repaint of the region covered by the awake particles.
      */
     void animate();
 
     /**
      * @brief Handles double-click mouse events.
      *
-     * Adds a new particle to the simulation at the position of the double-click.
+     * Queues the addition of a new particle at the position of the double-click,
+     * applied at the beginning of the next step.
      *
      * @param event The mouse event containing the click position.
      */
     void mouseDoubleClickEvent(QMouseEvent *event) override;
 
+    /**
+     * @brief Picks the particle under the cursor with the left button, or
+     * starts panning the view with the right or middle button.
+     *
+     * @param event The mouse event.
+     */
+    void mousePressEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Drags the picked particle, or pans the view while the right or
+     * middle button is held.
+     *
+     * @param event The mouse event.
+     */
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Releases the picked particle or stops panning the view.
+     *
+     * @param event The mouse event.
+     */
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Zooms the view around the cursor.
+     *
+     * @param event The wheel event.
+     */
+    void wheelEvent(QWheelEvent *event) override;
+
+    /**
+     * @brief Gets the period at which the widget should be repainted.
+     *
+     * @return The frame interval of the simulation configuration (ms).
+     */
+    int getFrameInterval() const;
+
 public slots:
     /**
      * @brief Resets the simulation context.
      *
-     * Clears and reinitializes the simulation context to its default state.
+     * Queues a reset of the simulation context to its default state, applied
+     * at the beginning of the next step.
      */
     void resetContext();
 
+signals:
+    /**
+     * @brief Emitted once a reset queued by `resetContext` has been applied.
+     */
+    void contextReset();
+
+    /**
+     * @brief Emitted when a step changed the frame interval of the configuration.
+     *
+     * @param interval The new frame interval (ms).
+     */
+    void frameIntervalChanged(int interval);
+
+protected:
+    /**
+     * @brief Repaints the whole widget after a resize.
+     *
+     * @param e The resize event.
+     */
+    void resizeEvent(QResizeEvent *e) override;
+
 private:
+    /// Above this number of awake particles, the whole widget is repainted.
+    static constexpr size_t maxDirtyParticles = 256;
+
+    /// Particles whose radius on screen is below this (pixels) go to the density layer.
+    static constexpr qreal lodRadius = 0.5;
+
+    /// Bounds of the zoom factor.
+    static constexpr qreal minZoom = 0.01;
+    static constexpr qreal maxZoom = 100;
+
     /// Pointer to the simulation context being rendered and managed.
     std::unique_ptr<Context> context;
+
+    /// Colliders drawn over the background color, at the size of the widget.
+    QPixmap background;
+
+    /// Whether `background` matches the colliders of `context`.
+    bool backgroundValid = false;
+
+    /// Revision of the colliders drawn in `background`.
+    uint64_t backgroundRevision = 0;
+
+    /// Region to repaint at the next paint event.
+    QRegion dirtyRegion;
+
+    /// Region covered by the awake particles in the last frame.
+    QRegion movingRegion;
+
+    /// Whether the next paint event must repaint the whole widget.
+    bool fullRepaint = true;
+
+    /// Number of alive particles in the last frame, a removal forces a full repaint.
+    size_t lastAliveCount = 0;
+
+    /// Reset count of the context in the last frame, see `contextReset`.
+    uint64_t lastResetCount = 0;
+
+    /// Frame interval of the configuration in the last frame, see `frameIntervalChanged`.
+    int lastFrameInterval = 0;
+
+    /// World point shown at the top-left corner of the widget.
+    QPointF cameraOrigin = QPointF(0, 0);
+
+    /// Number of pixels per world unit.
+    qreal zoom = 1;
+
+    /// Last cursor position of the current pan, if the view is being panned.
+    std::optional<QPointF> panAnchor;
+    bool dragging = false;                 ///< True while a particle picked with the left button is dragged.
+    static constexpr float pickDistance = 10;  ///< Distance in pixels under which a click picks a particle.
+
+    /// Indices of the particles found in the repainted part of the view, reused between frames.
+    std::vector<size_t> visibleParticles;
+
+    /// Coverage of each pixel by the sub-pixel particles, reused between frames.
+    std::vector<float> coverage;
+
+    /// Pixels of `coverage` written in the current frame.
+    std::vector<size_t> coveredPixels;
+
+    /// Image of the density layer, transparent outside `coveredPixels`.
+    QImage densityLayer;
+
+    /**
+     * @brief Draws the colliders into `background`.
+     */
+    void renderBackground();
+
+    /**
+     * @brief Computes the region covered by the visible awake particles.
+     *
+     * @param region Receives the union of the bounding rectangles of the awake particles.
+     * @return False if there are more than `maxDirtyParticles` awake particles in view.
+     */
+    bool awakeParticlesRegion(QRegion& region);
+
+    /**
+     * @brief Gets the transform from world coordinates to widget coordinates.
+     *
+     * @return The transform of the camera.
+     */
+    QTransform cameraTransform() const;
+
+    /**
+     * @brief Converts a widget position to world coordinates.
+     *
+     * @param point The position in the widget.
+     * @return The world point under it.
+     */
+    Vec2 screenToWorld(const QPointF& point) const;
+
+    /**
+     * @brief Gets the world box seen through a rectangle of the widget.
+     *
+     * @param rect The rectangle, in widget coordinates.
+     * @return The box in world coordinates.
+     */
+    AABB worldBox(const QRect& rect) const;
+
+    /**
+     * @brief Gets the rectangle of the widget covered by a particle.
+     *
+     * @param particle The particle.
+     * @return Its bounding rectangle on screen, with a one pixel margin.
+     */
+    QRect screenRect(const Particle& particle) const;
+
+    /**
+     * @brief Accumulates the coverage of a sub-pixel particle into its pixel.
+     *
+     * @param particle The particle.
+     */
+    void accumulateDensity(const Particle& particle);
+
+    /**
+     * @brief Draws the density layer and clears the pixels written in this frame.
+     *
+     * @param p The painter of the widget.
+     */
+    void drawDensity(QPainter& p);
+
+    /**
+     * @brief Redraws everything after a change of the camera.
+     */
+    void cameraChanged();
+
+    /**
+     * @brief Schedules the repaint of the whole widget.
+     */
+    void requestFullRepaint();
 };
 
 #endif // DRAWAREA_H
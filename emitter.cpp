@@ -0,0 +1,66 @@
+#include "emitter.h"
+#include <cmath>
+
+Emitter::Emitter(const EmissionSettings& settings, unsigned seed): settings(settings), rng(seed) {}
+
+void Emitter::setEnabled(bool enabled){
+    this->enabled = enabled;
+}
+
+EmissionSettings& Emitter::getSettings(){
+    return settings;
+}
+
+void Emitter::spawn(float dt, std::vector<Particle>& batch){
+    if (!enabled || settings.rate <= 0){
+        return;
+    }
+    pending += settings.rate * dt;
+    size_t count = static_cast<size_t>(pending);
+    pending -= count;
+    if (count == 0){
+        return;
+    }
+
+    std::uniform_real_distribution<float> unit(-1, 1);
+    float speed = settings.velocity.norm();
+    float angle = std::atan2(settings.velocity.gety(), settings.velocity.getx());
+    batch.reserve(batch.size() + count);
+    for (size_t k = 0; k < count; ++k){
+        Vec2 position = samplePosition(rng);
+        float a = angle + unit(rng) * settings.spread / 2;
+        float s = speed * (1 + unit(rng) * settings.speedVariation);
+        batch.emplace_back(position, Vec2(std::cos(a) * s, std::sin(a) * s),
+                           settings.radius, settings.mass, settings.lifetime, settings.material);
+        batch.back().changeFilter(settings.filter);
+    }
+}
+
+PointEmitter::PointEmitter(Vec2 position, const EmissionSettings& settings, unsigned seed)
+    : Emitter(settings, seed), position(position) {}
+
+Vec2 PointEmitter::samplePosition(std::mt19937& rng){
+    //Tirage uniforme dans un disque du rayon des particules : deux particules d'un lot ne coïncident jamais
+    std::uniform_real_distribution<float> unit(0, 1);
+    float distance = getSettings().radius * std::sqrt(unit(rng));
+    float angle = 2 * 3.14159265f * unit(rng);
+    return position + Vec2(std::cos(angle), std::sin(angle)) * distance;
+}
+
+LineEmitter::LineEmitter(Vec2 start, Vec2 end, const EmissionSettings& settings, unsigned seed)
+    : Emitter(settings, seed), start(start), end(end) {}
+
+Vec2 LineEmitter::samplePosition(std::mt19937& rng){
+    std::uniform_real_distribution<float> t(0, 1);
+    return start + (end - start) * t(rng);
+}
+
+AreaEmitter::AreaEmitter(Vec2 min, Vec2 max, const EmissionSettings& settings, unsigned seed)
+    : Emitter(settings, seed), min(min), max(max) {}
+
+Vec2 AreaEmitter::samplePosition(std::mt19937& rng){
+    std::uniform_real_distribution<float> tx(min.getx(), max.getx());
+    std::uniform_real_distribution<float> ty(min.gety(), max.gety());
+    float x = tx(rng);
+    return Vec2(x, ty(rng));
+}
@@ -0,0 +1,158 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <limits>
+#include <random>
+#include <vector>
+#include "particle.h"
+
+/**
+ * @brief Parameters of the particles produced by an `Emitter`.
+ */
+struct EmissionSettings {
+    float rate = 100;                 ///< Number of particles emitted per second.
+    Vec2 velocity = Vec2(0, 0);       ///< Mean initial velocity of the particles.
+    float spread = 0;                 ///< Angular spread (radians) of the velocity direction around `velocity`.
+    float speedVariation = 0;         ///< Relative random variation of the initial speed (0.1 = ±10%).
+    float lifetime = std::numeric_limits<float>::infinity(); ///< Lifetime of the particles (s).
+    float radius = 3;                 ///< Radius of the particles.
+    float mass = 1;                   ///< Mass of the particles.
+    CollisionFilter filter;           ///< Collision layer and mask of the particles.
+    MaterialId material = 0;          ///< Material of the particles.
+};
+
+/**
+ * @brief Base class for particle emitters.
+ *
+ * An emitter produces `rate` particles per second of simulated time. The
+ * particles of a step are appended to a batch which the `Context` inserts in
+ * one go, so that emitting thousands of particles per second only costs one
+ * reservation per step. Derived classes choose where the particles appear.
+ */
+class Emitter {
+public:
+    /**
+     * @brief Constructs a new `Emitter`.
+     *
+     * @param settings Parameters of the emitted particles.
+     * @param seed Seed of the random generator, for reproducible emissions.
+     */
+    explicit Emitter(const EmissionSettings& settings, unsigned seed = 0);
+
+    /**
+     * @brief Virtual destructor for Emitter.
+     */
+    virtual ~Emitter() = default;
+
+    /**
+     * @brief Appends the particles emitted during a time step to a batch.
+     *
+     * Fractional emissions are carried over to the next step, so low rates
+     * are honoured on average.
+     *
+     * @param dt The time step duration in seconds.
+     * @param batch The batch the new particles are appended to.
+     */
+    void spawn(float dt, std::vector<Particle>& batch);
+
+    /**
+     * @brief Enables or disables the emission.
+     *
+     * @param enabled False to stop emitting particles.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Gets the parameters of the emitted particles.
+     *
+     * @return A reference to the settings, which may be modified between steps.
+     */
+    EmissionSettings& getSettings();
+
+protected:
+    /**
+     * @brief Draws the position of a new particle.
+     *
+     * @param rng The random generator of the emitter.
+     * @return The initial position of the particle.
+     */
+    virtual Vec2 samplePosition(std::mt19937& rng) = 0;
+
+private:
+    EmissionSettings settings;  ///< Parameters of the emitted particles.
+    std::mt19937 rng;           ///< Random generator of the emitter.
+    float pending = 0;          ///< Fraction of particle left over from the previous steps.
+    bool enabled = true;        ///< Whether the emitter produces particles.
+};
+
+/**
+ * @brief Emitter producing particles around a single point.
+ *
+ * The particles are spread uniformly over a disc of their own radius, so
+ * that those of a same batch never coincide and always get a contact normal.
+ */
+class PointEmitter : public Emitter {
+private:
+    Vec2 position;  ///< Position of the emitter.
+
+public:
+    /**
+     * @brief Constructs a new `PointEmitter`.
+     *
+     * @param position Position of the emitter.
+     * @param settings Parameters of the emitted particles.
+     * @param seed Seed of the random generator.
+     */
+    PointEmitter(Vec2 position, const EmissionSettings& settings, unsigned seed = 0);
+
+protected:
+    Vec2 samplePosition(std::mt19937& rng) override;
+};
+
+/**
+ * @brief Emitter producing particles uniformly along a segment.
+ */
+class LineEmitter : public Emitter {
+private:
+    Vec2 start;  ///< First end of the segment.
+    Vec2 end;    ///< Second end of the segment.
+
+public:
+    /**
+     * @brief Constructs a new `LineEmitter`.
+     *
+     * @param start First end of the segment.
+     * @param end Second end of the segment.
+     * @param settings Parameters of the emitted particles.
+     * @param seed Seed of the random generator.
+     */
+    LineEmitter(Vec2 start, Vec2 end, const EmissionSettings& settings, unsigned seed = 0);
+
+protected:
+    Vec2 samplePosition(std::mt19937& rng) override;
+};
+
+/**
+ * @brief Emitter producing particles uniformly inside an axis-aligned rectangle.
+ */
+class AreaEmitter : public Emitter {
+private:
+    Vec2 min;  ///< Lower corner of the rectangle.
+    Vec2 max;  ///< Upper corner of the rectangle.
+
+public:
+    /**
+     * @brief Constructs a new `AreaEmitter`.
+     *
+     * @param min Lower corner of the rectangle.
+     * @param max Upper corner of the rectangle.
+     * @param settings Parameters of the emitted particles.
+     * @param seed Seed of the random generator.
+     */
+    AreaEmitter(Vec2 min, Vec2 max, const EmissionSettings& settings, unsigned seed = 0);
+
+protected:
+    Vec2 samplePosition(std::mt19937& rng) override;
+};
+
+#endif // EMITTER_H
@@ -0,0 +1,131 @@
+#include "ensemble.h"
+#include <algorithm>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+std::vector<EnsembleParameters> ParameterSweep::expand() const{
+    std::vector<EnsembleParameters> runs;
+    runs.reserve(masses.size() * radii.size() * gravities.size() * std::max(repeats, 0));
+    for (float mass: masses){
+        for (float radius: radii){
+            for (float gravity: gravities){
+                for (int repeat = 0; repeat < repeats; ++repeat){
+                    runs.push_back(EnsembleParameters{runs.size(), mass, radius, gravity, repeat});
+                }
+            }
+        }
+    }
+    return runs;
+}
+
+ParameterSweep ParameterSweep::parse(std::istream& in){
+    ParameterSweep sweep;
+    std::string line;
+    while (std::getline(in, line)){
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name)){
+            continue;
+        }
+        if (name == "repeats"){
+            if (!(fields >> sweep.repeats) || sweep.repeats < 1){
+                throw std::runtime_error("Nombre de répétitions invalide : " + line);
+            }
+            continue;
+        }
+        std::vector<float>* values = name == "mass" ? &sweep.masses
+                                   : name == "radius" ? &sweep.radii
+                                   : name == "gravity" ? &sweep.gravities
+                                   : nullptr;
+        if (values == nullptr){
+            throw std::runtime_error("Paramètre inconnu : " + name);
+        }
+        values->clear();
+        float value;
+        while (fields >> value){
+            values->push_back(value);
+        }
+        if (!fields.eof() || values->empty()){
+            throw std::runtime_error("Valeurs invalides : " + line);
+        }
+    }
+    return sweep;
+}
+
+EnsembleRunner::EnsembleRunner(unsigned threadCount) : pool(threadCount) {}
+
+std::vector<EnsembleResult> EnsembleRunner::run(const ParameterSweep& sweep, const SceneBuilder& buildScene, int steps){
+    std::vector<EnsembleParameters> runs = sweep.expand();
+    std::vector<EnsembleResult> results(runs.size());
+    //Une simulation par tâche : chaque résultat a sa case, l'ordre ne dépend pas de l'ordonnancement
+    pool.parallelFor(0, runs.size(), 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i){
+            auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<Context> context = acquireContext();
+            context->clear();
+            context->clearForceFields();
+            SimulationConfig config;
+            config.gravity = Vec2(0, runs[i].gravity);
+            context->setConfig(config);
+            buildScene(*context, runs[i]);
+            for (int s = 0; s < steps; ++s){
+                context->updatePhysicalSystem(config.stepDuration);
+            }
+
+            EnsembleResult& result = results[i];
+            result.parameters = runs[i];
+            Vec2 positionSum(0, 0);
+            for (const auto& particle: context->getParticles()){
+                if (!particle.isAlive()){
+                    continue;
+                }
+                result.aliveParticles++;
+                positionSum += particle.getPos();
+                float speed = particle.getVelocity().norm();
+                result.kineticEnergy += 0.5f * particle.getMass() * speed * speed;
+            }
+            if (result.aliveParticles > 0){
+                result.centerOfMass = positionSum / static_cast<float>(result.aliveParticles);
+            }
+            releaseContext(std::move(context));
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            result.durationMs = elapsed.count();
+        }
+    });
+    return results;
+}
+
+void EnsembleRunner::writeCsv(std::ostream& out, const std::vector<EnsembleResult>& results){
+    out << "run,mass,radius,gravity,repeat,alive,center_x,center_y,kinetic_energy,duration_ms\n";
+    for (const auto& result: results){
+        const EnsembleParameters& p = result.parameters;
+        out << p.index << ',' << p.mass << ',' << p.radius << ',' << p.gravity << ',' << p.repeat << ','
+            << result.aliveParticles << ',' << result.centerOfMass.getx() << ',' << result.centerOfMass.gety() << ','
+            << result.kineticEnergy << ',' << result.durationMs << '\n';
+    }
+}
+
+std::unique_ptr<Context> EnsembleRunner::acquireContext(){
+    {
+        std::lock_guard<std::mutex> lock(contextMutex);
+        if (!idleContexts.empty()){
+            std::unique_ptr<Context> context = std::move(idleContexts.back());
+            idleContexts.pop_back();
+            return context;
+        }
+    }
+    //Les simulations tournent côte à côte : chacune reste sur un seul thread
+    auto context = std::make_unique<Context>();
+    context->setThreadCount(1);
+    return context;
+}
+
+void EnsembleRunner::releaseContext(std::unique_ptr<Context> context){
+    std::lock_guard<std::mutex> lock(contextMutex);
+    idleContexts.push_back(std::move(context));
+}
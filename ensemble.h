@@ -0,0 +1,134 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "context.h"
+#include "threadpool.h"
+
+/**
+ * @brief Parameters of one simulation of an ensemble.
+ */
+struct EnsembleParameters {
+    size_t index = 0;    ///< Index of the run in the sweep.
+    float mass = 1;      ///< Mass of the particles.
+    float radius = 2;    ///< Radius of the particles.
+    float gravity = 9.8f;///< Vertical gravitational acceleration (m/s²).
+    int repeat = 0;      ///< Index of the repetition of these parameters.
+};
+
+/**
+ * @brief Description of a parameter sweep: every combination of the listed values.
+ *
+ * A sweep can be read from a text description with one parameter per line,
+ * the name followed by its values, and `#` starting a comment:
+ *
+ *     mass 0.5 1 2
+ *     radius 1.5 2 3
+ *     gravity 4.9 9.8
+ *     repeats 2
+ */
+struct ParameterSweep {
+    std::vector<float> masses{1};        ///< Values of `EnsembleParameters::mass`.
+    std::vector<float> radii{2};         ///< Values of `EnsembleParameters::radius`.
+    std::vector<float> gravities{9.8f};  ///< Values of `EnsembleParameters::gravity`.
+    int repeats = 1;                     ///< Number of runs of each combination.
+
+    /**
+     * @brief Lists the runs of the sweep.
+     *
+     * @return One entry per combination and repetition, the masses varying slowest.
+     */
+    std::vector<EnsembleParameters> expand() const;
+
+    /**
+     * @brief Reads a sweep from its text description.
+     *
+     * Parameters missing from the description keep their default values.
+     *
+     * @param in The description.
+     * @return The sweep.
+     * @throw std::runtime_error on an unknown parameter or an invalid value.
+     */
+    static ParameterSweep parse(std::istream& in);
+};
+
+/**
+ * @brief Measurements taken at the end of one simulation of an ensemble.
+ */
+struct EnsembleResult {
+    EnsembleParameters parameters;       ///< Parameters of the run.
+    size_t aliveParticles = 0;           ///< Particles left in the world.
+    Vec2 centerOfMass = Vec2(0, 0);      ///< Mean position of the particles left.
+    float kineticEnergy = 0;             ///< Total kinetic energy of the particles left.
+    double durationMs = 0;               ///< Wall-clock duration of the run.
+};
+
+/**
+ * @brief Runs many independent simulations at once, one per task of a thread pool.
+ *
+ * Each simulation steps a single-threaded `Context`: parallelism comes from
+ * running several simulations side by side, which scales much better than
+ * splitting small scenes across threads. Contexts are recycled between runs
+ * through `Context::clear`, so a run reuses the storage and per-step buffers
+ * grown by the previous runs instead of reallocating them. Runs are
+ * deterministic: a run only depends on its parameters, not on the context or
+ * thread it was given.
+ */
+class EnsembleRunner {
+public:
+    /// Fills a cleared context with the scene of a run.
+    using SceneBuilder = std::function<void(Context&, const EnsembleParameters&)>;
+
+    /**
+     * @brief Constructs a new runner.
+     *
+     * @param threadCount Number of simulations running at the same time.
+     */
+    explicit EnsembleRunner(unsigned threadCount = std::thread::hardware_concurrency());
+
+    /**
+     * @brief Runs every simulation of a sweep.
+     *
+     * The gravity of each run is set in the configuration of its context
+     * before the scene is built.
+     *
+     * @param sweep The parameter sweep.
+     * @param buildScene Function filling the context of each run.
+     * @param steps Number of steps of each run.
+     * @return The results, in the order of `sweep.expand()`.
+     */
+    std::vector<EnsembleResult> run(const ParameterSweep& sweep, const SceneBuilder& buildScene, int steps);
+
+    /**
+     * @brief Writes results as CSV, one line per run after a header.
+     *
+     * @param out The output stream.
+     * @param results The results to write.
+     */
+    static void writeCsv(std::ostream& out, const std::vector<EnsembleResult>& results);
+
+private:
+    ThreadPool pool;                                  ///< Pool running one simulation per task.
+    std::vector<std::unique_ptr<Context>> idleContexts;///< Contexts waiting for a run, kept between calls.
+    std::mutex contextMutex;                          ///< Protects `idleContexts`.
+
+    /**
+     * @brief Takes an idle context, or creates a single-threaded one.
+     *
+     * @return The context.
+     */
+    std::unique_ptr<Context> acquireContext();
+
+    /**
+     * @brief Gives a context back for the next runs.
+     *
+     * @param context The context.
+     */
+    void releaseContext(std::unique_ptr<Context> context);
+};
+
+#endif // ENSEMBLE_H
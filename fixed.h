@@ -0,0 +1,217 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Signed 32-bit fixed-point number with 16 fractional bits (Q16.16).
+ *
+ * Every operation is computed with integer arithmetic whose result is
+ * defined by the standard, so a computation in `Fixed` gives bit-identical
+ * results whatever the compiler, the CPU or the optimization flags. The
+ * range is about ±32768 with a resolution of 1/65536: scenes must be scaled
+ * so that positions and their products stay in range.
+ *
+ * Products are truncated towards negative infinity and quotients towards
+ * zero. Results outside the range, conversions included, saturate to the
+ * nearest representable value; a division by zero gives the end of the
+ * range on the side of the dividend, and 0 for 0/0.
+ */
+class Fixed {
+public:
+    static constexpr int fractionBits = 16;                       ///< Number of fractional bits.
+    static constexpr int32_t one = int32_t(1) << fractionBits;    ///< Raw value of 1.
+
+    /**
+     * @brief Constructs zero.
+     */
+    constexpr Fixed() = default;
+
+    /**
+     * @brief Constructs a fixed-point number from an integer.
+     *
+     * @param value The integer, saturated to `[-32768, 32767]`.
+     */
+    constexpr Fixed(int value) : raw(saturate(int64_t(value) * one)) {}
+
+    /**
+     * @brief Converts a floating-point number, rounding to the nearest representable value.
+     *
+     * @param value The number to convert, saturated to the range (NaN gives 0).
+     */
+    constexpr explicit Fixed(double value) : raw(fromDouble(value)) {}
+
+    /**
+     * @brief Builds a fixed-point number from its raw representation.
+     *
+     * @param raw The value multiplied by `one`.
+     * @return The fixed-point number.
+     */
+    static constexpr Fixed fromRaw(int32_t raw) {
+        Fixed result;
+        result.raw = raw;
+        return result;
+    }
+
+    /**
+     * @brief Gets the raw representation.
+     *
+     * @return The value multiplied by `one`.
+     */
+    constexpr int32_t getRaw() const { return raw; }
+
+    /**
+     * @brief Converts the number to floating point.
+     *
+     * @return The closest float.
+     */
+    constexpr explicit operator float() const { return static_cast<float>(raw) / one; }
+
+    /**
+     * @brief Converts the number to double precision.
+     *
+     * @return The exact value.
+     */
+    constexpr explicit operator double() const { return static_cast<double>(raw) / one; }
+
+    /// Arithmetic operators, computed on 64-bit integers and saturated.
+    constexpr Fixed operator+(Fixed other) const { return fromRaw(saturate(int64_t(raw) + other.raw)); }
+    constexpr Fixed operator-(Fixed other) const { return fromRaw(saturate(int64_t(raw) - other.raw)); }
+    constexpr Fixed operator-() const { return fromRaw(saturate(-int64_t(raw))); }
+    constexpr Fixed operator*(Fixed other) const {
+        //Produit sur 64 bits puis retour à 16 bits de fraction
+        return fromRaw(saturate(divideByOne(int64_t(raw) * other.raw)));
+    }
+    constexpr Fixed operator/(Fixed other) const {
+        if (other.raw == 0){
+            return fromRaw(raw > 0 ? INT32_MAX : raw < 0 ? INT32_MIN : 0);
+        }
+        return fromRaw(saturate(int64_t(raw) * one / other.raw));
+    }
+    constexpr Fixed& operator+=(Fixed other) { return *this = *this + other; }
+    constexpr Fixed& operator-=(Fixed other) { return *this = *this - other; }
+    constexpr Fixed& operator*=(Fixed other) { return *this = *this * other; }
+    constexpr Fixed& operator/=(Fixed other) { return *this = *this / other; }
+
+    /**
+     * @brief Clamps a raw value to the range of `Fixed`.
+     *
+     * @param value The raw value on 64 bits.
+     * @return The closest raw value on 32 bits.
+     */
+    static constexpr int32_t saturate(int64_t value) {
+        return static_cast<int32_t>(value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : value);
+    }
+
+    /// Comparison operators.
+    constexpr bool operator==(Fixed other) const { return raw == other.raw; }
+    constexpr bool operator!=(Fixed other) const { return raw != other.raw; }
+    constexpr bool operator<(Fixed other) const { return raw < other.raw; }
+    constexpr bool operator<=(Fixed other) const { return raw <= other.raw; }
+    constexpr bool operator>(Fixed other) const { return raw > other.raw; }
+    constexpr bool operator>=(Fixed other) const { return raw >= other.raw; }
+
+private:
+    int32_t raw = 0;  ///< Value multiplied by `one`.
+
+    /**
+     * @brief Divides by `one`, rounding towards negative infinity.
+     *
+     * Does what an arithmetic shift by `fractionBits` would, which C++17
+     * leaves implementation-defined on negative numbers.
+     *
+     * @param value The number to divide.
+     * @return The quotient.
+     */
+    static constexpr int64_t divideByOne(int64_t value) {
+        int64_t quotient = value / one;
+        return value % one < 0 ? quotient - 1 : quotient;
+    }
+
+    /**
+     * @brief Converts a floating-point number to a raw value, rounding to the nearest and saturating.
+     *
+     * @param value The number to convert.
+     * @return The raw value, 0 for NaN.
+     */
+    static constexpr int32_t fromDouble(double value) {
+        double scaled = value * one + (value >= 0 ? 0.5 : -0.5);
+        if (!(scaled == scaled)){
+            return 0;
+        }
+        //Les bornes sont testées en double : convertir un double hors limites n'est pas défini
+        if (scaled >= double(INT32_MAX)){
+            return INT32_MAX;
+        }
+        if (scaled <= double(INT32_MIN)){
+            return INT32_MIN;
+        }
+        return static_cast<int32_t>(scaled);
+    }
+};
+
+/**
+ * @brief Computes the integer square root of a 64-bit number.
+ *
+ * @param value The number.
+ * @return The largest integer whose square does not exceed `value`.
+ */
+constexpr uint64_t integerSqrt(uint64_t value){
+    uint64_t result = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > value){
+        bit >>= 2;
+    }
+    //Méthode chiffre par chiffre : exacte et sans flottant
+    while (bit != 0){
+        if (value >= result + bit){
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+/**
+ * @brief Computes the square root of a fixed-point number.
+ *
+ * @param value The number (negative values give 0).
+ * @return The square root, truncated.
+ */
+constexpr Fixed sqrt(Fixed value){
+    if (value.getRaw() <= 0){
+        return Fixed();
+    }
+    return Fixed::fromRaw(Fixed::saturate(int64_t(integerSqrt(uint64_t(value.getRaw()) << Fixed::fractionBits))));
+}
+
+/**
+ * @brief Computes the length of the vector `(x, y)` without intermediate overflow.
+ *
+ * @param x First component.
+ * @param y Second component.
+ * @return `sqrt(x² + y²)`, truncated.
+ */
+constexpr Fixed scalarNorm(Fixed x, Fixed y){
+    //Les carrés sont en Q32.32 : leur racine est directement en Q16.16
+    int64_t rx = x.getRaw();
+    int64_t ry = y.getRaw();
+    return Fixed::fromRaw(Fixed::saturate(int64_t(integerSqrt(uint64_t(rx * rx) + uint64_t(ry * ry)))));
+}
+
+/**
+ * @brief Writes a fixed-point number as a decimal value.
+ *
+ * @param out The stream.
+ * @param value The number.
+ * @return The stream.
+ */
+inline std::ostream& operator<<(std::ostream& out, Fixed value){
+    return out << static_cast<double>(value);
+}
+
+#endif // FIXED_H
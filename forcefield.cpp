@@ -0,0 +1,11 @@
+#include "forcefield.h"
+
+void ForceField::setRegion(const Vec2& min, const Vec2& max){
+    bounded = true;
+    regionMin = min;
+    regionMax = max;
+}
+
+void ForceField::clearRegion(){
+    bounded = false;
+}
@@ -0,0 +1,84 @@
+#ifndef FORCEFIELD_H
+#define FORCEFIELD_H
+
+#include <memory>
+#include <vector>
+#include "particle.h"
+
+/**
+ * @brief Base class for external force fields.
+ *
+ * A force field is evaluated in batch: `accumulate` is called once per block
+ * of particles and adds the acceleration of the field to every particle of
+ * the block in a tight loop, so that the cost of the virtual call is paid once
+ * per block rather than once per particle.
+ *
+ * A field may be restricted to an axis-aligned bounding region, in which case
+ * it only affects the particles whose position lies inside the region.
+ */
+class ForceField {
+public:
+    /**
+     * @brief Default constructor for ForceField.
+     */
+    ForceField() = default;
+
+    /**
+     * @brief Virtual destructor for ForceField.
+     */
+    virtual ~ForceField() = default;
+
+    /**
+     * @brief Adds the acceleration of the field to a block of particles.
+     *
+     * @param particles The particles of the simulation.
+     * @param first Index of the first particle of the block.
+     * @param last Past-the-end index of the block.
+     * @param accelerations Accumulator of the block, `accelerations[i - first]` belongs to particle `i`.
+     */
+    virtual void accumulate(const std::vector<Particle>& particles,
+                            size_t first, size_t last, Vec2* accelerations) const = 0;
+
+    /**
+     * @brief Restricts the field to an axis-aligned bounding region.
+     *
+     * @param min Lower corner of the region.
+     * @param max Upper corner of the region.
+     */
+    void setRegion(const Vec2& min, const Vec2& max);
+
+    /**
+     * @brief Removes the bounding region, the field then affects every particle.
+     */
+    void clearRegion();
+
+protected:
+    bool bounded = false;        ///< Whether the field is restricted to a region.
+    Vec2 regionMin = Vec2(0, 0); ///< Lower corner of the region.
+    Vec2 regionMax = Vec2(0, 0); ///< Upper corner of the region.
+
+    /**
+     * @brief Runs the batch loop of a field.
+     *
+     * Calls `acceleration(particle)` for every particle of the block lying in
+     * the region (if any) and adds the result to its accumulator. Being a
+     * template, the per-particle function is inlined in the loop.
+     */
+    template <typename Acceleration>
+    void forEachParticle(const std::vector<Particle>& particles,
+                         size_t first, size_t last, Vec2* accelerations, Acceleration&& acceleration) const {
+        for (size_t i = first; i < last; ++i){
+            const Particle& particle = particles[i];
+            if (bounded){
+                const Vec2& pos = particle.getPos();
+                if (pos.getx() < regionMin.getx() || pos.getx() > regionMax.getx()
+                    || pos.gety() < regionMin.gety() || pos.gety() > regionMax.gety()){
+                    continue;
+                }
+            }
+            accelerations[i - first] += acceleration(particle);
+        }
+    }
+};
+
+#endif // FORCEFIELD_H
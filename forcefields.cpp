@@ -0,0 +1,63 @@
+#include "forcefields.h"
+#include <cmath>
+
+GravityField::GravityField(Vec2 acceleration): acceleration(acceleration) {}
+
+void GravityField::accumulate(const std::vector<Particle>& particles,
+                              size_t first, size_t last, Vec2* accelerations) const{
+    forEachParticle(particles, first, last, accelerations, [this](const Particle&) {
+        return acceleration;
+    });
+}
+
+WindField::WindField(Vec2 wind, float coefficient): wind(wind), coefficient(coefficient) {}
+
+void WindField::accumulate(const std::vector<Particle>& particles,
+                           size_t first, size_t last, Vec2* accelerations) const{
+    forEachParticle(particles, first, last, accelerations, [this](const Particle& particle) {
+        return (wind - particle.getVelocity()) * (coefficient * particle.getInverseMass());
+    });
+}
+
+DragField::DragField(float coefficient): coefficient(coefficient) {}
+
+void DragField::accumulate(const std::vector<Particle>& particles,
+                           size_t first, size_t last, Vec2* accelerations) const{
+    forEachParticle(particles, first, last, accelerations, [this](const Particle& particle) {
+        return particle.getVelocity() * (-coefficient * particle.getInverseMass());
+    });
+}
+
+RadialField::RadialField(Vec2 center, float strength, float softening)
+    : center(center), strength(strength), softening(softening) {}
+
+void RadialField::accumulate(const std::vector<Particle>& particles,
+                             size_t first, size_t last, Vec2* accelerations) const{
+    const float softening2 = softening * softening;
+    forEachParticle(particles, first, last, accelerations, [&](const Particle& particle) {
+        Vec2 toCenter = center - particle.getPos();
+        float d2 = toCenter.dot(toCenter);
+        if (d2 == 0){
+            return Vec2(0, 0);
+        }
+        //Direction unitaire * strength / (d² + s²)
+        return toCenter * (strength / ((d2 + softening2) * std::sqrt(d2)));
+    });
+}
+
+VortexField::VortexField(Vec2 center, float strength, float softening)
+    : center(center), strength(strength), softening(softening) {}
+
+void VortexField::accumulate(const std::vector<Particle>& particles,
+                             size_t first, size_t last, Vec2* accelerations) const{
+    const float softening2 = softening * softening;
+    forEachParticle(particles, first, last, accelerations, [&](const Particle& particle) {
+        Vec2 fromCenter = particle.getPos() - center;
+        float d2 = fromCenter.dot(fromCenter);
+        if (d2 == 0){
+            return Vec2(0, 0);
+        }
+        Vec2 tangent(-fromCenter.gety(), fromCenter.getx());
+        return tangent * (strength / ((d2 + softening2) * std::sqrt(d2)));
+    });
+}
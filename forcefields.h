@@ -0,0 +1,126 @@
+#ifndef FORCEFIELDS_H
+#define FORCEFIELDS_H
+
+#include "forcefield.h"
+
+/**
+ * @file forcefields.h
+ * @brief Concrete force fields: gravity, wind, drag, radial attractor and vortex.
+ */
+
+/**
+ * @brief Uniform acceleration field, such as gravity.
+ */
+class GravityField : public ForceField {
+private:
+    Vec2 acceleration;  ///< Acceleration applied to every particle.
+
+public:
+    /**
+     * @brief Constructs a new `GravityField`.
+     *
+     * @param acceleration Acceleration applied to every particle, independently of its mass.
+     */
+    explicit GravityField(Vec2 acceleration);
+
+    void accumulate(const std::vector<Particle>& particles,
+                    size_t first, size_t last, Vec2* accelerations) const override;
+};
+
+/**
+ * @brief Wind field pulling the particles' velocities towards the air velocity.
+ *
+ * Applies the force `coefficient * (wind - velocity)`, so heavy particles are
+ * less affected than light ones.
+ */
+class WindField : public ForceField {
+private:
+    Vec2 wind;          ///< Velocity of the air.
+    float coefficient;  ///< Drag coefficient of the particles in the air.
+
+public:
+    /**
+     * @brief Constructs a new `WindField`.
+     *
+     * @param wind Velocity of the air.
+     * @param coefficient Drag coefficient of the particles in the air.
+     */
+    WindField(Vec2 wind, float coefficient);
+
+    void accumulate(const std::vector<Particle>& particles,
+                    size_t first, size_t last, Vec2* accelerations) const override;
+};
+
+/**
+ * @brief Linear drag field, applying the force `-coefficient * velocity`.
+ */
+class DragField : public ForceField {
+private:
+    float coefficient;  ///< Drag coefficient.
+
+public:
+    /**
+     * @brief Constructs a new `DragField`.
+     *
+     * @param coefficient Drag coefficient.
+     */
+    explicit DragField(float coefficient);
+
+    void accumulate(const std::vector<Particle>& particles,
+                    size_t first, size_t last, Vec2* accelerations) const override;
+};
+
+/**
+ * @brief Radial field attracting the particles towards a point (or repelling them).
+ *
+ * The acceleration is `strength / (d² + softening²)` along the direction of
+ * the center, where `d` is the distance to the center. A negative strength
+ * repels the particles.
+ */
+class RadialField : public ForceField {
+private:
+    Vec2 center;      ///< Center of attraction.
+    float strength;   ///< Strength of the attraction (negative to repel).
+    float softening;  ///< Distance under which the field stops growing.
+
+public:
+    /**
+     * @brief Constructs a new `RadialField`.
+     *
+     * @param center Center of attraction.
+     * @param strength Strength of the attraction (negative to repel).
+     * @param softening Distance under which the field stops growing.
+     */
+    RadialField(Vec2 center, float strength, float softening);
+
+    void accumulate(const std::vector<Particle>& particles,
+                    size_t first, size_t last, Vec2* accelerations) const override;
+};
+
+/**
+ * @brief Vortex field making the particles swirl around a point.
+ *
+ * The acceleration is tangential, with the same magnitude law as `RadialField`.
+ * A positive strength turns clockwise on screen (y pointing down).
+ */
+class VortexField : public ForceField {
+private:
+    Vec2 center;      ///< Center of the vortex.
+    float strength;   ///< Strength of the vortex (its sign gives the direction).
+    float softening;  ///< Distance under which the field stops growing.
+
+public:
+    /**
+     * @brief Constructs a new `VortexField`.
+     *
+     * @param center Center of the vortex.
+     * @param strength Strength of the vortex (its sign gives the direction).
+     * @param softening Distance under which the field stops growing.
+     */
+    VortexField(Vec2 center, float strength, float softening);
+
+    void accumulate(const std::vector<Particle>& particles,
+                    size_t first, size_t last, Vec2* accelerations) const override;
+};
+
+#endif // FORCEFIELDS_H
@@ -0,0 +1,50 @@
+#include "framearena.h"
+
+namespace {
+constexpr size_t bufferAlignment = alignof(std::max_align_t);
+}
+
+FrameArena::FrameArena(std::pmr::memory_resource* upstream): upstream(upstream){
+    bump.emplace(upstream);
+}
+
+FrameArena::~FrameArena(){
+    bump.reset();
+    if (buffer != nullptr){
+        upstream->deallocate(buffer, capacity, bufferAlignment);
+    }
+}
+
+void FrameArena::release(){
+    if (used <= capacity){
+        bump->release();
+        used = 0;
+        return;
+    }
+    //Le pas a débordé : le tampon prend la taille de ce pas, avec de la marge
+    bump.reset();
+    if (buffer != nullptr){
+        upstream->deallocate(buffer, capacity, bufferAlignment);
+    }
+    capacity = used + used / 2;
+    buffer = upstream->allocate(capacity, bufferAlignment);
+    bump.emplace(buffer, capacity, upstream);
+    used = 0;
+}
+
+size_t FrameArena::getCapacity() const{
+    return capacity;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment){
+    used += bytes + alignment - 1;
+    return bump->allocate(bytes, alignment);
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t){
+    //Tout est rendu d'un coup par release
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept{
+    return this == &other;
+}
@@ -0,0 +1,63 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+
+/**
+ * @brief Monotonic memory resource for the temporaries of a step, released at once at its end.
+ *
+ * Allocations bump a pointer into a buffer kept from one step to the next,
+ * and deallocations do nothing. `release` rewinds the buffer in constant
+ * time. A step that overflows the buffer gets its extra memory from the
+ * upstream resource; the buffer then grows to that step's high-water mark
+ * at the next `release`, so a steady state never reaches the upstream.
+ *
+ * Not thread-safe: the arena serves the serial parts of a step.
+ */
+class FrameArena : public std::pmr::memory_resource {
+public:
+    /**
+     * @brief Constructs an empty arena.
+     *
+     * @param upstream Resource providing the buffer and the overflow.
+     */
+    explicit FrameArena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    /**
+     * @brief Gives the buffer back to the upstream resource.
+     */
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * @brief Frees everything allocated since the previous release.
+     *
+     * Constant time unless the step overflowed the buffer, which is then
+     * reallocated at the size the step needed.
+     */
+    void release();
+
+    /**
+     * @brief Gets the size of the buffer.
+     *
+     * @return The bytes a step can allocate without reaching the upstream resource.
+     */
+    size_t getCapacity() const;
+
+private:
+    std::pmr::memory_resource* upstream;                       ///< Source of the buffer and of the overflow.
+    void* buffer = nullptr;                                    ///< Memory reused at every step.
+    size_t capacity = 0;                                       ///< Size of `buffer`.
+    size_t used = 0;                                           ///< Bytes requested since the last release, padding included.
+    std::optional<std::pmr::monotonic_buffer_resource> bump;   ///< Allocator working in `buffer`.
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif // FRAMEARENA_H
@@ -0,0 +1,175 @@
+#include "frameexporter.h"
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <QPainter>
+#include "context.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+}
+
+FrameExporter::FrameExporter(const ExportSettings& settings) : settings(settings){
+    if (this->settings.every < 1){
+        this->settings.every = 1;
+    }
+    if (this->settings.encoderThreads == 0){
+        this->settings.encoderThreads = 1;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(this->settings.directory, error);
+    if (error){
+        throw std::runtime_error("Impossible de créer le dossier " + this->settings.directory);
+    }
+    if (this->settings.format == ExportSettings::Format::Raw){
+        std::string path = (std::filesystem::path(this->settings.directory) / "frames.rgba").string();
+        rawFile = std::fopen(path.c_str(), "wb");
+        if (rawFile == nullptr){
+            throw std::runtime_error("Impossible d'ouvrir " + path);
+        }
+    }
+
+    //Toutes les images sont allouées une fois pour toutes
+    size_t bufferCount = this->settings.queueCapacity + this->settings.encoderThreads;
+    for (size_t i = 0; i < bufferCount; ++i){
+        buffers.emplace_back(this->settings.width, this->settings.height, QImage::Format_RGBA8888);
+        freeBuffers.push_back(i);
+    }
+    for (unsigned i = 0; i < this->settings.encoderThreads; ++i){
+        encoders.emplace_back([this]() { encoderLoop(); });
+    }
+}
+
+FrameExporter::~FrameExporter(){
+    finish();
+}
+
+void FrameExporter::capture(const Context& context){
+    if (capturedSteps++ % settings.every != 0){
+        return;
+    }
+    size_t buffer;
+    size_t index;
+    {
+        auto start = Clock::now();
+        std::unique_lock<std::mutex> lock(mutex);
+        //Contre-pression : on n'attend que si tous les tampons sont en file ou en cours d'encodage
+        bufferFreed.wait(lock, [this]() { return !freeBuffers.empty() || stopping; });
+        if (stopping){
+            return;
+        }
+        buffer = freeBuffers.back();
+        freeBuffers.pop_back();
+        index = stats.framesExported++;
+        std::chrono::duration<double, std::milli> blocked = Clock::now() - start;
+        stats.blockedMs += blocked.count();
+    }
+
+    //Le rendu lit le contexte : il se fait sur le fil de la simulation, entre deux pas
+    auto start = Clock::now();
+    render(context, buffers[buffer]);
+    std::chrono::duration<double, std::milli> rendering = Clock::now() - start;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.renderMs += rendering.count();
+        jobs.push_back(Job{index, buffer});
+    }
+    jobReady.notify_one();
+}
+
+void FrameExporter::finish(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping){
+            return;
+        }
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& encoder: encoders){
+        encoder.join();
+    }
+    encoders.clear();
+    if (rawFile != nullptr){
+        std::fclose(rawFile);
+        rawFile = nullptr;
+    }
+}
+
+ExportStats FrameExporter::getStats() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void FrameExporter::render(const Context& context, QImage& image){
+    image.fill(Qt::black);
+    QPainter p(&image);
+    const AABB& view = settings.view;
+    float viewWidth = view.max.getx() - view.min.getx();
+    float viewHeight = view.max.gety() - view.min.gety();
+    QTransform transform;
+    transform.scale(settings.width / viewWidth, settings.height / viewHeight);
+    transform.translate(-view.min.getx(), -view.min.gety());
+    p.setTransform(transform);
+
+    for (const auto& collider: context.getColliders()){
+        collider->draw(p);
+    }
+    context.findParticlesInBox(view, visibleParticles);
+    const auto& particles = context.getParticles();
+    for (size_t index: visibleParticles){
+        particles[index].draw(p);
+    }
+}
+
+bool FrameExporter::encode(const Job& job){
+    const QImage& image = buffers[job.buffer];
+    if (settings.format == ExportSettings::Format::Png){
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06zu.png", job.index);
+        std::string path = (std::filesystem::path(settings.directory) / name).string();
+        return image.save(QString::fromStdString(path), "PNG");
+    }
+
+    //Les images brutes sont ajoutées dans l'ordre, quel que soit l'encodeur qui les a prises
+    std::unique_lock<std::mutex> lock(rawMutex);
+    rawTurn.wait(lock, [&]() { return nextRawFrame == job.index; });
+    bool written = true;
+    size_t rowBytes = static_cast<size_t>(image.width()) * 4;
+    for (int y = 0; y < image.height() && written; ++y){
+        written = std::fwrite(image.constScanLine(y), 1, rowBytes, rawFile) == rowBytes;
+    }
+    nextRawFrame++;
+    lock.unlock();
+    rawTurn.notify_all();
+    return written;
+}
+
+void FrameExporter::encoderLoop(){
+    while (true){
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this]() { return !jobs.empty() || stopping; });
+            if (jobs.empty()){
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        bool written = encode(job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (written){
+                stats.framesWritten++;
+            } else {
+                stats.framesFailed++;
+            }
+            freeBuffers.push_back(job.buffer);
+        }
+        bufferFreed.notify_one();
+    }
+}
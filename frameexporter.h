@@ -0,0 +1,147 @@
+#ifndef FRAMEEXPORTER_H
+#define FRAMEEXPORTER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QImage>
+#include "aabb.h"
+
+class Context;
+
+/**
+ * @brief Parameters of an offscreen export.
+ */
+struct ExportSettings {
+    /// Output format of the frames.
+    enum class Format {
+        Png,  ///< One `frame_000000.png` file per exported frame.
+        Raw   ///< A single `frames.rgba` file of concatenated RGBA8888 frames.
+    };
+
+    std::string directory = "frames";          ///< Directory the frames are written to (created if needed).
+    Format format = Format::Png;                ///< Output format.
+    int width = 800;                            ///< Width of the frames (pixels).
+    int height = 600;                           ///< Height of the frames (pixels).
+    AABB view{Vec2(0, 0), Vec2(800, 600)};      ///< Region of the world mapped to the frames.
+    int every = 1;                              ///< Only every `every`-th captured step is exported.
+    unsigned encoderThreads = 2;                ///< Number of threads encoding and writing the frames.
+    size_t queueCapacity = 8;                   ///< Frames waiting for an encoder before `capture` blocks.
+};
+
+/**
+ * @brief Statistics of an offscreen export.
+ */
+struct ExportStats {
+    size_t framesExported = 0;   ///< Frames rendered and handed to the encoders.
+    size_t framesWritten = 0;    ///< Frames successfully written.
+    size_t framesFailed = 0;     ///< Frames that could not be written.
+    double renderMs = 0;         ///< Time spent rendering the frames on the simulation thread.
+    double blockedMs = 0;        ///< Time the simulation thread waited for a free buffer (back-pressure).
+};
+
+/**
+ * @brief Renders simulation frames offscreen and encodes them in the background.
+ *
+ * `capture` renders the context into an image buffer on the simulation
+ * thread, which is cheap, then hands the buffer to a pool of encoder threads
+ * which compress and write it while the simulation keeps going. The buffers
+ * come from a fixed pool of `queueCapacity + encoderThreads` images: they are
+ * never reallocated, and `capture` only blocks when they are all waiting to
+ * be encoded.
+ *
+ * Raw frames are appended in index order whichever encoder picked them up
+ * first, so the file is a plain stream of frames. It can be converted with
+ * `ffmpeg -f rawvideo -pixel_format rgba -video_size WxH -i frames.rgba out.mp4`.
+ */
+class FrameExporter {
+public:
+    /**
+     * @brief Creates the output directory and starts the encoder threads.
+     *
+     * @param settings Parameters of the export.
+     * @throw std::runtime_error if the output cannot be created.
+     */
+    explicit FrameExporter(const ExportSettings& settings);
+
+    /**
+     * @brief Waits for the pending frames (see `finish`).
+     */
+    ~FrameExporter();
+
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    /**
+     * @brief Called after each step: exports the frame if it is an `every`-th one.
+     *
+     * @param context The context to render. It is only read during the call.
+     */
+    void capture(const Context& context);
+
+    /**
+     * @brief Waits until every exported frame is written, then stops the encoders.
+     *
+     * Further calls to `capture` are ignored.
+     */
+    void finish();
+
+    /**
+     * @brief Gets the statistics of the export.
+     *
+     * @return The statistics, final once `finish` has returned.
+     */
+    ExportStats getStats() const;
+
+private:
+    /// A rendered frame waiting for an encoder.
+    struct Job {
+        size_t index;   ///< Index of the frame in the export.
+        size_t buffer;  ///< Index of its image in `buffers`.
+    };
+
+    ExportSettings settings;              ///< Parameters of the export.
+    std::vector<QImage> buffers;          ///< Fixed pool of frame buffers.
+    std::vector<size_t> freeBuffers;      ///< Buffers neither queued nor being encoded.
+    std::deque<Job> jobs;                 ///< Rendered frames, in export order.
+    std::vector<std::thread> encoders;    ///< Encoder threads.
+    std::vector<size_t> visibleParticles; ///< Particles found in the view, reused between frames.
+    std::FILE* rawFile = nullptr;         ///< Output of the raw format.
+    size_t capturedSteps = 0;             ///< Number of calls to `capture`.
+    bool stopping = false;                ///< Set by `finish`, protected by `mutex`.
+    ExportStats stats;                    ///< Statistics, protected by `mutex`.
+
+    mutable std::mutex mutex;             ///< Protects the queue, the free buffers and the statistics.
+    std::condition_variable jobReady;     ///< Signalled when a job is queued or the export stops.
+    std::condition_variable bufferFreed;  ///< Signalled when an encoder releases a buffer.
+    std::mutex rawMutex;                  ///< Protects `rawFile` and `nextRawFrame`.
+    std::condition_variable rawTurn;      ///< Signalled when a raw frame has been appended.
+    size_t nextRawFrame = 0;              ///< Index of the next frame to append to `rawFile`.
+
+    /**
+     * @brief Draws the colliders and the visible particles into a buffer.
+     *
+     * @param context The context to render.
+     * @param image The buffer.
+     */
+    void render(const Context& context, QImage& image);
+
+    /**
+     * @brief Writes a frame in the output format.
+     *
+     * @param job The frame.
+     * @return True if the frame was written.
+     */
+    bool encode(const Job& job);
+
+    /**
+     * @brief Loop of an encoder thread: encodes jobs until the export stops.
+     */
+    void encoderLoop();
+};
+
+#endif // FRAMEEXPORTER_H
@@ -3,7 +3,6 @@
 
 #include "drawarea.h"
 #include <qtimer.h>
-#include "constants.h"
 #include <QMessageBox>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -14,19 +13,22 @@ MainWindow::MainWindow(QWidget *parent)
 
     this->draw_area = std::make_unique<DrawArea>();
 
-    auto timer = new QTimer();
+    timer = new QTimer(this);
     QObject::connect(timer, &QTimer::timeout, [this]() {
-        draw_area->update();
+        draw_area->animate();
     });
-    timer->start(tau);
+    timer->start(draw_area->getFrameInterval());
+    //La durée d'une image suit la configuration, qui peut changer à chaque pas
+    QObject::connect(draw_area.get(), &DrawArea::frameIntervalChanged, timer, qOverload<int>(&QTimer::setInterval));
 
     ui->verticalLayout->addWidget(draw_area.get());
 
     QWidget::setWindowTitle("Position-based-dynamic");
 
-    QObject::connect(ui->actionR_initialiser, &QAction::triggered,
-                    this, [this]() { draw_area->resetContext();
-                                    QMessageBox::information(this, "Réinitialisation", "Le contexte a été réinitialisé !");});
+    //La réinitialisation n'a lieu qu'au pas suivant : on la confirme quand la simulation l'a appliquée
+    QObject::connect(ui->actionR_initialiser, &QAction::triggered, draw_area.get(), &DrawArea::resetContext);
+    QObject::connect(draw_area.get(), &DrawArea::contextReset,
+                    this, [this]() { QMessageBox::information(this, "Réinitialisation", "Le contexte a été réinitialisé !");});
 }
 
 MainWindow::~MainWindow()
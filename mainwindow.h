@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
 #include "drawarea.h"
 
 QT_BEGIN_NAMESPACE
@@ -42,6 +43,9 @@ private:
 
     /// Unique pointer to the `DrawArea` widget for rendering the simulation.
     std::unique_ptr<DrawArea> draw_area;
+
+    /// Timer driving the simulation, at the frame interval of its configuration.
+    QTimer *timer;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,43 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <cstdint>
+
+/// Index of a material in the table of a `Context` (0 is the default material).
+using MaterialId = std::uint16_t;
+
+/**
+ * @brief Surface and bulk properties of a particle or a collider.
+ *
+ * When two materials touch, the friction coefficients are combined with a
+ * geometric mean and the restitution with a maximum. The default material
+ * has neither friction nor restitution: contacts only push the objects
+ * apart.
+ */
+struct Material {
+    float staticFriction = 0;   ///< Tangential speed cancelled outright, relative to the normal correction speed.
+    float dynamicFriction = 0;  ///< Tangential speed removed while sliding, relative to the normal correction speed.
+    float restitution = 0;      ///< Fraction of the approach speed given back along the normal, in [0, 1].
+    float density = 1;          ///< Mass per unit area, see `massOf`.
+
+    /**
+     * @brief Gets the mass of a particle made of this material.
+     *
+     * @param radius The radius of the particle.
+     * @return `density` times the area of the disc.
+     */
+    float massOf(float radius) const {
+        return density * 3.14159265f * radius * radius;
+    }
+
+    /**
+     * @brief Tells whether the material changes the contact response.
+     *
+     * @return False if it has neither friction nor restitution.
+     */
+    bool hasResponse() const {
+        return staticFriction > 0 || dynamicFriction > 0 || restitution > 0;
+    }
+};
+
+#endif // MATERIAL_H
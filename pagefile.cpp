@@ -0,0 +1,149 @@
+#include "pagefile.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+/// Size of the file when it is created.
+constexpr size_t initialSize = size_t(1) << 20;
+
+}
+
+PageFile::PageFile(const std::string& path) : path(path), pageSize(static_cast<size_t>(sysconf(_SC_PAGESIZE))){
+    descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (descriptor < 0){
+        throw std::runtime_error("Impossible de créer le fichier de pagination " + path);
+    }
+    size = std::max(initialSize, pageSize);
+    void* address = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(size)) == 0){
+        address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    if (address == MAP_FAILED){
+        close(descriptor);
+        unlink(path.c_str());
+        throw std::runtime_error("Impossible de projeter le fichier de pagination " + path);
+    }
+    mapping = static_cast<char*>(address);
+    holes[0] = size;
+}
+
+PageFile::~PageFile(){
+    munmap(mapping, size);
+    close(descriptor);
+    unlink(path.c_str());
+}
+
+PageExtent PageFile::write(const void* data, size_t bytes){
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t capacity = std::max<size_t>((bytes + pageSize - 1) / pageSize, 1) * pageSize;
+    size_t offset = allocate(capacity);
+    std::memcpy(mapping + offset, data, bytes);
+    dropPages(offset, capacity);
+    return PageExtent{offset, bytes, capacity};
+}
+
+void PageFile::read(const PageExtent& extent, void* out) const{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::memcpy(out, mapping + extent.offset, extent.size);
+    dropPages(extent.offset, extent.capacity);
+}
+
+void PageFile::release(const PageExtent& extent){
+    std::lock_guard<std::mutex> lock(mutex);
+    addHole(extent.offset, extent.capacity);
+}
+
+size_t PageFile::getSize() const{
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+void PageFile::addHole(size_t offset, size_t length){
+    //Fusion avec les trous voisins pour limiter la fragmentation
+    auto next = holes.lower_bound(offset);
+    if (next != holes.end() && offset + length == next->first){
+        length += next->second;
+        next = holes.erase(next);
+    }
+    if (next != holes.begin()){
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset){
+            previous->second += length;
+            return;
+        }
+    }
+    holes.emplace(offset, length);
+}
+
+size_t PageFile::allocate(size_t capacity){
+    for (auto hole = holes.begin(); hole != holes.end(); ++hole){
+        if (hole->second >= capacity){
+            size_t offset = hole->first;
+            size_t remaining = hole->second - capacity;
+            holes.erase(hole);
+            if (remaining > 0){
+                holes.emplace(offset + capacity, remaining);
+            }
+            return offset;
+        }
+    }
+
+    //Aucun trou assez grand : le fichier double, au moins de quoi loger le bloc
+    size_t newSize = std::max(size * 2, size + capacity);
+    if (ftruncate(descriptor, static_cast<off_t>(newSize)) != 0){
+        throw std::runtime_error("Impossible d'agrandir le fichier de pagination " + path);
+    }
+    void* address = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (address == MAP_FAILED){
+        throw std::runtime_error("Impossible de projeter le fichier de pagination " + path);
+    }
+    munmap(mapping, size);
+    mapping = static_cast<char*>(address);
+    size_t grownFrom = size;
+    size = newSize;
+    addHole(grownFrom, newSize - grownFrom);
+    return allocate(capacity);
+}
+
+void PageFile::dropPages(size_t offset, size_t length) const{
+    //Les données restent dans le fichier : seule la projection est libérée
+    madvise(mapping + offset, length, MADV_DONTNEED);
+}
+
+#else
+
+PageFile::PageFile(const std::string& path) : path(path){
+    throw std::runtime_error("La pagination par fichier projeté n'est pas disponible sur ce système");
+}
+
+PageFile::~PageFile() = default;
+
+PageExtent PageFile::write(const void*, size_t){
+    return PageExtent();
+}
+
+void PageFile::read(const PageExtent&, void*) const {}
+
+void PageFile::release(const PageExtent&) {}
+
+size_t PageFile::getSize() const{
+    return 0;
+}
+
+size_t PageFile::allocate(size_t){
+    return 0;
+}
+
+void PageFile::addHole(size_t, size_t) {}
+
+void PageFile::dropPages(size_t, size_t) const {}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Location of a block of data in a `PageFile`.
+ */
+struct PageExtent {
+    size_t offset = 0;    ///< Offset of the block in the file, a multiple of the system page size.
+    size_t size = 0;      ///< Number of bytes written.
+    size_t capacity = 0;  ///< Bytes reserved for the block, `size` rounded up to whole system pages.
+};
+
+/**
+ * @brief Scratch file, mapped in memory, holding blocks of data written out of the process.
+ *
+ * Blocks are reserved in whole system pages, first fit in the space released
+ * by previous blocks, the file growing when none fits. Once a block is
+ * written or read, its pages are dropped from the mapping: the data stays in
+ * the file and the kernel page cache, which the system can write back and
+ * reclaim, and no longer counts in the resident memory of the process.
+ *
+ * All operations are thread-safe. The file is removed on destruction.
+ * Only available on POSIX systems.
+ */
+class PageFile {
+public:
+    /**
+     * @brief Creates the file, truncating it if it exists.
+     *
+     * @param path Path of the file.
+     * @throw std::runtime_error if the file cannot be created or mapped.
+     */
+    explicit PageFile(const std::string& path);
+
+    /**
+     * @brief Unmaps, closes and removes the file.
+     */
+    ~PageFile();
+
+    PageFile(const PageFile&) = delete;
+    PageFile& operator=(const PageFile&) = delete;
+
+    /**
+     * @brief Writes a block.
+     *
+     * @param data The bytes to write.
+     * @param size Number of bytes.
+     * @return The location of the block, to give to `read` and `release`.
+     * @throw std::runtime_error if the file cannot grow.
+     */
+    PageExtent write(const void* data, size_t size);
+
+    /**
+     * @brief Reads a block back.
+     *
+     * @param extent The location returned by `write`.
+     * @param out Receives `extent.size` bytes.
+     */
+    void read(const PageExtent& extent, void* out) const;
+
+    /**
+     * @brief Releases the space of a block, to be reused by the next writes.
+     *
+     * @param extent The location returned by `write`.
+     */
+    void release(const PageExtent& extent);
+
+    /**
+     * @brief Gets the size of the file.
+     *
+     * @return The size in bytes, released blocks included.
+     */
+    size_t getSize() const;
+
+private:
+    std::string path;                  ///< Path of the file.
+    int descriptor = -1;               ///< File descriptor.
+    char* mapping = nullptr;           ///< Mapping of the whole file.
+    size_t size = 0;                   ///< Size of the file and of the mapping.
+    size_t pageSize = 4096;            ///< System page size.
+    std::map<size_t, size_t> holes;    ///< Released space: size of each free range, by offset, coalesced.
+    mutable std::mutex mutex;          ///< Protects the mapping and `holes`.
+
+    /**
+     * @brief Reserves space for a block, growing the file if needed.
+     *
+     * @param capacity Number of bytes, a multiple of `pageSize`.
+     * @return The offset of the space.
+     */
+    size_t allocate(size_t capacity);
+
+    /**
+     * @brief Adds a range to the free space, merged with its neighbours.
+     *
+     * @param offset Offset of the range.
+     * @param length Length of the range.
+     */
+    void addHole(size_t offset, size_t length);
+
+    /**
+     * @brief Drops the pages of a range from the mapping.
+     *
+     * @param offset Offset of the range, a multiple of `pageSize`.
+     * @param length Length of the range.
+     */
+    void dropPages(size_t offset, size_t length) const;
+};
+
+#endif // PAGEFILE_H
@@ -1,8 +1,10 @@
 #include "particle.h"
-#include "StaticConstraint.h"
+#include "contactconstraint.h"
 #include "constants.h"
 
-Particle::Particle(Vec2 pos,Vec2 vel, float rad,float mass):pos(pos),expected_pos(pos),velocity(vel),fext(Vec2 (0,0)),radius(rad),mass(mass){}
+static_assert(sleep_frames <= UINT8_MAX, "restingFrames est stocké sur un octet");
+
+Particle::Particle(Vec2 pos,Vec2 vel, float rad,float mass,float lifetime,MaterialId material):pos(pos),expected_pos(pos),velocity(vel),lifetime(lifetime),radius(rad),mass(mass),material(material),restingFrames(0),alive(true){}
 
 const Vec2& Particle::getPos() const{
     return pos;
@@ -25,40 +27,79 @@ const Vec2& Particle::getVelocity() const{
 }
 
 void Particle::changeVelocity(const Vec2& newVelocity){
-    if (newVelocity.norm() > max_speed){
-        velocity = newVelocity.normalize() * max_speed;
-        return;
-    }
     velocity = newVelocity;
 }
 
-const Vec2& Particle::getFext() const{
-    return fext;
+float Particle::getRadius() const{
+    return radius;
 }
 
-void Particle::resetFext(){
-    fext = Vec2(0,0);
+float Particle::getMass() const{
+    return mass;
 }
 
-void Particle::changeFext(const Vec2& newFext){
-    fext = newFext;
+float Particle::getInverseMass() const{
+    return 1 / mass;
 }
 
-//Pour la gravité, on recrée un vecteur donc pour éviter les copies
-//inutiles, on privéligie une RValue ref
-void Particle::changeFext(Vec2&& newFext){
-    fext = newFext;
+MaterialId Particle::getMaterial() const{
+    return material;
 }
 
-float Particle::getRadius() const{
-    return radius;
+void Particle::changeMaterial(MaterialId newMaterial){
+    material = newMaterial;
 }
 
-float Particle::getMass() const{
-    return mass;
+float Particle::getLifetime() const{
+    return lifetime;
+}
+
+void Particle::age(float dt){
+    lifetime -= dt;
+}
+
+bool Particle::isExpired() const{
+    return lifetime <= 0;
+}
+
+bool Particle::isAlive() const{
+    return alive;
+}
+
+void Particle::kill(){
+    alive = false;
+}
+
+bool Particle::isAsleep() const{
+    return restingFrames >= sleep_frames;
+}
+
+void Particle::updateSleep(float speed){
+    if (speed > sleep_speed){
+        restingFrames = 0;
+    } else if (restingFrames < sleep_frames){
+        restingFrames++;
+    }
+}
+
+void Particle::wakeUp(){
+    restingFrames = 0;
+}
+
+void Particle::fallAsleep(){
+    restingFrames = sleep_frames;
+}
+
+const CollisionFilter& Particle::getFilter() const{
+    return filter;
+}
+
+void Particle::changeFilter(const CollisionFilter& newFilter){
+    filter = newFilter;
 }
 
 void Particle::draw(QPainter& p) const{
+    float radius = getRadius();
     QRectF target(pos.getx() - radius,
                   pos.gety() - radius,
                   radius * 2, radius * 2);
@@ -67,14 +108,15 @@ void Particle::draw(QPainter& p) const{
     p.drawEllipse(target);
 }
 
-std::optional<StaticConstraint> Particle::checkContact(Particle& other){
+std::optional<ContactConstraint> Particle::checkContact(Particle& other){
     Vec2 xji = expected_pos - other.expected_pos;
-    float C = xji.norm() - (radius + other.radius);
+    float dist = xji.norm();
+    float C = dist - (getRadius() + other.getRadius());
     if (C<0){
-        float sigmai = 1/mass * 1/(1/mass + 1/other.mass) * C;
-        Vec2 delta = xji * (-sigmai) / (xji.norm() + 0.001); // + 0.001 pour éviter la division par zero !
-        StaticConstraint constraint (delta,this);
-        return std::optional<StaticConstraint>(constraint);
+        //Particules confondues : la normale est arbitraire, on choisit la verticale
+        //plutôt que de diviser par une distance nulle
+        Vec2 normal = dist > 0 ? xji / dist : Vec2(0, -1);
+        return ContactConstraint(normal, C, this, &other);
     }
     return std::nullopt;
 }
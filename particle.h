@@ -2,15 +2,19 @@
 #define PARTICLE_H
 
 #include "vec2.h"
+#include "collisionfilter.h"
+#include "material.h"
+#include <cstdint>
+#include <limits>
 #include <optional>
 #include <QPainter>
 
 /**
- * @brief Forward declaration of `StaticConstraint`.
+ * @brief Forward declaration of `ContactConstraint`.
  *
- * This avoids circular dependencies between `Particle` and `StaticConstraint`.
+ * This avoids circular dependencies between `Particle` and `ContactConstraint`.
  */
-class StaticConstraint;
+class ContactConstraint;
 
 /**
  * @brief Represents a particle in the simulation.
@@ -18,15 +22,27 @@ class StaticConstraint;
  * The `Particle` class models a point-like object with physical properties
  * such as position, velocity, radius, and mass. It supports interactions
  * with other particles and colliders in the simulation.
+ *
+ * Particles are stored by value in large arrays, so the class is kept
+ * compact (48 bytes): external forces are evaluated on the fly by the
+ * integration instead of being accumulated in the particle, and the material
+ * is a 16-bit index into the table of the `Context`. The radius and the mass
+ * are stored in the particle: an index into a shared table would cost a
+ * lookup in every contact, and a table that is never emptied grows with
+ * every distinct radius of a polydisperse scene.
  */
 class Particle {
 private:
     Vec2 pos;               ///< Current position of the particle.
     Vec2 expected_pos;      ///< Predicted position of the particle (used for constraint resolution).
     Vec2 velocity;          ///< Current velocity of the particle.
-    Vec2 fext;              ///< External forces applied to the particle.
+    float lifetime;         ///< Remaining lifetime of the particle (s), infinite by default.
+    CollisionFilter filter; ///< Collision layer and mask of the particle.
     float radius;           ///< Radius of the particle.
     float mass;             ///< Mass of the particle.
+    MaterialId material;    ///< Material of the particle, in the table of the `Context`.
+    std::uint8_t restingFrames;   ///< Number of consecutive steps spent under `sleep_speed`, saturated at `sleep_frames`.
+    bool alive;             ///< False once the particle has been removed, until its slot is reused.
 
 public:
     /**
@@ -36,8 +52,11 @@ public:
      * @param vel Initial velocity of the particle.
      * @param rad Radius of the particle.
      * @param mass Mass of the particle.
+     * @param lifetime Lifetime of the particle (s), infinite by default.
+     * @param material Material of the particle, in the table of the `Context`.
      */
-    Particle(Vec2 pos, Vec2 vel, float rad, float mass);
+    Particle(Vec2 pos, Vec2 vel, float rad, float mass,
+             float lifetime = std::numeric_limits<float>::infinity(), MaterialId material = 0);
 
     /**
      * @brief Default destructor for the `Particle`.
@@ -87,44 +106,119 @@ public:
     void changeVelocity(const Vec2& newVelocity);
 
     /**
-     * @brief Gets the external force acting on the particle.
+     * @brief Gets the radius of the particle.
      *
-     * @return A constant reference to the external force vector.
+     * @return The radius of the particle.
      */
-    const Vec2& getFext() const;
+    float getRadius() const;
 
     /**
-     * @brief Resets the external forces acting on the particle to zero.
+     * @brief Gets the mass of the particle.
+     *
+     * @return The mass of the particle.
      */
-    void resetFext();
+    float getMass() const;
 
     /**
-     * @brief Updates the external force acting on the particle.
+     * @brief Gets the inverse mass of the particle.
      *
-     * @param newFext The new external force to assign.
+     * @return `1/mass`, used to weight the corrections of two-body constraints.
      */
-    void changeFext(const Vec2& newFext);
+    float getInverseMass() const;
 
     /**
-     * @brief Updates the external force acting on the particle using an r-value reference.
+     * @brief Gets the material of the particle.
      *
-     * @param newFext The new external force to assign (moved).
+     * @return The index of the material in the table of the `Context`.
      */
-    void changeFext(Vec2&& newFext);
+    MaterialId getMaterial() const;
 
     /**
-     * @brief Gets the radius of the particle.
+     * @brief Changes the material of the particle.
      *
-     * @return The radius of the particle.
+     * The mass is kept: use `Material::massOf` to derive it from the density.
+     *
+     * @param newMaterial The index of the material in the table of the `Context`.
      */
-    float getRadius() const;
+    void changeMaterial(MaterialId newMaterial);
 
     /**
-     * @brief Gets the mass of the particle.
+     * @brief Gets the remaining lifetime of the particle.
      *
-     * @return The mass of the particle.
+     * @return The remaining lifetime (s), infinite for immortal particles.
      */
-    float getMass() const;
+    float getLifetime() const;
+
+    /**
+     * @brief Decreases the remaining lifetime of the particle.
+     *
+     * @param dt The elapsed time (s).
+     */
+    void age(float dt);
+
+    /**
+     * @brief Tells whether the lifetime of the particle is over.
+     *
+     * @return True if the remaining lifetime is not positive.
+     */
+    bool isExpired() const;
+
+    /**
+     * @brief Tells whether the particle is still part of the simulation.
+     *
+     * Removed particles keep their slot until the next compaction and are
+     * skipped by every stage of the simulation.
+     *
+     * @return False once the particle has been removed.
+     */
+    bool isAlive() const;
+
+    /**
+     * @brief Marks the particle as removed.
+     */
+    void kill();
+
+    /**
+     * @brief Tells whether the particle is asleep.
+     *
+     * A sleeping particle is not integrated: it keeps its position until a
+     * constraint moves it, or until the context wakes it up because its
+     * surroundings changed.
+     *
+     * @return True if the particle stayed at rest for `sleep_frames` steps.
+     */
+    bool isAsleep() const;
+
+    /**
+     * @brief Updates the sleep state of the particle after a step.
+     *
+     * @param speed The speed of the particle at the end of the step.
+     */
+    void updateSleep(float speed);
+
+    /**
+     * @brief Wakes the particle up: it is integrated again from the next step.
+     */
+    void wakeUp();
+
+    /**
+     * @brief Puts the particle to sleep at once, as if it had stayed at rest for `sleep_frames` steps.
+     */
+    void fallAsleep();
+
+    /**
+     * @brief Gets the collision layer and mask of the particle.
+     *
+     * @return A constant reference to the filter of the particle.
+     */
+    const CollisionFilter& getFilter() const;
+
+    /**
+     * @brief Changes the collision layer and mask of the particle.
+     *
+     * @param newFilter The new filter.
+     */
+    void changeFilter(const CollisionFilter& newFilter);
 
     /**
      * @brief Renders the particle using a QPainter.
@@ -139,13 +233,14 @@ public:
      * @brief Checks for contact between this particle and another particle.
      *
      * Determines if the particles are in contact and, if so, returns
-     * a `StaticConstraint` describing the necessary correction.
+     * a `ContactConstraint` moving both particles. It must be called once
+     * per unordered pair of distinct particles.
      *
      * @param other The other particle to check contact with.
-     * @return A `std::optional<StaticConstraint>` containing the constraint
+     * @return A `std::optional<ContactConstraint>` containing the constraint
      *         if a contact is detected, or `std::nullopt` otherwise.
      */
-    std::optional<StaticConstraint> checkContact(Particle& other);
+    std::optional<ContactConstraint> checkContact(Particle& other);
 };
 
 #endif // PARTICLE_H
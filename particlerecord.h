@@ -0,0 +1,47 @@
+#ifndef PARTICLERECORD_H
+#define PARTICLERECORD_H
+
+#include <cstdint>
+#include "particle.h"
+
+/**
+ * @brief Plain state of a particle, copied byte for byte to another process or to a file.
+ */
+struct ParticleRecord {
+    float x, y;             ///< Position.
+    float vx, vy;           ///< Velocity.
+    float radius;           ///< Radius.
+    float mass;             ///< Mass.
+    float lifetime;         ///< Remaining lifetime.
+    std::uint32_t layer;    ///< Collision layer.
+    std::uint32_t mask;     ///< Collision mask.
+    std::uint32_t material; ///< Material, an index valid in every process building the same material table.
+};
+
+/**
+ * @brief Copies the state of a particle into a record.
+ *
+ * @param particle The particle.
+ * @return The record.
+ */
+inline ParticleRecord toRecord(const Particle& particle){
+    return ParticleRecord{particle.getPos().getx(), particle.getPos().gety(),
+                          particle.getVelocity().getx(), particle.getVelocity().gety(),
+                          particle.getRadius(), particle.getMass(), particle.getLifetime(),
+                          particle.getFilter().layer, particle.getFilter().mask, particle.getMaterial()};
+}
+
+/**
+ * @brief Rebuilds a particle from its record.
+ *
+ * @param record The record.
+ * @return The particle, awake.
+ */
+inline Particle fromRecord(const ParticleRecord& record){
+    Particle particle(Vec2(record.x, record.y), Vec2(record.vx, record.vy), record.radius, record.mass, record.lifetime,
+                      static_cast<MaterialId>(record.material));
+    particle.changeFilter(CollisionFilter{record.layer, record.mask});
+    return particle;
+}
+
+#endif // PARTICLERECORD_H
@@ -23,6 +23,42 @@ std::optional<StaticConstraint> PlanCollider::checkContact(Particle& particle) c
     return std::nullopt;
 }
 
+bool PlanCollider::isBakeable() const{
+    return true;
+}
+
+float PlanCollider::signedDistance(const Vec2& p, Vec2& gradient) const{
+    gradient = normal;
+    return (p - point).dot(normal);
+}
+
+std::optional<float> PlanCollider::rayCast(const Vec2& origin, const Vec2& direction, float maxDistance, Vec2& normal) const{
+    normal = this->normal;
+    float height = (origin - point).dot(this->normal);
+    if (height <= 0){
+        return 0.0f;
+    }
+    //Rayon parallèle au plan ou qui s'en éloigne
+    float approach = direction.dot(this->normal);
+    if (approach >= 0){
+        return std::nullopt;
+    }
+    float t = -height / approach;
+    if (t > maxDistance){
+        return std::nullopt;
+    }
+    return t;
+}
+
+void PlanCollider::translate(const Vec2& offset){
+    point += offset;
+}
+
+void PlanCollider::rotate(const Vec2& pivot, float angle){
+    point = rotateAround(point, pivot, angle);
+    normal = rotateAround(normal, Vec2(0, 0), angle);
+}
+
 /*    //Vec2 pc = normal*((particle.expected_pos-point).dot(normal) - particle.radius);
     Vec2 pc = particle.expected_pos + normal*(-particle.radius);
     Vec2 nc = normal;
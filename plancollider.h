@@ -50,6 +50,48 @@ public:
      *         if a contact is detected, or `std::nullopt` otherwise.
      */
     std::optional<StaticConstraint> checkContact(Particle& particle) const override;
+
+    /**
+     * @brief Tells whether the collider can be baked into a signed-distance grid.
+     *
+     * @return Always true.
+     */
+    bool isBakeable() const override;
+
+    /**
+     * @brief Evaluates the signed distance from a point to the plane.
+     *
+     * @param p The point.
+     * @param gradient Receives the outward normal at `p`.
+     * @return The signed distance, negative inside the plane.
+     */
+    float signedDistance(const Vec2& p, Vec2& gradient) const override;
+
+    /**
+     * @brief Intersects a ray with the plane analytically.
+     *
+     * @param origin Origin of the ray.
+     * @param direction Unit direction of the ray.
+     * @param maxDistance Length of the ray.
+     * @param normal Receives the outward normal at the hit point.
+     * @return The distance to the surface, 0 from inside, or `std::nullopt`.
+     */
+    std::optional<float> rayCast(const Vec2& origin, const Vec2& direction, float maxDistance, Vec2& normal) const override;
+
+    /**
+     * @brief Moves the plane.
+     *
+     * @param offset The displacement to apply.
+     */
+    void translate(const Vec2& offset) override;
+
+    /**
+     * @brief Rotates the plane.
+     *
+     * @param pivot Center of the rotation.
+     * @param angle Angle of the rotation, in radians.
+     */
+    void rotate(const Vec2& pivot, float angle) override;
 };
 
 #endif // PLANCOLLIDER_H
@@ -0,0 +1,171 @@
+#include "polygoncollider.h"
+#include "segmentcollider.h"
+#include <cmath>
+#include <stdexcept>
+
+PolygonCollider::PolygonCollider(std::vector<Vec2> vertices, bool closed)
+    : vertices(std::move(vertices)), closed(closed) {
+    if (this->vertices.size() < 2){
+        throw std::invalid_argument("A polygon collider needs at least 2 vertices");
+    }
+    //Un polygone plein à 2 sommets n'est qu'un segment
+    if (this->vertices.size() == 2){
+        this->closed = false;
+    }
+    rebuild();
+}
+
+size_t PolygonCollider::edgeCount() const{
+    return closed ? vertices.size() : vertices.size() - 1;
+}
+
+AABB PolygonCollider::edgeBounds(size_t edge) const{
+    const Vec2& a = vertices[edge];
+    const Vec2& b = vertices[(edge + 1) % vertices.size()];
+    return AABB{Vec2(std::fmin(a.getx(), b.getx()), std::fmin(a.gety(), b.gety())),
+                Vec2(std::fmax(a.getx(), b.getx()), std::fmax(a.gety(), b.gety()))};
+}
+
+void PolygonCollider::rebuild(){
+    size_t n = vertices.size();
+    //Signe de l'aire : donne le sens de parcours, donc le côté extérieur des arêtes
+    float area = 0;
+    for (size_t i = 0; i < n; ++i){
+        const Vec2& a = vertices[i];
+        const Vec2& b = vertices[(i + 1) % n];
+        area += a.getx() * b.gety() - b.getx() * a.gety();
+    }
+    float side = area >= 0 ? 1.0f : -1.0f;
+
+    edgeNormals.clear();
+    std::vector<AABB> boxes;
+    boxes.reserve(edgeCount());
+    for (size_t i = 0; i < edgeCount(); ++i){
+        Vec2 ab = vertices[(i + 1) % n] - vertices[i];
+        edgeNormals.push_back(ab.norm() > 0 ? Vec2(ab.gety() * side, -ab.getx() * side).normalize() : Vec2(0, -1));
+        boxes.push_back(edgeBounds(i));
+    }
+    vertexNormals.clear();
+    for (size_t i = 0; i < n; ++i){
+        size_t previous = closed ? (i + n - 1) % n : (i > 0 ? i - 1 : 0);
+        size_t next = std::min(i, edgeCount() - 1);
+        Vec2 sum = edgeNormals[previous] + edgeNormals[next];
+        //Pointe de largeur nulle : les normales s'annulent
+        vertexNormals.push_back(sum.norm() > 0 ? sum.normalize() : edgeNormals[next]);
+    }
+
+    bounds = boxes.front();
+    for (const AABB& box: boxes){
+        bounds = bounds.merged(box);
+    }
+    edges.build(boxes);
+}
+
+float PolygonCollider::distanceToEdge(const Vec2& p, size_t edge, Vec2& gradient) const{
+    size_t next = (edge + 1) % vertices.size();
+    float t;
+    Vec2 fromEdge = p - closestPointOnSegment(p, vertices[edge], vertices[next], t);
+    float dist = fromEdge.norm();
+    if (!closed){
+        gradient = dist > 0 ? fromEdge / dist : edgeNormals[edge];
+        return dist;
+    }
+    //Le point le plus proche est un sommet ou l'intérieur de l'arête
+    const Vec2& featureNormal = t <= 0 ? vertexNormals[edge] : (t >= 1 ? vertexNormals[next] : edgeNormals[edge]);
+    float side = fromEdge.dot(featureNormal) < 0 ? -1.0f : 1.0f;
+    gradient = dist > 0 ? fromEdge * (side / dist) : featureNormal;
+    return dist * side;
+}
+
+void PolygonCollider::draw(QPainter& p) const{
+    p.setPen(Qt::white);
+    size_t n = vertices.size();
+    for (size_t i = 0; i < edgeCount(); ++i){
+        const Vec2& a = vertices[i];
+        const Vec2& b = vertices[(i + 1) % n];
+        p.drawLine(QPointF(a.getx(), a.gety()), QPointF(b.getx(), b.gety()));
+    }
+}
+
+std::optional<StaticConstraint> PolygonCollider::checkContact(Particle& particle) const{
+    const Vec2& p = particle.getExpectedPos();
+    float radius = particle.getRadius();
+
+    //Seules les arêtes dont la boîte recoupe le trajet de la particule sont testées
+    float bestDistance = std::numeric_limits<float>::infinity();
+    size_t bestEdge = Bvh::npos;
+    float firstCrossing = std::numeric_limits<float>::infinity();
+    size_t crossedEdge = Bvh::npos;
+    AABB swept = AABB::around(p, radius).merged(AABB::around(particle.getPos(), radius));
+    edges.query(swept, [&](size_t edge) {
+        const Vec2& a = vertices[edge];
+        const Vec2& b = vertices[(edge + 1) % vertices.size()];
+        float s;
+        if (!closed && segmentsCross(particle.getPos(), p, a, b, s) && s < firstCrossing){
+            firstCrossing = s;
+            crossedEdge = edge;
+        }
+        float t;
+        float dist = (p - closestPointOnSegment(p, a, b, t)).norm();
+        if (dist < bestDistance){
+            bestDistance = dist;
+            bestEdge = edge;
+        }
+    });
+    //Une chaîne n'a pas d'épaisseur : une particule rapide qui l'a traversée est ramenée
+    if (crossedEdge != Bvh::npos){
+        return crossingConstraint(particle, vertices[crossedEdge], vertices[crossedEdge + 1], firstCrossing);
+    }
+
+    Vec2 normal(0, -1);
+    float sdf;
+    if (bestEdge != Bvh::npos && bestDistance <= radius){
+        sdf = distanceToEdge(p, bestEdge, normal);
+    } else if (closed && bounds.contains(p)){
+        //Aucune arête à portée : la particule peut être enfoncée loin à l'intérieur
+        sdf = signedDistance(p, normal);
+    } else {
+        return std::nullopt;
+    }
+    float C = sdf - radius;
+    if (C < 0){
+        Vec2 delta = normal * (-C);
+        StaticConstraint constraint (delta,&particle);
+        return std::optional<StaticConstraint>(constraint);
+    }
+    return std::nullopt;
+}
+
+bool PolygonCollider::isBakeable() const{
+    return true;
+}
+
+float PolygonCollider::signedDistance(const Vec2& p, Vec2& gradient) const{
+    size_t n = vertices.size();
+    size_t edge = edges.nearest(p, [&](size_t e) {
+        float t;
+        return (p - closestPointOnSegment(p, vertices[e], vertices[(e + 1) % n], t)).norm();
+    });
+    return distanceToEdge(p, edge, gradient);
+}
+
+std::optional<AABB> PolygonCollider::getBounds() const{
+    return bounds;
+}
+
+void PolygonCollider::translate(const Vec2& offset){
+    for (Vec2& vertex: vertices){
+        vertex += offset;
+    }
+    //Les normales ne changent pas : seules les boîtes sont décalées
+    bounds = AABB{bounds.min + offset, bounds.max + offset};
+    edges.translate(offset);
+}
+
+void PolygonCollider::rotate(const Vec2& pivot, float angle){
+    for (Vec2& vertex: vertices){
+        vertex = rotateAround(vertex, pivot, angle);
+    }
+    //Les normales et toutes les boîtes des arêtes changent
+    rebuild();
+}
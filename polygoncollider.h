@@ -0,0 +1,133 @@
+#ifndef POLYGONCOLLIDER_H
+#define POLYGONCOLLIDER_H
+
+#include <vector>
+#include "collider.h"
+#include "bvh.h"
+
+/**
+ * @brief Represents a polygonal collider in the simulation.
+ *
+ * A closed polygon is a solid, convex or concave, whose inside pushes the
+ * particles out through the closest edge. An open polygon is a thin chain of
+ * segments that particles cannot cross, e.g. the walls of a pinball table:
+ * like a `SegmentCollider`, it brings back the particles whose predicted
+ * motion crosses one of its edges.
+ *
+ * The edges are stored in a bounding-volume hierarchy, so a particle is only
+ * tested against the edges whose bounding box overlaps its own, and large
+ * outlines with thousands of edges stay cheap.
+ */
+class PolygonCollider : public Collider {
+private:
+    std::vector<Vec2> vertices;       ///< Vertices of the outline, in order.
+    bool closed;                      ///< True for a solid polygon, false for an open chain.
+    std::vector<Vec2> edgeNormals;    ///< Outward normal of each edge (edge `i` goes from vertex `i` to vertex `i + 1`).
+    std::vector<Vec2> vertexNormals;  ///< Pseudo-normal of each vertex, the mean of the normals of its edges.
+    Bvh edges;                        ///< Hierarchy of the bounding boxes of the edges.
+    AABB bounds;                      ///< Bounding box of the whole outline.
+
+    /**
+     * @brief Gets the number of edges.
+     *
+     * @return The number of vertices for a closed polygon, one less for an open chain.
+     */
+    size_t edgeCount() const;
+
+    /**
+     * @brief Gets the bounding box of one edge.
+     *
+     * @param edge Index of the edge.
+     * @return The bounding box of the edge.
+     */
+    AABB edgeBounds(size_t edge) const;
+
+    /**
+     * @brief Recomputes the normals, the bounds and the hierarchy from the vertices.
+     */
+    void rebuild();
+
+    /**
+     * @brief Computes the signed distance to a given edge.
+     *
+     * The sign is taken from the pseudo-normal of the closest feature of the
+     * edge, which is exact for the closest edge of a closed polygon. Open
+     * chains are two-sided and always get a positive distance.
+     *
+     * @param p The point.
+     * @param edge Index of the edge.
+     * @param gradient Receives the outward direction at `p`.
+     * @return The signed distance from `p` to the edge.
+     */
+    float distanceToEdge(const Vec2& p, size_t edge, Vec2& gradient) const;
+
+public:
+    /**
+     * @brief Constructs a new `PolygonCollider` object.
+     *
+     * @param vertices Vertices of the outline, in either winding order (at least 2).
+     * @param closed True for a solid polygon, false for an open chain of segments.
+     */
+    PolygonCollider(std::vector<Vec2> vertices, bool closed = true);
+
+    /**
+     * @brief Default destructor for the `PolygonCollider`.
+     */
+    ~PolygonCollider() override = default;
+
+    /**
+     * @brief Renders the outline using a `QPainter`.
+     *
+     * @param p The `QPainter` used for rendering.
+     */
+    void draw(QPainter& p) const override;
+
+    /**
+     * @brief Checks for contact between a particle and the polygon.
+     *
+     * @param particle The particle to check for contact.
+     * @return A `std::optional<StaticConstraint>` containing the constraint
+     *         if a contact is detected, or `std::nullopt` otherwise.
+     */
+    std::optional<StaticConstraint> checkContact(Particle& particle) const override;
+
+    /**
+     * @brief Tells whether the collider can be baked into a signed-distance grid.
+     *
+     * @return Always true.
+     */
+    bool isBakeable() const override;
+
+    /**
+     * @brief Evaluates the signed distance from a point to the polygon.
+     *
+     * @param p The point.
+     * @param gradient Receives the outward normal at `p`.
+     * @return The signed distance, negative inside a closed polygon.
+     */
+    float signedDistance(const Vec2& p, Vec2& gradient) const override;
+
+    /**
+     * @brief Gets the bounding box of the polygon.
+     *
+     * @return The bounding box of the outline.
+     */
+    std::optional<AABB> getBounds() const override;
+
+    /**
+     * @brief Moves the polygon.
+     *
+     * @param offset The displacement to apply.
+     */
+    void translate(const Vec2& offset) override;
+
+    /**
+     * @brief Rotates the polygon.
+     *
+     * @param pivot Center of the rotation.
+     * @param angle Angle of the rotation, in radians.
+     */
+    void rotate(const Vec2& pivot, float angle) override;
+};
+
+#endif // POLYGONCOLLIDER_H
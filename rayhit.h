@@ -0,0 +1,46 @@
+#ifndef RAYHIT_H
+#define RAYHIT_H
+
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include "vec2.h"
+
+/**
+ * @brief Closest intersection of a ray with the particles and colliders of a `Context`.
+ */
+struct RayHit {
+    float distance;      ///< Distance from the origin of the ray to the hit point.
+    Vec2 point;          ///< The hit point.
+    Vec2 normal;         ///< Outward normal of the surface at the hit point.
+    bool particle;       ///< True if a particle was hit, false for a collider.
+    size_t index;        ///< Index in `Context::getParticles()` or `Context::getColliders()`.
+};
+
+/**
+ * @brief Intersects a ray with a disc.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Unit direction of the ray.
+ * @param center Center of the disc.
+ * @param radius Radius of the disc.
+ * @return The distance along the ray to the boundary of the disc, 0 if the
+ *         origin is inside, or `std::nullopt` if the ray misses the disc.
+ */
+inline std::optional<float> rayDiscIntersection(const Vec2& origin, const Vec2& direction,
+                                                const Vec2& center, float radius){
+    Vec2 fromCenter = origin - center;
+    float c = fromCenter.dot(fromCenter) - radius * radius;
+    if (c <= 0){
+        return 0.0f;
+    }
+    float b = fromCenter.dot(direction);
+    float discriminant = b * b - c;
+    //Disque derrière l'origine ou manqué
+    if (b > 0 || discriminant < 0){
+        return std::nullopt;
+    }
+    return -b - std::sqrt(discriminant);
+}
+
+#endif // RAYHIT_H
@@ -0,0 +1,117 @@
+#include "sdfgrid.h"
+#include <algorithm>
+#include <cmath>
+
+void SdfGrid::bake(const std::vector<const Collider*>& colliders, const AABB& region,
+                   float cellSize, float band, ThreadPool& pool){
+    this->region = region;
+    this->cellSize = cellSize;
+    this->band = band;
+    //Au moins 2x2 noeuds pour pouvoir interpoler
+    columns = std::max(2, static_cast<int>(std::ceil((region.max.getx() - region.min.getx()) / cellSize)) + 1);
+    rows = std::max(2, static_cast<int>(std::ceil((region.max.gety() - region.min.gety()) / cellSize)) + 1);
+    distances.assign(static_cast<size_t>(columns) * rows, band);
+    normalsX.assign(distances.size(), 0);
+    normalsY.assign(distances.size(), -1);
+    sampleNodes(colliders, 0, columns, 0, rows, pool);
+}
+
+void SdfGrid::rebake(const std::vector<const Collider*>& colliders, const std::optional<AABB>& dirty, ThreadPool& pool){
+    if (!isBaked()){
+        return;
+    }
+    if (!dirty){
+        sampleNodes(colliders, 0, columns, 0, rows, pool);
+        return;
+    }
+    auto column = [&](float x) { return static_cast<int>(std::floor((x - region.min.getx()) / cellSize)); };
+    auto row = [&](float y) { return static_cast<int>(std::floor((y - region.min.gety()) / cellSize)); };
+    int x0 = std::max(0, column(dirty->min.getx()));
+    int x1 = std::min(columns, column(dirty->max.getx()) + 2);
+    int y0 = std::max(0, row(dirty->min.gety()));
+    int y1 = std::min(rows, row(dirty->max.gety()) + 2);
+    if (x0 < x1 && y0 < y1){
+        sampleNodes(colliders, x0, x1, y0, y1, pool);
+    }
+}
+
+void SdfGrid::clear(){
+    columns = 0;
+    rows = 0;
+    distances.clear();
+    normalsX.clear();
+    normalsY.clear();
+}
+
+bool SdfGrid::isBaked() const{
+    return !distances.empty();
+}
+
+float SdfGrid::getBand() const{
+    return band;
+}
+
+float SdfGrid::getCellSize() const{
+    return cellSize;
+}
+
+std::optional<AABB> SdfGrid::influenceOf(const Collider& collider) const{
+    std::optional<AABB> bounds = collider.getBounds();
+    if (!bounds){
+        return std::nullopt;
+    }
+    return AABB{bounds->min - Vec2(band, band), bounds->max + Vec2(band, band)};
+}
+
+void SdfGrid::sampleNodes(const std::vector<const Collider*>& colliders, int x0, int x1, int y0, int y1, ThreadPool& pool){
+    pool.parallelFor(y0, y1, pool.grainFor(y1 - y0, 8), [&](size_t first, size_t last) {
+        Vec2 gradient(0, -1);
+        for (size_t y = first; y < last; ++y){
+            for (int x = x0; x < x1; ++x){
+                Vec2 node(region.min.getx() + x * cellSize, region.min.gety() + y * cellSize);
+                float best = band;
+                Vec2 bestNormal(0, -1);
+                for (const Collider* collider: colliders){
+                    float d = collider->signedDistance(node, gradient);
+                    if (d < best){
+                        best = d;
+                        bestNormal = gradient;
+                    }
+                }
+                size_t index = y * columns + x;
+                distances[index] = std::max(best, -band);
+                normalsX[index] = bestNormal.getx();
+                normalsY[index] = bestNormal.gety();
+            }
+        }
+    });
+}
+
+bool SdfGrid::sample(const Vec2& p, float& distance, Vec2& normal) const{
+    if (!isBaked() || !region.contains(p)){
+        return false;
+    }
+    float fx = (p.getx() - region.min.getx()) / cellSize;
+    float fy = (p.gety() - region.min.gety()) / cellSize;
+    int x = std::min(static_cast<int>(fx), columns - 2);
+    int y = std::min(static_cast<int>(fy), rows - 2);
+    float tx = fx - x;
+    float ty = fy - y;
+
+    size_t i00 = static_cast<size_t>(y) * columns + x;
+    size_t i10 = i00 + 1;
+    size_t i01 = i00 + columns;
+    size_t i11 = i01 + 1;
+    float w00 = (1 - tx) * (1 - ty);
+    float w10 = tx * (1 - ty);
+    float w01 = (1 - tx) * ty;
+    float w11 = tx * ty;
+
+    distance = distances[i00] * w00 + distances[i10] * w10 + distances[i01] * w01 + distances[i11] * w11;
+    float nx = normalsX[i00] * w00 + normalsX[i10] * w10 + normalsX[i01] * w01 + normalsX[i11] * w11;
+    float ny = normalsY[i00] * w00 + normalsY[i10] * w10 + normalsY[i01] * w01 + normalsY[i11] * w11;
+    float length = std::sqrt(nx * nx + ny * ny);
+    //Normales opposées qui s'annulent (arête vive) : on garde celle du premier coin
+    normal = length > 0 ? Vec2(nx / length, ny / length) : Vec2(normalsX[i00], normalsY[i00]);
+    return true;
+}
@@ -0,0 +1,118 @@
+#ifndef SDFGRID_H
+#define SDFGRID_H
+
+#include <optional>
+#include <vector>
+#include "aabb.h"
+#include "collider.h"
+#include "threadpool.h"
+
+/**
+ * @brief Signed-distance field of the static colliders, sampled on a regular grid.
+ *
+ * The union of the baked colliders is sampled at the nodes of a grid covering
+ * a region of the world: each node stores the smallest signed distance and
+ * the outward normal of the closest collider. A particle then gets both its
+ * penetration depth and its contact normal from a single bilinear lookup,
+ * whatever the number of colliders.
+ *
+ * Distances are clamped to a narrow band around the surfaces, which bounds
+ * the influence of a finite collider and lets `rebake` only touch the nodes
+ * near a collider that was added or moved.
+ */
+class SdfGrid {
+public:
+    /**
+     * @brief Default constructor for `SdfGrid`.
+     */
+    SdfGrid() = default;
+
+    /**
+     * @brief Samples the colliders on a new grid.
+     *
+     * @param colliders The colliders to bake (they must be bakeable).
+     * @param region The region of the world covered by the grid.
+     * @param cellSize Distance between two nodes.
+     * @param band Distances are clamped to `[-band, band]`.
+     * @param pool The thread pool used to sample the nodes.
+     */
+    void bake(const std::vector<const Collider*>& colliders, const AABB& region,
+              float cellSize, float band, ThreadPool& pool);
+
+    /**
+     * @brief Resamples the nodes of a region after colliders were added or moved.
+     *
+     * @param colliders All the baked colliders, in their current state.
+     * @param dirty The region to resample, or `std::nullopt` for the whole grid.
+     * @param pool The thread pool used to sample the nodes.
+     */
+    void rebake(const std::vector<const Collider*>& colliders, const std::optional<AABB>& dirty, ThreadPool& pool);
+
+    /**
+     * @brief Forgets the grid.
+     */
+    void clear();
+
+    /**
+     * @brief Tells whether a grid has been baked.
+     *
+     * @return True after `bake` and until `clear`.
+     */
+    bool isBaked() const;
+
+    /**
+     * @brief Gets the width of the band in which distances are exact.
+     *
+     * @return The clamping distance given to `bake`.
+     */
+    float getBand() const;
+
+    /**
+     * @brief Gets the distance between two nodes.
+     *
+     * @return The cell size given to `bake`.
+     */
+    float getCellSize() const;
+
+    /**
+     * @brief Computes the region of influence of a collider, i.e. its bounds expanded by the band.
+     *
+     * @param collider The collider.
+     * @return The region whose nodes depend on the collider, or `std::nullopt` if it is unbounded.
+     */
+    std::optional<AABB> influenceOf(const Collider& collider) const;
+
+    /**
+     * @brief Interpolates the signed distance and the normal at a point.
+     *
+     * @param p The point.
+     * @param distance Receives the interpolated signed distance.
+     * @param normal Receives the interpolated unit normal.
+     * @return False if `p` lies outside the baked region, true otherwise.
+     */
+    bool sample(const Vec2& p, float& distance, Vec2& normal) const;
+
+private:
+    AABB region;                 ///< Region of the world covered by the grid.
+    float cellSize = 1;          ///< Distance between two nodes.
+    float band = 0;              ///< Clamping distance.
+    int columns = 0;             ///< Number of nodes along x.
+    int rows = 0;                ///< Number of nodes along y.
+    std::vector<float> distances;  ///< Clamped signed distance of each node, row-major.
+    std::vector<float> normalsX;   ///< x component of the normal of each node.
+    std::vector<float> normalsY;   ///< y component of the normal of each node.
+
+    /**
+     * @brief Samples the nodes of a rectangle of the grid.
+     *
+     * @param colliders The baked colliders.
+     * @param x0 First column.
+     * @param x1 Past-the-end column.
+     * @param y0 First row.
+     * @param y1 Past-the-end row.
+     * @param pool The thread pool used to sample the rows.
+     */
+    void sampleNodes(const std::vector<const Collider*>& colliders, int x0, int x1, int y0, int y1, ThreadPool& pool);
+};
+
+#endif // SDFGRID_H
@@ -0,0 +1,90 @@
+#include "segmentcollider.h"
+#include <algorithm>
+
+Vec2 closestPointOnSegment(const Vec2& p, const Vec2& a, const Vec2& b, float& t){
+    Vec2 ab = b - a;
+    float length2 = ab.dot(ab);
+    //Segment dégénéré en un point
+    t = length2 > 0 ? std::clamp((p - a).dot(ab) / length2, 0.0f, 1.0f) : 0.0f;
+    return a + ab * t;
+}
+
+bool segmentsCross(const Vec2& p0, const Vec2& p1, const Vec2& a, const Vec2& b, float& s){
+    Vec2 d = p1 - p0;
+    Vec2 e = b - a;
+    float denominator = d.getx() * e.gety() - d.gety() * e.getx();
+    //Segments parallèles : on ne considère pas qu'ils se croisent
+    if (denominator == 0){
+        return false;
+    }
+    Vec2 w = a - p0;
+    s = (w.getx() * e.gety() - w.gety() * e.getx()) / denominator;
+    float t = (w.getx() * d.gety() - w.gety() * d.getx()) / denominator;
+    return s >= 0 && s <= 1 && t >= 0 && t <= 1;
+}
+
+StaticConstraint crossingConstraint(Particle& particle, const Vec2& a, const Vec2& b, float s){
+    Vec2 ab = b - a;
+    Vec2 normal = ab.norm() > 0 ? Vec2(ab.gety(), -ab.getx()).normalize() : Vec2(0, -1);
+    if ((particle.getPos() - a).dot(normal) < 0){
+        normal = normal * -1;
+    }
+    //On ramène la position prédite au point de traversée, décalé d'un rayon du côté d'origine
+    Vec2 crossing = particle.getPos() + (particle.getExpectedPos() - particle.getPos()) * s;
+    return StaticConstraint(crossing + normal * particle.getRadius() - particle.getExpectedPos(), &particle);
+}
+
+SegmentCollider::SegmentCollider(Vec2 a, Vec2 b):a(a),b(b){}
+
+void SegmentCollider::draw(QPainter& p) const{
+    p.setPen(Qt::white);
+    p.drawLine(QPointF(a.getx(), a.gety()), QPointF(b.getx(), b.gety()));
+}
+
+std::optional<StaticConstraint> SegmentCollider::checkContact(Particle& particle) const{
+    float s;
+    if (segmentsCross(particle.getPos(), particle.getExpectedPos(), a, b, s)){
+        return crossingConstraint(particle, a, b, s);
+    }
+    Vec2 normal(0, -1);
+    float C = signedDistance(particle.getExpectedPos(), normal) - particle.getRadius();
+    if (C < 0){
+        Vec2 delta = normal * (-C);
+        StaticConstraint constraint (delta,&particle);
+        return std::optional<StaticConstraint>(constraint);
+    }
+    return std::nullopt;
+}
+
+bool SegmentCollider::isBakeable() const{
+    return true;
+}
+
+float SegmentCollider::signedDistance(const Vec2& p, Vec2& gradient) const{
+    float t;
+    Vec2 fromSegment = p - closestPointOnSegment(p, a, b, t);
+    float dist = fromSegment.norm();
+    if (dist > 0){
+        gradient = fromSegment / dist;
+    } else {
+        //Sur le segment : on prend sa normale, ou une direction arbitraire s'il est dégénéré
+        Vec2 ab = b - a;
+        gradient = ab.norm() > 0 ? Vec2(ab.gety(), -ab.getx()).normalize() : Vec2(0, -1);
+    }
+    return dist;
+}
+
+std::optional<AABB> SegmentCollider::getBounds() const{
+    return AABB{Vec2(std::min(a.getx(), b.getx()), std::min(a.gety(), b.gety())),
+                Vec2(std::max(a.getx(), b.getx()), std::max(a.gety(), b.gety()))};
+}
+
+void SegmentCollider::translate(const Vec2& offset){
+    a += offset;
+    b += offset;
+}
+
+void SegmentCollider::rotate(const Vec2& pivot, float angle){
+    a = rotateAround(a, pivot, angle);
+    b = rotateAround(b, pivot, angle);
+}
@@ -0,0 +1,122 @@
+#ifndef SEGMENTCOLLIDER_H
+#define SEGMENTCOLLIDER_H
+
+#include "collider.h"
+
+/**
+ * @brief Computes the point of a segment closest to a point.
+ *
+ * @param p The point.
+ * @param a First end of the segment.
+ * @param b Second end of the segment.
+ * @param t Receives the parameter of the closest point, in `[0, 1]` (0 at `a`, 1 at `b`).
+ * @return The closest point of `[a, b]`.
+ */
+Vec2 closestPointOnSegment(const Vec2& p, const Vec2& a, const Vec2& b, float& t);
+
+/**
+ * @brief Tells whether two segments cross each other.
+ *
+ * @param p0 Start of the first segment (e.g., the position of a particle).
+ * @param p1 End of the first segment (e.g., the predicted position of the particle).
+ * @param a First end of the second segment.
+ * @param b Second end of the second segment.
+ * @param s Receives the parameter of the crossing along `[p0, p1]`, in `[0, 1]`.
+ * @return True if the segments cross.
+ */
+bool segmentsCross(const Vec2& p0, const Vec2& p1, const Vec2& a, const Vec2& b, float& s);
+
+/**
+ * @brief Builds the constraint bringing back a particle whose predicted motion crossed a thin edge.
+ *
+ * @param particle The particle, whose current position gives the side it comes from.
+ * @param a First end of the crossed edge.
+ * @param b Second end of the crossed edge.
+ * @param s Parameter of the crossing along the predicted motion, as given by `segmentsCross`.
+ * @return The constraint moving the predicted position back to the side of the particle.
+ */
+StaticConstraint crossingConstraint(Particle& particle, const Vec2& a, const Vec2& b, float s);
+
+/**
+ * @brief Represents a thin segment collider in the simulation.
+ *
+ * The segment has no inside: particles are pushed away from it on whichever
+ * side they stand, which makes it suited to walls, ramps and flippers.
+ * Since it has no thickness, a fast particle whose predicted motion crosses
+ * it is brought back to the side it comes from.
+ */
+class SegmentCollider : public Collider {
+private:
+    Vec2 a;  ///< First end of the segment.
+    Vec2 b;  ///< Second end of the segment.
+
+public:
+    /**
+     * @brief Constructs a new `SegmentCollider` object.
+     *
+     * @param a First end of the segment.
+     * @param b Second end of the segment.
+     */
+    SegmentCollider(Vec2 a, Vec2 b);
+
+    /**
+     * @brief Default destructor for the `SegmentCollider`.
+     */
+    ~SegmentCollider() override = default;
+
+    /**
+     * @brief Renders the segment using a `QPainter`.
+     *
+     * @param p The `QPainter` used for rendering.
+     */
+    void draw(QPainter& p) const override;
+
+    /**
+     * @brief Checks for contact between a particle and the segment.
+     *
+     * @param particle The particle to check for contact.
+     * @return A `std::optional<StaticConstraint>` containing the constraint
+     *         if a contact is detected, or `std::nullopt` otherwise.
+     */
+    std::optional<StaticConstraint> checkContact(Particle& particle) const override;
+
+    /**
+     * @brief Tells whether the collider can be baked into a signed-distance grid.
+     *
+     * @return Always true.
+     */
+    bool isBakeable() const override;
+
+    /**
+     * @brief Evaluates the distance from a point to the segment.
+     *
+     * @param p The point.
+     * @param gradient Receives the direction from the segment towards `p`.
+     * @return The (unsigned) distance to the segment.
+     */
+    float signedDistance(const Vec2& p, Vec2& gradient) const override;
+
+    /**
+     * @brief Gets the bounding box of the segment.
+     *
+     * @return The bounding box of the segment.
+     */
+    std::optional<AABB> getBounds() const override;
+
+    /**
+     * @brief Moves the segment.
+     *
+     * @param offset The displacement to apply.
+     */
+    void translate(const Vec2& offset) override;
+
+    /**
+     * @brief Rotates the segment.
+     *
+     * @param pivot Center of the rotation.
+     * @param angle Angle of the rotation, in radians.
+     */
+    void rotate(const Vec2& pivot, float angle) override;
+};
+
+#endif // SEGMENTCOLLIDER_H
@@ -0,0 +1,26 @@
+#ifndef SIMULATIONCONFIG_H
+#define SIMULATIONCONFIG_H
+
+#include "vec2.h"
+
+/**
+ * @brief Runtime parameters of a simulation.
+ *
+ * Replaces the former `g`, `max_speed` and `tau` macros so that each scene
+ * can be tuned without rebuilding. The feature switches select, through
+ * `Context::setConfig`, a stepping core compiled without the disabled
+ * features.
+ */
+struct SimulationConfig {
+    Vec2 gravity = Vec2(0, 9.8f);  ///< Gravitational acceleration applied to every particle (m/s²).
+    float maxSpeed = 60;           ///< Maximum allowed speed of the particles (units/s), see `clampSpeed`.
+    bool clampSpeed = true;        ///< Whether velocities are clamped to `maxSpeed`.
+    bool particleCollisions = true;///< Whether particles collide with each other (colliders are always active).
+    bool incrementalBroadphase = true; ///< Whether the broadphase grid only re-bins the particles that changed cell, instead of being rebuilt at every step.
+    int frameInterval = 16;        ///< Period of the interactive loop (ms).
+    float stepDuration = 0.16f;    ///< Simulated time advanced at every frame of the interactive loop (s).
+    int substeps = 1;              ///< Number of substeps each step is split into, each with its own prediction, projection and velocity update (values below 1 count as 1).
+    int solverIterations = 1;      ///< Number of projection passes per step or substep; the contacts are evaluated again before each pass after the first (values below 1 count as 1).
+};
+
+#endif // SIMULATIONCONFIG_H
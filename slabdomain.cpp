@@ -0,0 +1,175 @@
+#include "slabdomain.h"
+#include "particlerecord.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+//Message : nombre de migrants, nombre de fantômes, puis les particules
+Transport::Message encodeParticles(const std::vector<ParticleRecord>& migrants, const std::vector<ParticleRecord>& ghosts){
+    std::uint64_t counts[2] = {migrants.size(), ghosts.size()};
+    Transport::Message message(sizeof(counts) + (migrants.size() + ghosts.size()) * sizeof(ParticleRecord));
+    char* out = message.data();
+    std::memcpy(out, counts, sizeof(counts));
+    out += sizeof(counts);
+    std::memcpy(out, migrants.data(), migrants.size() * sizeof(ParticleRecord));
+    out += migrants.size() * sizeof(ParticleRecord);
+    std::memcpy(out, ghosts.data(), ghosts.size() * sizeof(ParticleRecord));
+    return message;
+}
+
+void decodeParticles(const Transport::Message& message, std::vector<Particle>& migrants, std::vector<Particle>& ghosts){
+    std::uint64_t counts[2];
+    std::memcpy(counts, message.data(), sizeof(counts));
+    const char* in = message.data() + sizeof(counts);
+    for (std::uint64_t i = 0; i < counts[0] + counts[1]; ++i){
+        ParticleRecord record;
+        std::memcpy(&record, in, sizeof(record));
+        in += sizeof(record);
+        (i < counts[0] ? migrants : ghosts).push_back(fromRecord(record));
+    }
+}
+
+template <typename T>
+Transport::Message encodeValue(T value){
+    Transport::Message message(sizeof(T));
+    std::memcpy(message.data(), &value, sizeof(T));
+    return message;
+}
+
+template <typename T>
+T decodeValue(const Transport::Message& message){
+    T value;
+    std::memcpy(&value, message.data(), sizeof(T));
+    return value;
+}
+
+}
+
+SlabDomain::SlabDomain(Context& context, Transport& transport, const std::vector<float>& boundaries,
+                       const SlabSettings& settings)
+    : context(context), transport(transport), settings(settings),
+      lower(-std::numeric_limits<float>::infinity()), upper(std::numeric_limits<float>::infinity())
+{
+    int rank = transport.getRank();
+    if (rank > 0){
+        lower = boundaries.at(rank - 1);
+    }
+    if (rank < transport.getSize() - 1){
+        upper = boundaries.at(rank);
+    }
+}
+
+void SlabDomain::step(float dt){
+    int rank = transport.getRank();
+    bool hasLeft = rank > 0;
+    bool hasRight = rank < transport.getSize() - 1;
+
+    //Les voisins traitent leur frontière commune dans le même ordre : gauche puis droite
+    if (settings.rebalanceInterval > 0 && steps > 0 && steps % settings.rebalanceInterval == 0){
+        if (hasLeft){
+            rebalanceWith(rank - 1);
+        }
+        if (hasRight){
+            rebalanceWith(rank + 1);
+        }
+    }
+
+    stats = SlabStats();
+    std::vector<Particle> ghosts;
+    if (hasLeft){
+        exchangeWith(rank - 1, ghosts);
+    }
+    if (hasRight){
+        exchangeWith(rank + 1, ghosts);
+    }
+    stats.ghostsReceived = ghosts.size();
+    context.setGhostParticles(std::move(ghosts));
+    context.updatePhysicalSystem(dt);
+    stats.ownedParticles = context.getAliveParticleCount();
+    steps++;
+}
+
+float SlabDomain::getLowerBound() const{
+    return lower;
+}
+
+float SlabDomain::getUpperBound() const{
+    return upper;
+}
+
+const SlabStats& SlabDomain::getStats() const{
+    return stats;
+}
+
+void SlabDomain::exchangeWith(int peer, std::vector<Particle>& ghosts){
+    bool left = peer < transport.getRank();
+    float boundary = left ? lower : upper;
+    std::vector<ParticleRecord> migrantsOut;
+    std::vector<ParticleRecord> ghostsOut;
+    const auto& particles = context.getParticles();
+    for (size_t i = 0; i < particles.size(); ++i){
+        const Particle& particle = particles[i];
+        if (!particle.isAlive()){
+            continue;
+        }
+        //Distance signée à la frontière, positive du côté du voisin
+        float beyond = left ? boundary - particle.getPos().getx() : particle.getPos().getx() - boundary;
+        if (beyond > 0 || (!left && beyond == 0)){
+            migrantsOut.push_back(toRecord(particle));
+            context.removeParticle(i, false);
+        } else if (beyond > -settings.haloWidth){
+            ghostsOut.push_back(toRecord(particle));
+        }
+    }
+
+    Transport::Message sent = encodeParticles(migrantsOut, ghostsOut);
+    Transport::Message received = transport.exchange(peer, sent);
+    std::vector<Particle> migrantsIn;
+    decodeParticles(received, migrantsIn, ghosts);
+
+    stats.migrantsSent += migrantsOut.size();
+    stats.migrantsReceived += migrantsIn.size();
+    stats.bytesExchanged += sent.size();
+    if (!migrantsIn.empty()){
+        context.addParticles(std::move(migrantsIn));
+    }
+}
+
+void SlabDomain::rebalanceWith(int peer){
+    bool left = peer < transport.getRank();
+    std::uint64_t mine = context.getAliveParticleCount();
+    std::uint64_t theirs = decodeValue<std::uint64_t>(transport.exchange(peer, encodeValue(mine)));
+
+    //Seul le côté le plus chargé propose une frontière, prise dans ses propres particules
+    float& boundary = left ? lower : upper;
+    float proposal = boundary;
+    std::uint64_t excess = mine > theirs ? (mine - theirs) / 4 : 0;
+    if (excess > 0){
+        std::vector<float> xs;
+        xs.reserve(mine);
+        for (const auto& particle: context.getParticles()){
+            if (particle.isAlive()){
+                xs.push_back(particle.getPos().getx());
+            }
+        }
+        std::sort(xs.begin(), xs.end());
+        if (left){
+            //Les `excess` particules les plus à gauche passent au voisin de gauche
+            proposal = (xs[excess - 1] + xs[excess]) / 2;
+            proposal = std::max(std::min(proposal, upper - settings.minSlabWidth), lower);
+        } else {
+            size_t k = xs.size() - excess;
+            proposal = (xs[k - 1] + xs[k]) / 2;
+            proposal = std::min(std::max(proposal, lower + settings.minSlabWidth), upper);
+        }
+    }
+    float other = decodeValue<float>(transport.exchange(peer, encodeValue(proposal)));
+    if (mine > theirs){
+        boundary = proposal;
+    } else if (theirs > mine){
+        boundary = other;
+    }
+}
@@ -0,0 +1,115 @@
+#ifndef SLABDOMAIN_H
+#define SLABDOMAIN_H
+
+#include <vector>
+#include "context.h"
+#include "transport.h"
+
+/**
+ * @brief Parameters of a `SlabDomain`.
+ */
+struct SlabSettings {
+    float haloWidth = 10;        ///< Particles closer than this to a boundary are sent as ghosts.
+    int rebalanceInterval = 20;  ///< Number of steps between two rebalancings (0 disables them).
+    float minSlabWidth = 20;     ///< A rebalancing never makes a slab thinner than this.
+};
+
+/**
+ * @brief Statistics of a `SlabDomain`, for its last step.
+ */
+struct SlabStats {
+    size_t ownedParticles = 0;    ///< Particles owned by the slab.
+    size_t ghostsReceived = 0;    ///< Ghosts received from the neighbours.
+    size_t migrantsSent = 0;      ///< Particles handed over to a neighbour.
+    size_t migrantsReceived = 0;  ///< Particles received from a neighbour.
+    size_t bytesExchanged = 0;    ///< Bytes sent to the neighbours.
+};
+
+/**
+ * @brief One slab of a simulation split across processes along the x axis.
+ *
+ * Process `r` of the transport owns the particles whose x lies in
+ * `[getLowerBound(), getUpperBound())`, the first and last slabs extending
+ * to infinity. Before every step, each slab sends its neighbours the
+ * particles that left the slab (they migrate and become owned by the
+ * neighbour) and copies of the particles within `haloWidth` of the shared
+ * boundary (ghosts, see `Context::setGhostParticles`), so that particles
+ * collide across the boundary.
+ *
+ * Every `rebalanceInterval` steps the neighbours compare their particle
+ * counts, and the boundary moves into the busier slab by a quarter of the
+ * difference: the particles it leaves behind migrate at the next step.
+ *
+ * Colliders, emitters and force fields are not distributed: every process
+ * must build the same ones.
+ */
+class SlabDomain {
+public:
+    /**
+     * @brief Constructs the slab of the calling process.
+     *
+     * @param context The simulation of this slab. Particles outside the slab
+     *        migrate at the first step.
+     * @param transport The transport connecting the slabs.
+     * @param boundaries The `getSize() - 1` initial x coordinates separating the slabs, increasing.
+     * @param settings Parameters of the decomposition.
+     */
+    SlabDomain(Context& context, Transport& transport, const std::vector<float>& boundaries,
+               const SlabSettings& settings = SlabSettings());
+
+    /**
+     * @brief Exchanges migrants and ghosts with the neighbours, then steps the simulation.
+     *
+     * Every slab must call `step` the same number of times.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void step(float dt);
+
+    /**
+     * @brief Gets the lower x bound of the slab.
+     *
+     * @return The bound, `-infinity` for the first slab.
+     */
+    float getLowerBound() const;
+
+    /**
+     * @brief Gets the upper x bound of the slab.
+     *
+     * @return The bound, `+infinity` for the last slab.
+     */
+    float getUpperBound() const;
+
+    /**
+     * @brief Gets the statistics of the last step.
+     *
+     * @return The statistics.
+     */
+    const SlabStats& getStats() const;
+
+private:
+    Context& context;       ///< Simulation of this slab.
+    Transport& transport;   ///< Transport connecting the slabs.
+    SlabSettings settings;  ///< Parameters of the decomposition.
+    float lower;            ///< Lower x bound of the slab.
+    float upper;            ///< Upper x bound of the slab.
+    int steps = 0;          ///< Number of steps done.
+    SlabStats stats;        ///< Statistics of the last step.
+
+    /**
+     * @brief Sends migrants and ghosts to a neighbour and applies what it sent back.
+     *
+     * @param peer Rank of the neighbour.
+     * @param ghosts Receives the ghosts sent by the neighbour.
+     */
+    void exchangeWith(int peer, std::vector<Particle>& ghosts);
+
+    /**
+     * @brief Moves the boundary shared with a neighbour towards the busier slab.
+     *
+     * @param peer Rank of the neighbour.
+     */
+    void rebalanceWith(int peer);
+};
+
+#endif // SLABDOMAIN_H
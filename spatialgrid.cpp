@@ -0,0 +1,160 @@
+#include "spatialgrid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/// Largest cell size allowed by the margin, in particle diameters.
+constexpr float maxCellDiameters = 4;
+
+//Taille de cellule : le plus grand diamètre des particules vivantes, agrandi d'un nombre entier de diamètres pour la marge.
+//covered est faux quand le plafond tronque la marge
+float cellSizeFor(const std::vector<Particle>& particles, float margin, bool& covered){
+    float maxRadius = 0;
+    for (const auto& particle: particles){
+        if (particle.isAlive()){
+            maxRadius = std::max(maxRadius, particle.getRadius());
+        }
+    }
+    float diameter = maxRadius > 0 ? 2 * maxRadius : 1;
+    float diameters = std::ceil((diameter + margin) / diameter);
+    covered = diameters <= maxCellDiameters;
+    return diameter * std::min(maxCellDiameters, diameters);
+}
+
+}
+
+SpatialGrid::SpatialGrid(std::pmr::memory_resource* memory)
+    : cells(memory), binned(memory), entries(memory), movedChunks(memory), added(memory), merged(memory)
+{
+}
+
+bool SpatialGrid::entryLess(const Entry& a, const Entry& b){
+    return a.key != b.key ? a.key < b.key : a.index < b.index;
+}
+
+void SpatialGrid::build(const std::vector<Particle>& particles, ThreadPool& pool){
+    cellSize = cellSizeFor(particles, margin, marginCovered);
+
+    cells.resize(particles.size());
+    binned.resize(particles.size());
+    entries.resize(particles.size());
+    pool.parallelFor(0, particles.size(), pool.grainFor(particles.size(), 256), [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i){
+            cells[i] = cellOf(particles[i].getExpectedPos());
+            binned[i] = particles[i].isAlive();
+            entries[i] = Entry{cellKey(cells[i]), i};
+        }
+    });
+    //Les particules supprimées restent dans le tableau jusqu'au compactage : on les ignore
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&](const Entry& entry) { return !binned[entry.index]; }),
+                  entries.end());
+    std::sort(entries.begin(), entries.end(), entryLess);
+    rebinned = entries.size();
+    built = true;
+}
+
+void SpatialGrid::update(const std::vector<Particle>& particles, ThreadPool& pool){
+    float size = cellSizeFor(particles, margin, marginCovered);
+    if (!built || size != cellSize){
+        build(particles, pool);
+        return;
+    }
+
+    //Nouvelle cellule de chaque particule : on ne retient que celles qui changent d'entrée
+    const size_t count = particles.size();
+    const bool shrunk = count < cells.size();
+    cells.resize(count);
+    binned.resize(count, 0);
+    size_t grain = pool.grainFor(count, 256);
+    size_t chunks = ThreadPool::chunkCount(count, grain);
+    if (movedChunks.size() < chunks){
+        movedChunks.resize(chunks);
+    }
+    for (auto& chunk: movedChunks){
+        chunk.clear();
+    }
+    pool.parallelFor(0, count, grain, [&](size_t first, size_t last) {
+        auto& moved = movedChunks[first / grain];
+        for (size_t i = first; i < last; ++i){
+            bool alive = particles[i].isAlive();
+            Cell cell = alive ? cellOf(particles[i].getExpectedPos()) : cells[i];
+            if (alive != static_cast<bool>(binned[i]) || cell.x != cells[i].x || cell.y != cells[i].y){
+                moved.push_back(i);
+                cells[i] = cell;
+                binned[i] = alive;
+            }
+        }
+    });
+    rebinned = 0;
+    for (const auto& chunk: movedChunks){
+        rebinned += chunk.size();
+    }
+    if (rebinned == 0 && !shrunk){
+        return;
+    }
+    //Quand la moitié des particules a bougé, trier tout le tableau coûte moins cher que fusionner
+    if (rebinned * 2 > count){
+        entries.clear();
+        for (size_t i = 0; i < count; ++i){
+            if (binned[i]){
+                entries.push_back(Entry{cellKey(cells[i]), i});
+            }
+        }
+        std::sort(entries.begin(), entries.end(), entryLess);
+        return;
+    }
+
+    //Les entrées périmées gardent la clé de leur ancienne cellule
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return entry.index >= count || !binned[entry.index] || entry.key != cellKey(cells[entry.index]);
+    }), entries.end());
+    added.clear();
+    for (const auto& chunk: movedChunks){
+        for (size_t i: chunk){
+            if (binned[i]){
+                added.push_back(Entry{cellKey(cells[i]), i});
+            }
+        }
+    }
+    std::sort(added.begin(), added.end(), entryLess);
+    merged.resize(entries.size() + added.size());
+    std::merge(entries.begin(), entries.end(), added.begin(), added.end(), merged.begin(), entryLess);
+    entries.swap(merged);
+}
+
+void SpatialGrid::setMargin(float distance){
+    margin = std::max(0.0f, distance);
+}
+
+bool SpatialGrid::coversMargin() const{
+    return marginCovered;
+}
+
+void SpatialGrid::clear(){
+    built = false;
+}
+
+size_t SpatialGrid::getRebinnedCount() const{
+    return rebinned;
+}
+
+float SpatialGrid::getCellSize() const{
+    return cellSize;
+}
+
+const SpatialGrid::Cell& SpatialGrid::getCell(size_t index) const{
+    return cells[index];
+}
+
+std::int64_t SpatialGrid::cellKey(const Cell& cell){
+    //Multiplication plutôt que décalage : décaler un entier négatif n'est pas défini
+    return static_cast<std::int64_t>(cell.x) * 4294967296LL + static_cast<std::uint32_t>(cell.y);
+}
+
+std::pmr::vector<SpatialGrid::Entry>::const_iterator SpatialGrid::findCell(std::int64_t key) const{
+    return std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& entry, std::int64_t k) {
+        return entry.key < k;
+    });
+}
@@ -0,0 +1,242 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+#include "particle.h"
+#include "threadpool.h"
+
+/**
+ * @brief Uniform grid used as the broadphase of particle-particle collisions.
+ *
+ * Particles are binned by the cell containing their expected position. The
+ * cell size is the largest particle diameter, so two overlapping particles are
+ * always in the same or in adjacent cells and each particle only has to be
+ * tested against the 3x3 block of cells around it. A margin (see
+ * `setMargin`) enlarges the cells, so that the candidates also cover the
+ * pairs that come into contact while the particles keep moving.
+ *
+ * The cells are stored as contiguous runs of a single array sorted by cell
+ * key. `build` sorts the whole array; `update` only moves the particles
+ * whose cell changed since the previous call and merges them back, which
+ * is much cheaper when most of the scene is at rest. Both give the same
+ * order, so the candidate pairs do not depend on the path taken.
+ */
+class SpatialGrid {
+public:
+    /// Integer coordinates of a cell.
+    struct Cell {
+        int x;  ///< Column of the cell.
+        int y;  ///< Row of the cell.
+    };
+
+    /**
+     * @brief Constructs an empty grid.
+     *
+     * @param memory Resource providing the storage of the grid, kept from one build to the next.
+     */
+    explicit SpatialGrid(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    /**
+     * @brief Rebuilds the grid from the expected positions of the particles.
+     *
+     * Removed particles (see `Particle::isAlive`) are left out of the cells.
+     *
+     * @param particles The particles to bin.
+     * @param pool The thread pool used to compute the cells.
+     */
+    void build(const std::vector<Particle>& particles, ThreadPool& pool);
+
+    /**
+     * @brief Updates the grid from the expected positions of the particles.
+     *
+     * Only the particles whose cell changed, which were added or removed
+     * since the previous `build` or `update` are re-binned. Particles must
+     * keep their index in between: the array may grow or shrink at its end,
+     * but a reordering requires `clear`. Falls back to `build` after `clear`
+     * or when the cell size changes.
+     *
+     * @param particles The particles to bin.
+     * @param pool The thread pool used to compute the cells.
+     */
+    void update(const std::vector<Particle>& particles, ThreadPool& pool);
+
+    /**
+     * @brief Sets the distance by which the candidates must anticipate the contacts.
+     *
+     * Two particles whose centers are closer than the largest diameter plus
+     * `distance` are always candidates. The cell size grows by whole
+     * diameters, up to four diameters: beyond, the margin is truncated and
+     * `coversMargin` tells it. Applies from the next `build` or `update`.
+     *
+     * @param distance The margin, 0 by default.
+     */
+    void setMargin(float distance);
+
+    /**
+     * @brief Tells whether the cells of the last `build` or `update` are large enough for the margin.
+     *
+     * @return False if the margin was truncated to four diameters, in which
+     *         case the candidates cannot be trusted for the whole distance.
+     */
+    bool coversMargin() const;
+
+    /**
+     * @brief Forgets the particles, so that the next `update` rebuilds the grid.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of particles binned again by the last `build` or `update`.
+     *
+     * @return Every binned particle after a `build`, the particles that
+     *         changed cell, appeared or disappeared after an `update`.
+     */
+    size_t getRebinnedCount() const;
+
+    /**
+     * @brief Gets the side length of a cell.
+     *
+     * @return The cell size used by the last `build`.
+     */
+    float getCellSize() const;
+
+    /**
+     * @brief Gets the cell of a particle.
+     *
+     * @param index Index of the particle in the array given to `build`.
+     * @return The cell containing the particle's expected position.
+     */
+    const Cell& getCell(size_t index) const;
+
+    /**
+     * @brief Calls `visit(j)` for every particle `j > index` in the cells around particle `index`.
+     *
+     * Visiting only higher indices yields each unordered pair exactly once.
+     *
+     * @param index Index of the particle in the array given to `build`.
+     * @param visit Function called with the index of each candidate.
+     */
+    template <typename Visitor>
+    void forEachCandidate(size_t index, Visitor&& visit) const {
+        const Cell& cell = cells[index];
+        for (int dx = -1; dx <= 1; ++dx){
+            for (int dy = -1; dy <= 1; ++dy){
+                std::int64_t key = cellKey(Cell{cell.x + dx, cell.y + dy});
+                for (auto it = findCell(key); it != entries.end() && it->key == key; ++it){
+                    if (it->index > index){
+                        visit(it->index);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Calls `visit(j)` for every particle binned in a cell overlapping a box.
+     *
+     * The cells of a column with the same sign of row are contiguous in the
+     * sorted entries, so each column costs one or two binary searches. The
+     * box is tested against the expected positions of the last `build`.
+     *
+     * @param min Lower corner of the box.
+     * @param max Upper corner of the box.
+     * @param visit Function called with the index of each particle.
+     * @return False, without visiting anything, if the box spans more columns
+     *         than there are particles (a linear scan is then cheaper) or is
+     *         unbounded.
+     */
+    template <typename Visitor>
+    bool forEachInBox(const Vec2& min, const Vec2& max, Visitor&& visit) const {
+        double firstColumn = std::floor(min.getx() / cellSize);
+        double lastColumn = std::floor(max.getx() / cellSize);
+        double firstRowValue = std::floor(min.gety() / cellSize);
+        double lastRowValue = std::floor(max.gety() / cellSize);
+        //Écrit pour être faux aussi sur les bornes infinies ou NaN
+        constexpr double limit = 1e9;
+        bool inRange = std::abs(firstColumn) < limit && std::abs(lastColumn) < limit
+                    && std::abs(firstRowValue) < limit && std::abs(lastRowValue) < limit;
+        if (!inRange || lastColumn - firstColumn >= static_cast<double>(entries.size())){
+            return false;
+        }
+        int firstRow = static_cast<int>(firstRowValue);
+        int lastRow = static_cast<int>(lastRowValue);
+        //Dans une colonne, les lignes négatives sont rangées après les positives
+        auto visitRows = [&](int x, int from, int to) {
+            std::int64_t last = cellKey(Cell{x, to});
+            for (auto it = findCell(cellKey(Cell{x, from})); it != entries.end() && it->key <= last; ++it){
+                visit(it->index);
+            }
+        };
+        for (int x = static_cast<int>(firstColumn); x <= static_cast<int>(lastColumn); ++x){
+            if (firstRow < 0 && lastRow >= 0){
+                visitRows(x, 0, lastRow);
+                visitRows(x, firstRow, -1);
+            } else {
+                visitRows(x, firstRow, lastRow);
+            }
+        }
+        return true;
+    }
+
+private:
+    /// A particle index tagged with the key of its cell.
+    struct Entry {
+        std::int64_t key;  ///< Key of the cell, see `cellKey`.
+        size_t index;      ///< Index of the particle.
+    };
+
+    float cellSize = 1;           ///< Side length of a cell.
+    float margin = 0;             ///< Distance anticipated by the candidates, see `setMargin`.
+    bool marginCovered = true;    ///< Whether the cells cover the whole margin, see `coversMargin`.
+    std::pmr::vector<Cell> cells;      ///< Cell of each particle, by particle index.
+    std::pmr::vector<std::uint8_t> binned;  ///< Whether each particle has an entry, by particle index.
+    std::pmr::vector<Entry> entries;   ///< Particles sorted by cell key, then by index.
+    bool built = false;           ///< Whether `cells`, `binned` and `entries` describe the particles of the last call.
+    size_t rebinned = 0;          ///< Particles binned again by the last call.
+
+    std::pmr::vector<std::pmr::vector<size_t>> movedChunks;  ///< Per-chunk indices of the particles whose entry changed.
+    std::pmr::vector<Entry> added;                           ///< New entries, sorted before the merge.
+    std::pmr::vector<Entry> merged;                          ///< Result of the merge, swapped with `entries`.
+
+    /**
+     * @brief Gets the cell containing a point.
+     *
+     * @param pos The point.
+     * @return The cell, for the current cell size.
+     */
+    Cell cellOf(const Vec2& pos) const {
+        return Cell{static_cast<int>(std::floor(pos.getx() / cellSize)),
+                    static_cast<int>(std::floor(pos.gety() / cellSize))};
+    }
+
+    /**
+     * @brief Packs the coordinates of a cell into a single sortable key.
+     *
+     * @param cell The cell.
+     * @return The key of the cell.
+     */
+    static std::int64_t cellKey(const Cell& cell);
+
+    /**
+     * @brief Orders the entries by cell key, then by particle index.
+     *
+     * @param a The first entry.
+     * @param b The second entry.
+     * @return True if `a` comes before `b`.
+     */
+    static bool entryLess(const Entry& a, const Entry& b);
+
+    /**
+     * @brief Finds the first entry of a cell.
+     *
+     * @param key The key of the cell.
+     * @return An iterator on the first entry whose key is not less than `key`.
+     */
+    std::pmr::vector<Entry>::const_iterator findCell(std::int64_t key) const;
+};
+
+#endif // SPATIALGRID_H
@@ -1,4 +1,5 @@
 #include "spherecollider.h"
+#include "rayhit.h"
 
 SphereCollider::SphereCollider(Vec2 center, float radius):center(center),radius(radius){}
 
@@ -22,3 +23,36 @@ std::optional<StaticConstraint> SphereCollider::checkContact(Particle& particle)
     }
     return std::nullopt;
 }
+
+bool SphereCollider::isBakeable() const{
+    return true;
+}
+
+float SphereCollider::signedDistance(const Vec2& p, Vec2& gradient) const{
+    Vec2 fromCenter = p - center;
+    float dist = fromCenter.norm();
+    //Au centre exact, la normale est arbitraire
+    gradient = dist > 0 ? fromCenter / dist : Vec2(0, -1);
+    return dist - radius;
+}
+
+std::optional<float> SphereCollider::rayCast(const Vec2& origin, const Vec2& direction, float maxDistance, Vec2& normal) const{
+    std::optional<float> t = rayDiscIntersection(origin, direction, center, radius);
+    if (!t || *t > maxDistance){
+        return std::nullopt;
+    }
+    signedDistance(origin + direction * *t, normal);
+    return t;
+}
+
+std::optional<AABB> SphereCollider::getBounds() const{
+    return AABB::around(center, radius);
+}
+
+void SphereCollider::translate(const Vec2& offset){
+    center += offset;
+}
+
+void SphereCollider::rotate(const Vec2& pivot, float angle){
+    center = rotateAround(center, pivot, angle);
+}
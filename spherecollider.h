@@ -49,6 +49,55 @@ public:
      *         if a contact is detected, or `std::nullopt` otherwise.
      */
     std::optional<StaticConstraint> checkContact(Particle& particle) const override;
+
+    /**
+     * @brief Tells whether the collider can be baked into a signed-distance grid.
+     *
+     * @return Always true.
+     */
+    bool isBakeable() const override;
+
+    /**
+     * @brief Evaluates the signed distance from a point to the sphere.
+     *
+     * @param p The point.
+     * @param gradient Receives the outward normal at `p`.
+     * @return The signed distance, negative inside the sphere.
+     */
+    float signedDistance(const Vec2& p, Vec2& gradient) const override;
+
+    /**
+     * @brief Intersects a ray with the sphere analytically.
+     *
+     * @param origin Origin of the ray.
+     * @param direction Unit direction of the ray.
+     * @param maxDistance Length of the ray.
+     * @param normal Receives the outward normal at the hit point.
+     * @return The distance to the surface, 0 from inside, or `std::nullopt`.
+     */
+    std::optional<float> rayCast(const Vec2& origin, const Vec2& direction, float maxDistance, Vec2& normal) const override;
+
+    /**
+     * @brief Gets the bounding box of the sphere.
+     *
+     * @return The bounding box of the sphere.
+     */
+    std::optional<AABB> getBounds() const override;
+
+    /**
+     * @brief Moves the sphere.
+     *
+     * @param offset The displacement to apply.
+     */
+    void translate(const Vec2& offset) override;
+
+    /**
+     * @brief Rotates the sphere.
+     *
+     * @param pivot Center of the rotation.
+     * @param angle Angle of the rotation, in radians.
+     */
+    void rotate(const Vec2& pivot, float angle) override;
 };
 
 #endif // SPHERECOLLIDER_H
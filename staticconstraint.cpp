@@ -1,13 +1,25 @@
 #include "staticconstraint.h"
 
-StaticConstraint::StaticConstraint(Vec2 delta, Particle* particle): delta(delta), particle(particle) {}
+StaticConstraint::StaticConstraint(Vec2 delta, Particle* particle): delta(delta), particle(particle), normalSpeed(0), material(0), colliderVelocity(0, 0), collider(nullptr) {
+    //La vitesse prédite est mémorisée pour la restitution, avant que la projection ne l'annule
+    float length = delta.norm();
+    if (length > 0){
+        normalSpeed = particle->getVelocity().dot(delta) / length;
+    }
+}
 
-StaticConstraint::StaticConstraint(const StaticConstraint& other): delta(other.delta), particle(other.particle){}
+StaticConstraint::StaticConstraint(const StaticConstraint& other)
+    : delta(other.delta), particle(other.particle), normalSpeed(other.normalSpeed), material(other.material),
+      colliderVelocity(other.colliderVelocity), collider(other.collider){}
 
 StaticConstraint& StaticConstraint::operator=(const StaticConstraint& other){
     if (this != &other) {
         delta = other.delta;
         particle = other.particle;
+        normalSpeed = other.normalSpeed;
+        material = other.material;
+        colliderVelocity = other.colliderVelocity;
+        collider = other.collider;
     }
     return *this;
 }
@@ -21,3 +33,39 @@ const Vec2& StaticConstraint::getDelta() const{
 Particle* StaticConstraint::getParticle(){
     return particle;
 }
+
+void StaticConstraint::changeParticle(Particle* newParticle){
+    particle = newParticle;
+}
+
+float StaticConstraint::getNormalSpeed() const{
+    return normalSpeed;
+}
+
+MaterialId StaticConstraint::getMaterial() const{
+    return material;
+}
+
+void StaticConstraint::changeMaterial(MaterialId newMaterial){
+    material = newMaterial;
+}
+
+const Vec2& StaticConstraint::getColliderVelocity() const{
+    return colliderVelocity;
+}
+
+void StaticConstraint::changeColliderVelocity(const Vec2& velocity){
+    float length = delta.norm();
+    if (length > 0){
+        normalSpeed -= (velocity - colliderVelocity).dot(delta) / length;
+    }
+    colliderVelocity = velocity;
+}
+
+const Collider* StaticConstraint::getCollider() const{
+    return collider;
+}
+
+void StaticConstraint::changeCollider(const Collider* newCollider){
+    collider = newCollider;
+}
@@ -2,24 +2,37 @@
 #define STATICCONSTRAINT_H
 
 #include "vec2.h"
+#include "material.h"
 #include "particle.h"
 
+class Collider;
+
 /**
  * @brief Represents a static constraint between a particle and a static object.
  *
  * The `StaticConstraint` structure stores information about a detected constraint,
  * such as the displacement required to resolve the contact (`delta`) and the particle
- * affected by the constraint.
+ * affected by the constraint, plus what the contact response needs: the
+ * normal speed of the particle when the contact was detected, and the
+ * material and velocity of the object.
  */
 struct StaticConstraint {
 private:
     Vec2 delta;          ///< Displacement vector required to resolve the constraint.
     Particle* particle;  ///< Pointer to the particle affected by the constraint.
+    float normalSpeed;   ///< Speed of the particle along `delta` relative to the object, before the projection (negative when approaching).
+    MaterialId material; ///< Material of the object.
+    Vec2 colliderVelocity; ///< Velocity of the object at the contact.
+    const Collider* collider; ///< Collider that produced the constraint, null for the baked grid.
 
 public:
     /**
      * @brief Constructs a new `StaticConstraint`.
      *
+     * The normal speed is taken from the current (predicted) velocity of the
+     * particle, the object is motionless and its material is the default one.
+     * No collider is recorded.
+     *
      * @param delta The displacement vector required to resolve the constraint.
      * @param particle Pointer to the particle affected by the constraint.
      */
@@ -62,6 +75,66 @@ public:
      * @return A pointer to the particle affected by the constraint.
      */
     Particle* getParticle();
+
+    /**
+     * @brief Changes the particle associated with the constraint.
+     *
+     * Used to fix up the constraint when the particle storage is compacted.
+     *
+     * @param newParticle Pointer to the new location of the particle.
+     */
+    void changeParticle(Particle* newParticle);
+
+    /**
+     * @brief Retrieves the speed of the particle along the normal, relative to the object, before the projection.
+     *
+     * @return The normal speed, negative when the particle was approaching the object.
+     */
+    float getNormalSpeed() const;
+
+    /**
+     * @brief Retrieves the material of the object.
+     *
+     * @return The index of the material.
+     */
+    MaterialId getMaterial() const;
+
+    /**
+     * @brief Changes the material of the object.
+     *
+     * @param newMaterial The index of the material.
+     */
+    void changeMaterial(MaterialId newMaterial);
+
+    /**
+     * @brief Retrieves the velocity of the object at the contact.
+     *
+     * @return The velocity, zero for a motionless object.
+     */
+    const Vec2& getColliderVelocity() const;
+
+    /**
+     * @brief Changes the velocity of the object at the contact.
+     *
+     * The normal speed becomes relative to the new velocity.
+     *
+     * @param velocity The velocity of the object.
+     */
+    void changeColliderVelocity(const Vec2& velocity);
+
+    /**
+     * @brief Retrieves the collider that produced the constraint.
+     *
+     * @return The collider, or null if the constraint comes from the baked grid.
+     */
+    const Collider* getCollider() const;
+
+    /**
+     * @brief Records the collider that produced the constraint.
+     *
+     * @param newCollider The collider.
+     */
+    void changeCollider(const Collider* newCollider);
 };
 
 #endif // STATICCONSTRAINT_H
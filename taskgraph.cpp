@@ -0,0 +1,114 @@
+#include "taskgraph.h"
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+TaskGraph::TaskId TaskGraph::addTask(std::function<void()> task){
+    nodes.push_back(Node{std::move(task), {}, 0});
+    order.clear();
+    return nodes.size() - 1;
+}
+
+void TaskGraph::addDependency(TaskId before, TaskId after){
+    if (before >= nodes.size() || after >= nodes.size() || before == after){
+        throw std::runtime_error("Dépendance invalide entre les tâches " + std::to_string(before) + " et " + std::to_string(after));
+    }
+    nodes[before].successors.push_back(after);
+    nodes[after].predecessorCount++;
+    order.clear();
+}
+
+void TaskGraph::sortTopologically(){
+    if (order.size() == nodes.size()){
+        return;
+    }
+    //Algorithme de Kahn : une tâche est placée quand tous ses prédécesseurs le sont
+    std::vector<size_t> remaining(nodes.size());
+    order.clear();
+    for (TaskId id = 0; id < nodes.size(); ++id){
+        remaining[id] = nodes[id].predecessorCount;
+        if (remaining[id] == 0){
+            order.push_back(id);
+        }
+    }
+    for (size_t i = 0; i < order.size(); ++i){
+        for (TaskId next: nodes[order[i]].successors){
+            if (--remaining[next] == 0){
+                order.push_back(next);
+            }
+        }
+    }
+    if (order.size() != nodes.size()){
+        order.clear();
+        throw std::runtime_error("Les dépendances du graphe de tâches forment un cycle");
+    }
+}
+
+size_t TaskGraph::size() const{
+    return nodes.size();
+}
+
+struct TaskGraph::Execution {
+    TaskGraph& graph;
+    ThreadPool& pool;
+    std::atomic<size_t> unfinished;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    Execution(TaskGraph& graph, ThreadPool& pool): graph(graph), pool(pool), unfinished(graph.nodes.size()) {}
+
+    //La tâche soumise ne capture qu'un pointeur et un indice : pas d'allocation
+    void launch(TaskId id){
+        pool.submit([execution = this, id]() { execution->execute(id); });
+    }
+
+    void execute(TaskId id){
+        Node& node = graph.nodes[id];
+        try {
+            node.task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error){
+                error = std::current_exception();
+            }
+        }
+        for (TaskId next: node.successors){
+            if (graph.waiting[next].fetch_sub(1) == 1){
+                launch(next);
+            }
+        }
+        unfinished.fetch_sub(1);
+    }
+};
+
+void TaskGraph::run(ThreadPool& pool){
+    sortTopologically();
+    if (pool.getThreadCount() == 1){
+        for (TaskId id: order){
+            nodes[id].task();
+        }
+        return;
+    }
+
+    //Compteurs de prédécesseurs restants, alloués une fois puis réinitialisés à chaque exécution
+    if (waitingSize != nodes.size()){
+        waiting.reset(new std::atomic<size_t>[nodes.size()]);
+        waitingSize = nodes.size();
+    }
+    for (size_t i = 0; i < nodes.size(); ++i){
+        waiting[i] = nodes[i].predecessorCount;
+    }
+    Execution execution(*this, pool);
+    for (TaskId id = 0; id < nodes.size(); ++id){
+        if (nodes[id].predecessorCount == 0){
+            execution.launch(id);
+        }
+    }
+    pool.waitFor(execution.unfinished);
+    if (execution.error){
+        std::rethrow_exception(execution.error);
+    }
+}
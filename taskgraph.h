@@ -0,0 +1,91 @@
+#ifndef TASKGRAPH_H
+#define TASKGRAPH_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "threadpool.h"
+
+/**
+ * @brief A directed acyclic graph of tasks executed on a `ThreadPool`.
+ *
+ * Tasks are registered once with `addTask` and ordered with `addDependency`.
+ * Each call to `run` executes every task exactly once, starting a task as soon
+ * as all of its predecessors are done, so independent branches of the graph
+ * overlap on the pool. Running the graph does not allocate: the tasks it
+ * submits only capture a pointer and an index, and the predecessor counters
+ * are kept from one run to the next.
+ */
+class TaskGraph {
+public:
+    /// Identifier of a task inside the graph.
+    using TaskId = size_t;
+
+    /**
+     * @brief Default constructor for `TaskGraph`.
+     */
+    TaskGraph() = default;
+
+    /**
+     * @brief Adds a task to the graph.
+     *
+     * @param task The function executed when the task runs.
+     * @return The identifier of the new task.
+     */
+    TaskId addTask(std::function<void()> task);
+
+    /**
+     * @brief Orders two tasks.
+     *
+     * @param before The task that must complete first.
+     * @param after The task that can only start once `before` is done.
+     * @throw std::runtime_error if a task does not exist or both are the same.
+     */
+    void addDependency(TaskId before, TaskId after);
+
+    /**
+     * @brief Executes the whole graph and waits for its completion.
+     *
+     * With a single-threaded pool the tasks run inline, in a topological
+     * order computed once after the graph changes, so the result does not
+     * depend on the registration order. The first exception thrown by a task
+     * is rethrown once the graph has finished.
+     *
+     * @param pool The thread pool executing the tasks.
+     * @throw std::runtime_error if the dependencies form a cycle.
+     */
+    void run(ThreadPool& pool);
+
+    /**
+     * @brief Gets the number of tasks in the graph.
+     *
+     * @return The number of tasks.
+     */
+    size_t size() const;
+
+private:
+    /// A task and its outgoing edges.
+    struct Node {
+        std::function<void()> task;      ///< Work of the node.
+        std::vector<TaskId> successors;  ///< Tasks waiting for this one.
+        size_t predecessorCount = 0;     ///< Number of tasks this one waits for.
+    };
+
+    /// State of one call to `run`, shared by the tasks it submits.
+    struct Execution;
+
+    /**
+     * @brief Computes `order` if the graph changed since the last run.
+     *
+     * @throw std::runtime_error if the dependencies form a cycle.
+     */
+    void sortTopologically();
+
+    std::vector<Node> nodes;  ///< Tasks of the graph, in registration order.
+    std::unique_ptr<std::atomic<size_t>[]> waiting;  ///< Predecessors each task still waits for during `run`.
+    size_t waitingSize = 0;   ///< Number of counters in `waiting`.
+    std::vector<TaskId> order;  ///< Topological order of the tasks, empty when out of date.
+};
+
+#endif // TASKGRAPH_H
@@ -0,0 +1,187 @@
+#include "threadpool.h"
+#include <algorithm>
+#include <exception>
+
+namespace {
+/// Number of fruitless searches for a task before `waitFor` blocks.
+constexpr int spinsBeforeBlocking = 64;
+
+//Pool et file de la thread courante, pour pousser les sous-tâches sur sa propre file
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local unsigned currentIndex = 0;
+
+//État d'un parallelFor partagé par ses morceaux : une tâche ne capture qu'un pointeur et un indice
+struct ChunkBatch {
+    ThreadPool::ChunkBody body;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    std::atomic<size_t> remaining;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    ChunkBatch(ThreadPool::ChunkBody body, size_t begin, size_t end, size_t grain, size_t chunks)
+        : body(body), begin(begin), end(end), grain(grain), remaining(chunks) {}
+
+    void run(size_t chunk){
+        size_t first = begin + chunk * grain;
+        try {
+            body(first, std::min(end, first + grain));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error){
+                error = std::current_exception();
+            }
+        }
+        remaining.fetch_sub(1);
+    }
+};
+}
+
+ThreadPool::ThreadPool(unsigned threadCount): threadCount(std::max(1u, threadCount)){
+    for (unsigned i = 0; i < this->threadCount; ++i){
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned i = 1; i < this->threadCount; ++i){
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker: workers){
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::getThreadCount() const{
+    return threadCount;
+}
+
+unsigned ThreadPool::currentQueueIndex() const{
+    return currentPool == this ? currentIndex : 0;
+}
+
+void ThreadPool::submit(Task task){
+    unsigned index = currentQueueIndex();
+    if (index == 0){
+        index = nextQueue.fetch_add(1, std::memory_order_relaxed) % threadCount;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    pendingTasks.fetch_add(1);
+    //Le verrou garantit qu'un worker entre le test du prédicat et l'attente ne rate pas le réveil
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wakeUp.notify_one();
+    if (waiters.load() > 0){
+        progress.notify_all();
+    }
+}
+
+bool ThreadPool::runPendingTask(){
+    if (pendingTasks.load() == 0){
+        return false;
+    }
+    unsigned own = currentQueueIndex();
+    Task task;
+    for (unsigned k = 0; k < threadCount && !task; ++k){
+        WorkerQueue& queue = *queues[(own + k) % threadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()){
+            continue;
+        }
+        //LIFO sur sa propre file (localité), FIFO lors d'un vol (grosses tâches en premier)
+        if (k == 0){
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task){
+        return false;
+    }
+    pendingTasks.fetch_sub(1);
+    task();
+    //La tâche a pu décrémenter le compteur qu'attend une thread endormie
+    if (waiters.load() > 0){
+        { std::lock_guard<std::mutex> lock(sleepMutex); }
+        progress.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::waitFor(const std::atomic<size_t>& remaining){
+    int spins = 0;
+    while (remaining.load() > 0){
+        if (runPendingTask()){
+            spins = 0;
+            continue;
+        }
+        //Les dernières tâches tournent sur d'autres threads : on cède la main, puis on dort
+        if (++spins < spinsBeforeBlocking){
+            std::this_thread::yield();
+            continue;
+        }
+        waiters.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            progress.wait(lock, [&]() { return remaining.load() == 0 || pendingTasks.load() > 0; });
+        }
+        waiters.fetch_sub(1);
+        spins = 0;
+    }
+}
+
+void ThreadPool::workerLoop(unsigned index){
+    currentPool = this;
+    currentIndex = index;
+    while (!stopping){
+        if (runPendingTask()){
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || pendingTasks.load() > 0; });
+    }
+}
+
+size_t ThreadPool::chunkCount(size_t count, size_t grain){
+    grain = std::max<size_t>(1, grain);
+    return (count + grain - 1) / grain;
+}
+
+size_t ThreadPool::grainFor(size_t count, size_t minGrain) const{
+    //Environ 4 morceaux par thread pour laisser du travail à voler
+    size_t grain = (count + threadCount * 4 - 1) / (threadCount * 4);
+    return std::max<size_t>(std::max<size_t>(1, minGrain), grain);
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, ChunkBody body){
+    if (end <= begin){
+        return;
+    }
+    grain = std::max<size_t>(1, grain);
+    size_t chunks = chunkCount(end - begin, grain);
+    if (chunks == 1 || workers.empty()){
+        for (size_t first = begin; first < end; first += grain){
+            body(first, std::min(end, first + grain));
+        }
+        return;
+    }
+
+    ChunkBatch batch(body, begin, end, grain, chunks);
+    for (size_t c = 0; c < chunks; ++c){
+        submit([state = &batch, c]() { state->run(c); });
+    }
+    waitFor(batch.remaining);
+    if (batch.error){
+        std::rethrow_exception(batch.error);
+    }
+}
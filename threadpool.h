@@ -0,0 +1,189 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief A work-stealing thread pool.
+ *
+ * Every thread of the pool owns a task queue. A thread pops the most recently
+ * pushed task of its own queue and, when it runs out of work, steals the oldest
+ * task of another queue. The thread waiting for a batch of tasks (see `waitFor`)
+ * executes tasks too, so a pool of `n` threads only spawns `n - 1` workers and
+ * nested calls (e.g. a `parallelFor` inside a task) cannot deadlock.
+ *
+ * Once the queues have grown to their working size, scheduling does not
+ * allocate: each queue takes its memory from its own pool resource, and the
+ * tasks pushed by `parallelFor` fit in the small buffer of `Task`.
+ */
+class ThreadPool {
+public:
+    /// A unit of work executed by the pool.
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Non-owning reference to the body of a `parallelFor`.
+     *
+     * Unlike a `std::function`, wrapping a lambda with many captures never
+     * allocates. The referenced function must outlive the call.
+     */
+    class ChunkBody {
+    public:
+        /**
+         * @brief Refers to a function callable with the bounds of a chunk.
+         *
+         * @param body The function.
+         */
+        template <typename Body, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Body>, ChunkBody>>>
+        ChunkBody(Body&& body)
+            : object(const_cast<void*>(static_cast<const void*>(std::addressof(body)))),
+              call([](void* object, size_t first, size_t last) {
+                  (*static_cast<std::remove_reference_t<Body>*>(object))(first, last);
+              })
+        {
+        }
+
+        /**
+         * @brief Calls the function.
+         *
+         * @param first First index of the chunk.
+         * @param last Past-the-end index of the chunk.
+         */
+        void operator()(size_t first, size_t last) const {
+            call(object, first, last);
+        }
+
+    private:
+        void* object;                             ///< The referenced function.
+        void (*call)(void*, size_t, size_t);      ///< Calls `object` with the bounds of a chunk.
+    };
+
+    /**
+     * @brief Constructs a new thread pool.
+     *
+     * @param threadCount Total number of threads taking part in the work, including
+     *        the calling thread. A value of 0 or 1 executes everything inline.
+     */
+    explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+
+    /**
+     * @brief Stops and joins the workers.
+     *
+     * Pending tasks that were never waited for are discarded.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Gets the number of threads taking part in the work.
+     *
+     * @return The number of workers plus the calling thread.
+     */
+    unsigned getThreadCount() const;
+
+    /**
+     * @brief Submits a task to the pool.
+     *
+     * The task is pushed on the queue of the calling thread when it belongs to the
+     * pool, or distributed round-robin otherwise.
+     *
+     * @param task The task to execute.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Executes one pending task, if any.
+     *
+     * @return True if a task was executed, false if every queue was empty.
+     */
+    bool runPendingTask();
+
+    /**
+     * @brief Executes pending tasks until `remaining` drops to zero.
+     *
+     * When no task is left to run, the caller yields a few times, then
+     * sleeps until a task is submitted or a task run by another thread
+     * completes.
+     *
+     * @param remaining Counter decremented by the tasks being waited for.
+     */
+    void waitFor(const std::atomic<size_t>& remaining);
+
+    /**
+     * @brief Splits `[begin, end)` into chunks of `grain` indices and runs them in parallel.
+     *
+     * Chunk boundaries only depend on `begin`, `end` and `grain`, so `(first - begin) / grain`
+     * is a stable chunk index that can be used to fill per-chunk buffers deterministically.
+     * The first exception thrown by `body` is rethrown on the calling thread.
+     *
+     * @param begin First index of the range.
+     * @param end Past-the-end index of the range.
+     * @param grain Number of indices per chunk (at least 1).
+     * @param body Function called with the `[first, last)` bounds of each chunk.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, ChunkBody body);
+
+    /**
+     * @brief Computes the number of chunks `parallelFor` splits a range into.
+     *
+     * @param count Number of indices in the range.
+     * @param grain Number of indices per chunk.
+     * @return The number of chunks.
+     */
+    static size_t chunkCount(size_t count, size_t grain);
+
+    /**
+     * @brief Computes a grain giving each thread a few chunks of a range.
+     *
+     * @param count Number of indices in the range.
+     * @param minGrain Smallest grain worth scheduling as a separate task.
+     * @return The grain to pass to `parallelFor`.
+     */
+    size_t grainFor(size_t count, size_t minGrain) const;
+
+private:
+    /// Task queue owned by one thread of the pool.
+    struct WorkerQueue {
+        std::mutex mutex;                           ///< Protects `tasks` and `memory`.
+        std::pmr::unsynchronized_pool_resource memory;  ///< Keeps the blocks freed by `tasks` for its next pushes.
+        std::pmr::deque<Task> tasks{&memory};       ///< Tasks, the owner works at the back, thieves at the front.
+    };
+
+    unsigned threadCount;                              ///< Workers plus the calling thread.
+    std::vector<std::unique_ptr<WorkerQueue>> queues;  ///< One queue per thread, index 0 is shared by external threads.
+    std::vector<std::thread> workers;                  ///< Spawned worker threads.
+    std::mutex sleepMutex;                             ///< Protects the sleep of idle workers.
+    std::condition_variable wakeUp;                    ///< Wakes idle workers when tasks are submitted.
+    std::condition_variable progress;                  ///< Wakes the threads blocked in `waitFor`, on a submission or a completion.
+    std::atomic<unsigned> waiters{0};                  ///< Number of threads blocked or about to block in `waitFor`.
+    std::atomic<size_t> pendingTasks{0};               ///< Number of tasks waiting in the queues.
+    std::atomic<unsigned> nextQueue{0};                ///< Round-robin cursor for external submissions.
+    std::atomic<bool> stopping{false};                 ///< Set when the pool is destroyed.
+
+    /**
+     * @brief Main loop of a worker thread.
+     *
+     * @param index Index of the worker's own queue.
+     */
+    void workerLoop(unsigned index);
+
+    /**
+     * @brief Gets the queue index of the calling thread.
+     *
+     * @return The index of the caller's queue, or 0 for threads outside the pool.
+     */
+    unsigned currentQueueIndex() const;
+};
+
+#endif // THREADPOOL_H
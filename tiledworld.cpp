@@ -0,0 +1,303 @@
+#include "tiledworld.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+/// Maximum number of tiles covered by the focus.
+constexpr double maxFocusTiles = 1e6;
+
+//Même convention que la grille de la broadphase : colonne sur les 32 bits de poids fort
+std::uint64_t makeKey(std::int32_t column, std::int32_t row){
+    return (std::uint64_t(std::uint32_t(column)) << 32) | std::uint32_t(row);
+}
+
+std::int32_t columnOf(std::uint64_t key){
+    return static_cast<std::int32_t>(std::uint32_t(key >> 32));
+}
+
+std::int32_t rowOf(std::uint64_t key){
+    return static_cast<std::int32_t>(std::uint32_t(key));
+}
+
+std::int32_t tileCoordinate(float x, float tileSize){
+    double tile = std::floor(static_cast<double>(x) / tileSize);
+    return static_cast<std::int32_t>(std::clamp(tile, -2147483648.0, 2147483647.0));
+}
+
+const TileSettings& validated(const TileSettings& settings){
+    if (!(settings.tileSize > 0) || settings.interval < 1){
+        throw std::runtime_error("Taille des tuiles ou intervalle de pagination invalide");
+    }
+    //Une tuile voisine de l'activité doit toujours être chargée avant d'être atteinte
+    if (settings.prefetchRadius < 1 || settings.evictRadius <= settings.prefetchRadius){
+        throw std::runtime_error("Le rayon d'éviction doit dépasser le rayon de préchargement, lui-même au moins 1");
+    }
+    return settings;
+}
+
+}
+
+TiledWorld::TiledWorld(Context& context, const TileSettings& settings)
+    : context(context), settings(validated(settings)), pageFile(settings.pageFile)
+{
+    loader = std::thread(&TiledWorld::loadTiles, this);
+}
+
+TiledWorld::~TiledWorld(){
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        stopping = true;
+    }
+    requestCondition.notify_all();
+    loader.join();
+}
+
+void TiledWorld::addParticles(std::vector<Particle>&& batch){
+    insertFocusTiles(activeTiles);
+    std::unordered_set<TileKey> kept = aroundActivity(settings.evictRadius);
+    std::vector<Particle> resident;
+    std::unordered_map<TileKey, std::vector<ParticleRecord>> paged;
+    for (Particle& particle: batch){
+        TileKey key = tileOf(particle.getPos());
+        auto page = pages.find(key);
+        //Une tuile en cours de chargement sera bientôt résidente
+        bool loading = page != pages.end() && page->second.loading;
+        if (kept.count(key) > 0 || loading){
+            resident.push_back(std::move(particle));
+        } else {
+            paged[key].push_back(toRecord(particle));
+        }
+    }
+    batch.clear();
+    for (auto& [key, records]: paged){
+        pageOut(key, records);
+    }
+    if (!resident.empty()){
+        context.addParticles(std::move(resident));
+    }
+    stats.residentParticles = context.getAliveParticleCount();
+    stats.pageFileBytes = pageFile.getSize();
+}
+
+void TiledWorld::setFocus(const std::optional<AABB>& newFocus){
+    if (newFocus){
+        double columns = std::floor(newFocus->max.getx() / settings.tileSize) - std::floor(newFocus->min.getx() / settings.tileSize) + 1;
+        double rows = std::floor(newFocus->max.gety() / settings.tileSize) - std::floor(newFocus->min.gety() / settings.tileSize) + 1;
+        if (!(columns * rows <= maxFocusTiles)){
+            throw std::runtime_error("Zone de focalisation trop grande pour le pavage");
+        }
+    }
+    focus = newFocus;
+}
+
+void TiledWorld::step(float dt){
+    if (steps % settings.interval == 0){
+        updateTiles();
+    } else {
+        applyLoadedTiles();
+    }
+    context.updatePhysicalSystem(dt);
+    steps++;
+    stats.residentParticles = context.getAliveParticleCount();
+    stats.pageFileBytes = pageFile.getSize();
+}
+
+const TileStats& TiledWorld::getStats() const{
+    return stats;
+}
+
+TiledWorld::TileKey TiledWorld::tileOf(const Vec2& p) const{
+    return makeKey(tileCoordinate(p.getx(), settings.tileSize), tileCoordinate(p.gety(), settings.tileSize));
+}
+
+void TiledWorld::insertFocusTiles(std::unordered_set<TileKey>& tiles) const{
+    if (!focus){
+        return;
+    }
+    std::int32_t firstColumn = tileCoordinate(focus->min.getx(), settings.tileSize);
+    std::int32_t lastColumn = tileCoordinate(focus->max.getx(), settings.tileSize);
+    std::int32_t firstRow = tileCoordinate(focus->min.gety(), settings.tileSize);
+    std::int32_t lastRow = tileCoordinate(focus->max.gety(), settings.tileSize);
+    for (std::int64_t column = firstColumn; column <= lastColumn; ++column){
+        for (std::int64_t row = firstRow; row <= lastRow; ++row){
+            tiles.insert(makeKey(static_cast<std::int32_t>(column), static_cast<std::int32_t>(row)));
+        }
+    }
+}
+
+std::unordered_set<TiledWorld::TileKey> TiledWorld::aroundActivity(int radius) const{
+    std::unordered_set<TileKey> tiles;
+    for (TileKey key: activeTiles){
+        std::int64_t column = columnOf(key);
+        std::int64_t row = rowOf(key);
+        for (std::int64_t dx = -radius; dx <= radius; ++dx){
+            for (std::int64_t dy = -radius; dy <= radius; ++dy){
+                tiles.insert(makeKey(static_cast<std::int32_t>(column + dx), static_cast<std::int32_t>(row + dy)));
+            }
+        }
+    }
+    return tiles;
+}
+
+void TiledWorld::updateTiles(){
+    applyLoadedTiles();
+
+    //Occupation des tuiles : les particules voisines sont souvent dans la même tuile
+    const auto& particles = context.getParticles();
+    std::unordered_set<TileKey> residentTiles;
+    activeTiles.clear();
+    std::optional<TileKey> lastResident;
+    std::optional<TileKey> lastActive;
+    for (const auto& particle: particles){
+        if (!particle.isAlive()){
+            continue;
+        }
+        TileKey key = tileOf(particle.getPos());
+        if (key != lastResident){
+            residentTiles.insert(key);
+            lastResident = key;
+        }
+        if (!particle.isAsleep() && key != lastActive){
+            activeTiles.insert(key);
+            lastActive = key;
+        }
+    }
+    insertFocusTiles(activeTiles);
+
+    //Préchargement en arrière-plan des tuiles qui approchent de l'activité
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        for (TileKey key: aroundActivity(settings.prefetchRadius)){
+            auto page = pages.find(key);
+            if (page != pages.end() && !page->second.loading){
+                page->second.loading = true;
+                requests.emplace_back(key, page->second);
+            }
+        }
+    }
+    requestCondition.notify_one();
+
+    //Les tuiles voisines de l'activité doivent être là avant le pas
+    bool waited = false;
+    for (TileKey key: aroundActivity(1)){
+        if (pages.count(key) == 0){
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(loaderMutex);
+        if (loadedTiles.count(key) == 0){
+            stats.stalls++;
+            loadedCondition.wait(lock, [&] { return loadedTiles.count(key) > 0; });
+        }
+        waited = true;
+    }
+    if (waited){
+        applyLoadedTiles();
+    }
+
+    //Éviction des tuiles loin de l'activité, dont toutes les particules dorment
+    std::unordered_set<TileKey> kept = aroundActivity(settings.evictRadius);
+    std::unordered_set<TileKey> evicted;
+    for (TileKey key: residentTiles){
+        auto page = pages.find(key);
+        if (kept.count(key) == 0 && (page == pages.end() || !page->second.loading)){
+            evicted.insert(key);
+        }
+    }
+    stats.residentTiles = residentTiles.size() - evicted.size();
+    if (evicted.empty()){
+        return;
+    }
+    std::unordered_map<TileKey, std::vector<ParticleRecord>> records;
+    for (size_t i = 0; i < particles.size(); ++i){
+        const Particle& particle = particles[i];
+        if (!particle.isAlive()){
+            continue;
+        }
+        TileKey key = tileOf(particle.getPos());
+        if (evicted.count(key) > 0){
+            records[key].push_back(toRecord(particle));
+            context.removeParticle(i, false);
+        }
+    }
+    for (auto& [key, tileRecords]: records){
+        pageOut(key, tileRecords);
+    }
+}
+
+void TiledWorld::applyLoadedTiles(){
+    std::unordered_map<TileKey, std::vector<Particle>> tiles;
+    {
+        std::lock_guard<std::mutex> lock(loaderMutex);
+        tiles.swap(loadedTiles);
+    }
+    if (tiles.empty()){
+        return;
+    }
+    std::vector<Particle> batch;
+    for (auto& [key, particles]: tiles){
+        auto page = pages.find(key);
+        //Le monde a changé pendant que la tuile était sur disque : ses particules ne restent pas endormies
+        if (page->second.revision != context.getEnvironmentRevision()){
+            for (Particle& particle: particles){
+                particle.wakeUp();
+            }
+        }
+        stats.pagedParticles -= page->second.count;
+        pages.erase(page);
+        stats.pageIns++;
+        batch.insert(batch.end(), std::make_move_iterator(particles.begin()), std::make_move_iterator(particles.end()));
+    }
+    stats.pagedTiles = pages.size();
+    context.addParticles(std::move(batch));
+}
+
+void TiledWorld::pageOut(TileKey key, std::vector<ParticleRecord>& records){
+    auto page = pages.find(key);
+    Page written;
+    written.revision = context.getEnvironmentRevision();
+    if (page != pages.end()){
+        //La tuile a déjà une page : les deux lots sont réunis
+        size_t previous = records.size();
+        records.resize(previous + page->second.count);
+        pageFile.read(page->second.extent, records.data() + previous);
+        pageFile.release(page->second.extent);
+        stats.pagedParticles -= page->second.count;
+        written.revision = page->second.revision;
+    }
+    written.extent = pageFile.write(records.data(), records.size() * sizeof(ParticleRecord));
+    written.count = records.size();
+    pages[key] = written;
+    stats.pagedParticles += written.count;
+    stats.pagedTiles = pages.size();
+    stats.pageOuts++;
+}
+
+void TiledWorld::loadTiles(){
+    std::unique_lock<std::mutex> lock(loaderMutex);
+    while (true){
+        requestCondition.wait(lock, [&] { return stopping || !requests.empty(); });
+        if (stopping){
+            return;
+        }
+        auto [key, page] = requests.front();
+        requests.pop_front();
+        lock.unlock();
+
+        //Lecture et décodage hors du verrou : la simulation continue pendant ce temps
+        std::vector<ParticleRecord> records(page.count);
+        pageFile.read(page.extent, records.data());
+        pageFile.release(page.extent);
+        std::vector<Particle> particles;
+        particles.reserve(records.size());
+        for (const ParticleRecord& record: records){
+            particles.push_back(fromRecord(record));
+            particles.back().fallAsleep();
+        }
+
+        lock.lock();
+        loadedTiles.emplace(key, std::move(particles));
+        loadedCondition.notify_all();
+    }
+}
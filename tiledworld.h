@@ -0,0 +1,195 @@
+#ifndef TILEDWORLD_H
+#define TILEDWORLD_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "aabb.h"
+#include "context.h"
+#include "pagefile.h"
+#include "particlerecord.h"
+
+/**
+ * @brief Parameters of a `TiledWorld`.
+ */
+struct TileSettings {
+    float tileSize = 256;                  ///< Side of a square tile, in world units.
+    int prefetchRadius = 2;                ///< Paged-out tiles within this many tiles of the activity are loaded in the background.
+    int evictRadius = 3;                   ///< Tiles farther than this many tiles from the activity are paged out.
+    int interval = 10;                     ///< Number of steps between two paging decisions.
+    std::string pageFile = "tiles.page";   ///< Path of the scratch file holding the paged-out tiles.
+};
+
+/**
+ * @brief Statistics of a `TiledWorld`.
+ */
+struct TileStats {
+    size_t residentParticles = 0;  ///< Particles in the context.
+    size_t pagedParticles = 0;     ///< Particles in the page file.
+    size_t residentTiles = 0;      ///< Tiles holding particles in the context, at the last decision.
+    size_t pagedTiles = 0;         ///< Tiles in the page file.
+    size_t pageIns = 0;            ///< Tiles loaded back since the construction.
+    size_t pageOuts = 0;           ///< Tiles written out since the construction.
+    size_t stalls = 0;             ///< Loads the step had to wait for, because the prefetch came too late.
+    size_t pageFileBytes = 0;      ///< Size of the page file.
+};
+
+/**
+ * @brief A world divided into square tiles, whose inactive part is kept out of the `Context`.
+ *
+ * The activity is the set of tiles holding an awake particle, plus the tiles
+ * seen through the focus (typically the camera). Every `interval` steps,
+ * the tiles farther than `evictRadius` tiles from the activity, whose
+ * particles are therefore all asleep, are serialized to a memory-mapped
+ * page file and removed from the context. The paged-out tiles coming within
+ * `prefetchRadius` tiles of the activity are read back by a background
+ * thread and added to the context, asleep, before the activity reaches
+ * them; a tile adjacent to the activity that is not loaded yet is waited
+ * for. Tiles paged out before a change of the environment (see
+ * `Context::getEnvironmentRevision`) come back awake.
+ *
+ * The resident memory thus follows the size of the activity, not the size
+ * of the world: a world larger than the memory can be built through
+ * `addParticles`, which pages out directly the particles far from the
+ * activity.
+ *
+ * Paged-out particles are frozen: they do not age and are not seen by the
+ * emitters, force fields or kill volumes. Colliders are not paged.
+ */
+class TiledWorld {
+public:
+    /**
+     * @brief Constructs the tiled world of a context.
+     *
+     * @param context The simulation. Its particles far from the activity are
+     *        paged out at the first step.
+     * @param settings Parameters of the tiling.
+     * @throw std::runtime_error if the radii are inconsistent or the page
+     *        file cannot be created.
+     */
+    TiledWorld(Context& context, const TileSettings& settings = TileSettings());
+
+    /**
+     * @brief Stops the background loader. The page file is removed.
+     */
+    ~TiledWorld();
+
+    TiledWorld(const TiledWorld&) = delete;
+    TiledWorld& operator=(const TiledWorld&) = delete;
+
+    /**
+     * @brief Adds particles to the world.
+     *
+     * Particles close to the activity go to the context; the others are
+     * written to the page file, asleep, without ever being resident.
+     *
+     * @param batch The particles (moved from).
+     */
+    void addParticles(std::vector<Particle>&& batch);
+
+    /**
+     * @brief Sets the region that must stay resident whatever the activity.
+     *
+     * @param focus The region, typically the view of the camera, or `std::nullopt`.
+     * @throw std::runtime_error if the region covers more than a million tiles.
+     */
+    void setFocus(const std::optional<AABB>& focus);
+
+    /**
+     * @brief Pages tiles in and out if needed, then steps the simulation.
+     *
+     * @param dt The time step duration in seconds.
+     */
+    void step(float dt);
+
+    /**
+     * @brief Gets the statistics.
+     *
+     * @return The statistics, up to date after each `step`.
+     */
+    const TileStats& getStats() const;
+
+private:
+    /// Key of a tile, from its column and row.
+    using TileKey = std::uint64_t;
+
+    /// State of a paged-out tile.
+    struct Page {
+        PageExtent extent;     ///< Location of the particles in the page file.
+        size_t count = 0;      ///< Number of particles.
+        bool loading = false;  ///< True once handed to the loader.
+        uint64_t revision = 0; ///< Environment revision of the context when the oldest particles were paged out.
+    };
+
+    Context& context;                            ///< The simulation.
+    TileSettings settings;                       ///< Parameters of the tiling.
+    PageFile pageFile;                           ///< Storage of the paged-out tiles.
+    std::unordered_map<TileKey, Page> pages;     ///< Paged-out tiles.
+    std::optional<AABB> focus;                   ///< Region kept resident.
+    std::unordered_set<TileKey> activeTiles;     ///< Tiles holding an awake particle or seen through the focus, at the last decision.
+    int steps = 0;                               ///< Number of steps done.
+    TileStats stats;                             ///< Statistics.
+
+    std::thread loader;                          ///< Background thread reading the tiles back.
+    std::mutex loaderMutex;                      ///< Protects the requests, the loaded tiles and `stopping`.
+    std::condition_variable requestCondition;    ///< Signals new requests to the loader.
+    std::condition_variable loadedCondition;     ///< Signals loaded tiles to the simulation.
+    std::deque<std::pair<TileKey, Page>> requests;                   ///< Tiles to load, in order.
+    std::unordered_map<TileKey, std::vector<Particle>> loadedTiles;  ///< Tiles read back, waiting to be added.
+    bool stopping = false;                       ///< Asks the loader to exit.
+
+    /**
+     * @brief Gets the tile holding a point.
+     *
+     * @param p The point.
+     * @return The key of the tile.
+     */
+    TileKey tileOf(const Vec2& p) const;
+
+    /**
+     * @brief Adds the tiles overlapping the focus to a set.
+     *
+     * @param tiles The set.
+     */
+    void insertFocusTiles(std::unordered_set<TileKey>& tiles) const;
+
+    /**
+     * @brief Lists the tiles within a distance of the active tiles.
+     *
+     * @param radius The distance, in tiles (Chebyshev).
+     * @return The active tiles and their neighbours.
+     */
+    std::unordered_set<TileKey> aroundActivity(int radius) const;
+
+    /**
+     * @brief Finds the active tiles and pages tiles in and out accordingly.
+     */
+    void updateTiles();
+
+    /**
+     * @brief Adds the tiles read back by the loader to the context.
+     */
+    void applyLoadedTiles();
+
+    /**
+     * @brief Writes particles to the page of a tile, merged with the particles already there.
+     *
+     * @param key The tile.
+     * @param records The particles.
+     */
+    void pageOut(TileKey key, std::vector<ParticleRecord>& records);
+
+    /**
+     * @brief Main loop of the loader thread.
+     */
+    void loadTiles();
+};
+
+#endif // TILEDWORLD_H
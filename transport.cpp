@@ -0,0 +1,180 @@
+#include "transport.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+std::unique_ptr<SocketTransport> SocketTransport::spawn(int size){
+    if (size < 1){
+        throw std::runtime_error("Nombre de processus invalide");
+    }
+    //Une paire de sockets par paire de processus, créées avant de forker
+    std::vector<std::vector<int>> ends(size, std::vector<int>(size, -1));
+    for (int a = 0; a < size; ++a){
+        for (int b = a + 1; b < size; ++b){
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0){
+                throw std::runtime_error("Impossible de créer les sockets");
+            }
+            ends[a][b] = pair[0];
+            ends[b][a] = pair[1];
+        }
+    }
+
+    std::vector<int> children;
+    int rank = 0;
+    for (int r = 1; r < size; ++r){
+        pid_t pid = fork();
+        if (pid < 0){
+            throw std::runtime_error("Impossible de créer les processus");
+        }
+        if (pid == 0){
+            rank = r;
+            children.clear();
+            break;
+        }
+        children.push_back(static_cast<int>(pid));
+    }
+
+    //Chaque processus ne garde que ses propres extrémités
+    for (int a = 0; a < size; ++a){
+        for (int b = 0; b < size; ++b){
+            if (a != rank && ends[a][b] >= 0){
+                close(ends[a][b]);
+            }
+        }
+    }
+    for (int socket: ends[rank]){
+        if (socket >= 0){
+            fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    std::unique_ptr<SocketTransport> transport(new SocketTransport(rank, ends[rank]));
+    transport->children = std::move(children);
+    return transport;
+}
+
+SocketTransport::SocketTransport(int rank, std::vector<int> sockets) : rank(rank), sockets(std::move(sockets)) {}
+
+SocketTransport::~SocketTransport(){
+    for (int socket: sockets){
+        if (socket >= 0){
+            close(socket);
+        }
+    }
+    for (int child: children){
+        waitpid(static_cast<pid_t>(child), nullptr, 0);
+    }
+}
+
+int SocketTransport::getRank() const{
+    return rank;
+}
+
+int SocketTransport::getSize() const{
+    return static_cast<int>(sockets.size());
+}
+
+Transport::Message SocketTransport::exchange(int peer, const Message& message){
+    int socket = sockets.at(peer);
+    if (socket < 0){
+        return message;
+    }
+    //Envoi et réception simultanés : deux gros messages croisés ne se bloquent pas
+    std::uint64_t outgoingSize = message.size();
+    std::vector<char> outgoing(sizeof(outgoingSize) + message.size());
+    std::memcpy(outgoing.data(), &outgoingSize, sizeof(outgoingSize));
+    std::memcpy(outgoing.data() + sizeof(outgoingSize), message.data(), message.size());
+    size_t sent = 0;
+
+    char header[sizeof(std::uint64_t)];
+    size_t headerRead = 0;
+    Message incoming;
+    size_t received = 0;
+    bool incomingComplete = false;
+
+    while (sent < outgoing.size() || !incomingComplete){
+        pollfd descriptor{socket, 0, 0};
+        if (sent < outgoing.size()){
+            descriptor.events |= POLLOUT;
+        }
+        if (!incomingComplete){
+            descriptor.events |= POLLIN;
+        }
+        if (poll(&descriptor, 1, -1) < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            throw std::runtime_error("Erreur de communication entre processus");
+        }
+        if ((descriptor.revents & POLLOUT) != 0){
+#ifdef MSG_NOSIGNAL
+            //Un pair disparu doit lever une exception, pas tuer le processus par SIGPIPE
+            ssize_t n = send(socket, outgoing.data() + sent, outgoing.size() - sent, MSG_NOSIGNAL);
+#else
+            ssize_t n = write(socket, outgoing.data() + sent, outgoing.size() - sent);
+#endif
+            if (n < 0 && errno != EAGAIN && errno != EINTR){
+                throw std::runtime_error("Connexion perdue avec le processus " + std::to_string(peer));
+            }
+            sent += n > 0 ? static_cast<size_t>(n) : 0;
+        }
+        if ((descriptor.revents & (POLLIN | POLLHUP)) != 0 && !incomingComplete){
+            ssize_t n;
+            if (headerRead < sizeof(header)){
+                n = read(socket, header + headerRead, sizeof(header) - headerRead);
+            } else {
+                n = read(socket, incoming.data() + received, incoming.size() - received);
+            }
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)){
+                throw std::runtime_error("Connexion perdue avec le processus " + std::to_string(peer));
+            }
+            if (n > 0){
+                if (headerRead < sizeof(header)){
+                    headerRead += static_cast<size_t>(n);
+                    if (headerRead == sizeof(header)){
+                        std::uint64_t incomingSize;
+                        std::memcpy(&incomingSize, header, sizeof(incomingSize));
+                        incoming.resize(incomingSize);
+                    }
+                } else {
+                    received += static_cast<size_t>(n);
+                }
+            }
+            incomingComplete = headerRead == sizeof(header) && received == incoming.size();
+        }
+    }
+    return incoming;
+}
+
+#else
+
+std::unique_ptr<SocketTransport> SocketTransport::spawn(int){
+    throw std::runtime_error("Le transport par sockets Unix n'est pas disponible sur ce système");
+}
+
+SocketTransport::SocketTransport(int rank, std::vector<int> sockets) : rank(rank), sockets(std::move(sockets)) {}
+
+SocketTransport::~SocketTransport() = default;
+
+int SocketTransport::getRank() const{
+    return rank;
+}
+
+int SocketTransport::getSize() const{
+    return static_cast<int>(sockets.size());
+}
+
+Transport::Message SocketTransport::exchange(int, const Message& message){
+    return message;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Message channel between the processes of a distributed simulation.
+ *
+ * Processes are numbered from 0 to `getSize() - 1`. The only operation is a
+ * symmetric exchange: both peers call `exchange` with each other and each
+ * receives the message of the other. Implementations must not deadlock when
+ * both messages are large, so they send and receive at the same time.
+ */
+class Transport {
+public:
+    /// A message, as raw bytes.
+    using Message = std::vector<char>;
+
+    /**
+     * @brief Virtual destructor for Transport.
+     */
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Gets the index of the calling process.
+     *
+     * @return The rank, in `[0, getSize())`.
+     */
+    virtual int getRank() const = 0;
+
+    /**
+     * @brief Gets the number of processes.
+     *
+     * @return The number of processes of the simulation.
+     */
+    virtual int getSize() const = 0;
+
+    /**
+     * @brief Sends a message to a peer and receives its message.
+     *
+     * @param peer Rank of the peer, which must call `exchange` with this rank.
+     * @param message The message to send.
+     * @return The message sent by the peer.
+     * @throw std::runtime_error if the connection is lost.
+     */
+    virtual Message exchange(int peer, const Message& message) = 0;
+};
+
+/**
+ * @brief Transport between processes of the same host over Unix socket pairs.
+ *
+ * `spawn` creates one socket pair per pair of processes, then forks the
+ * processes: every process continues from the call with its own rank.
+ * Only available on POSIX systems.
+ */
+class SocketTransport : public Transport {
+public:
+    /**
+     * @brief Forks `size - 1` processes connected to the calling one.
+     *
+     * @param size Total number of processes, including the calling one (rank 0).
+     * @return The transport of the calling process, or of the forked process.
+     * @throw std::runtime_error if the sockets or the processes cannot be created.
+     */
+    static std::unique_ptr<SocketTransport> spawn(int size);
+
+    /**
+     * @brief Closes the sockets. Rank 0 also waits for the other processes to exit.
+     */
+    ~SocketTransport() override;
+
+    SocketTransport(const SocketTransport&) = delete;
+    SocketTransport& operator=(const SocketTransport&) = delete;
+
+    int getRank() const override;
+    int getSize() const override;
+    Message exchange(int peer, const Message& message) override;
+
+private:
+    int rank;                     ///< Rank of this process.
+    std::vector<int> sockets;     ///< Socket connected to each rank (-1 for this rank).
+    std::vector<int> children;    ///< Process ids of the forked processes (rank 0 only).
+
+    /**
+     * @brief Constructs the transport of one process.
+     *
+     * @param rank Rank of this process.
+     * @param sockets Socket connected to each rank.
+     */
+    SocketTransport(int rank, std::vector<int> sockets);
+};
+
+#endif // TRANSPORT_H
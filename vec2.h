@@ -1,17 +1,53 @@
 #ifndef VEC2_H
 #define VEC2_H
 
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include "fixed.h"
+
+/**
+ * @brief Computes the length of the vector `(x, y)` in single precision.
+ *
+ * @param x First component.
+ * @param y Second component.
+ * @return `sqrt(x² + y²)`.
+ */
+inline float scalarNorm(float x, float y){
+    return std::sqrt(x * x + y * y);
+}
+
+/**
+ * @brief Computes the length of the vector `(x, y)` in double precision.
+ *
+ * @param x First component.
+ * @param y Second component.
+ * @return `sqrt(x² + y²)`.
+ */
+inline double scalarNorm(double x, double y){
+    return std::sqrt(x * x + y * y);
+}
+
 /**
- * @brief Represents a 2D vector with floating-point components.
+ * @brief Represents a 2D vector with components of type `T`.
  *
- * The `Vec2` class provides basic vector operations, such as addition,
+ * The `Vec2T` class provides basic vector operations, such as addition,
  * subtraction, scalar multiplication, normalization, and dot product.
  * It is used in simulations for representing positions, velocities, forces, etc.
+ *
+ * The class is header-only and trivially copyable, so its operations inline
+ * and arrays of vectors can be moved with `memcpy` and vectorized. It is
+ * instantiated for `float` (`Vec2`, used by the simulation), `double`
+ * (`Vec2d`) and the deterministic fixed-point type `Fixed` (`Vec2x`).
+ *
+ * @tparam T The scalar type of the components.
  */
-class Vec2 {
+template <typename T>
+class Vec2T {
 private:
-    float x; ///< The x-coordinate of the vector.
-    float y; ///< The y-coordinate of the vector.
+    T x; ///< The x-coordinate of the vector.
+    T y; ///< The y-coordinate of the vector.
 
 public:
     /**
@@ -20,49 +56,35 @@ public:
      * @param x The x-coordinate of the vector.
      * @param y The y-coordinate of the vector.
      */
-    Vec2(float x, float y);
-
-    /**
-     * @brief Copy constructor for `Vec2`.
-     *
-     * Creates a new vector by copying the components of another vector.
-     *
-     * @param other The vector to copy.
-     */
-    Vec2(const Vec2& other);
-
-    /**
-     * @brief Default destructor for `Vec2`.
-     */
-    ~Vec2() = default;
+    constexpr Vec2T(T x, T y) : x(x), y(y) {}
 
     /**
      * @brief Gets the x-coordinate of the vector.
      *
      * @return The x-coordinate of the vector.
      */
-    float getx() const;
+    constexpr T getx() const { return x; }
 
     /**
      * @brief Sets the x-coordinate of the vector.
      *
      * @param newx The new value for the x-coordinate.
      */
-    void setx(float newx);
+    constexpr void setx(T newx) { x = newx; }
 
     /**
      * @brief Gets the y-coordinate of the vector.
      *
      * @return The y-coordinate of the vector.
      */
-    float gety() const;
+    constexpr T gety() const { return y; }
 
     /**
      * @brief Sets the y-coordinate of the vector.
      *
      * @param newy The new value for the y-coordinate.
      */
-    void sety(float newy);
+    constexpr void sety(T newy) { y = newy; }
 
     /**
      * @brief Adds another vector to this vector and returns the result.
@@ -70,7 +92,7 @@ public:
      * @param other The vector to add.
      * @return A new vector that is the sum of this vector and `other`.
      */
-    Vec2 operator+(const Vec2& other) const;
+    constexpr Vec2T operator+(const Vec2T& other) const { return Vec2T(x + other.x, y + other.y); }
 
     /**
      * @brief Subtracts another vector from this vector and returns the result.
@@ -78,7 +100,14 @@ public:
      * @param other The vector to subtract.
      * @return A new vector that is the difference between this vector and `other`.
      */
-    Vec2 operator-(const Vec2& other) const;
+    constexpr Vec2T operator-(const Vec2T& other) const { return Vec2T(x - other.x, y - other.y); }
+
+    /**
+     * @brief Negates the vector.
+     *
+     * @return A new vector pointing in the opposite direction.
+     */
+    constexpr Vec2T operator-() const { return Vec2T(-x, -y); }
 
     /**
      * @brief Multiplies this vector by a scalar and returns the result.
@@ -86,7 +115,7 @@ public:
      * @param scalar The scalar to multiply with.
      * @return A new vector that is this vector scaled by `scalar`.
      */
-    Vec2 operator*(float scalar) const;
+    constexpr Vec2T operator*(T scalar) const { return Vec2T(x * scalar, y * scalar); }
 
     /**
      * @brief Divides this vector by a scalar and returns the result.
@@ -95,15 +124,12 @@ public:
      * @return A new vector that is this vector scaled by `1/scalar`.
      * @throw std::runtime_error if `scalar` is zero.
      */
-    Vec2 operator/(float scalar) const;
-
-    /**
-     * @brief Assigns the values of another vector to this vector.
-     *
-     * @param other The vector to copy.
-     * @return A reference to this vector.
-     */
-    Vec2& operator=(const Vec2& other);
+    constexpr Vec2T operator/(T scalar) const {
+        if (scalar == T(0)){
+            throw std::runtime_error("Division par zéro !");
+        }
+        return Vec2T(x / scalar, y / scalar);
+    }
 
     /**
      * @brief Adds another vector to this vector in-place.
@@ -111,7 +137,11 @@ public:
      * @param other The vector to add.
      * @return A reference to this vector after addition.
      */
-    Vec2& operator+=(const Vec2& other);
+    constexpr Vec2T& operator+=(const Vec2T& other) {
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
 
     /**
      * @brief Compares this vector with another for equality.
@@ -119,14 +149,14 @@ public:
      * @param other The vector to compare with.
      * @return True if both vectors have the same components, false otherwise.
      */
-    bool operator==(const Vec2& other) const;
+    constexpr bool operator==(const Vec2T& other) const { return x == other.x && y == other.y; }
 
     /**
      * @brief Calculates the norm of the vector.
      *
      * @return The norm of the vector.
      */
-    float norm() const;
+    T norm() const { return scalarNorm(x, y); }
 
     /**
      * @brief Normalizes the vector (scales it to unit length).
@@ -134,7 +164,13 @@ public:
      * @return A new vector that is the normalized version of this vector.
      * @throw std::runtime_error if the vector has a norm of zero.
      */
-    Vec2 normalize() const;
+    Vec2T normalize() const {
+        T length = norm();
+        if (length > T(0)) {
+            return *this / length;
+        }
+        throw std::runtime_error("Normalisation d'un vecteur nul !");
+    }
 
     /**
      * @brief Computes the dot product of this vector with another.
@@ -142,14 +178,29 @@ public:
      * @param other The vector to compute the dot product with.
      * @return The dot product of this vector and `other`.
      */
-    float dot(const Vec2& other) const;
+    constexpr T dot(const Vec2T& other) const { return x * other.x + y * other.y; }
 
     /**
      * @brief Prints the components of the vector to the console.
      *
      * Used for debugging purposes.
      */
-    void print() const;
+    void print() const {
+        std::cout << "(" << x << ", " << y << ")" << std::endl;
+    }
 };
 
+/// Single-precision vector, used by the simulation.
+using Vec2 = Vec2T<float>;
+
+/// Double-precision vector.
+using Vec2d = Vec2T<double>;
+
+/// Fixed-point vector, bit-identical across compilers and CPUs.
+using Vec2x = Vec2T<Fixed>;
+
+static_assert(std::is_trivially_copyable_v<Vec2>, "Vec2 must stay trivially copyable");
+static_assert(std::is_trivially_copyable_v<Vec2d>, "Vec2d must stay trivially copyable");
+static_assert(std::is_trivially_copyable_v<Vec2x>, "Vec2x must stay trivially copyable");
+
 #endif // VEC2_H